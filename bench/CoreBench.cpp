@@ -0,0 +1,146 @@
+// Times the loader stages that run per face or per vertex on large models,
+// and PPM decoding, on synthetic inputs built in memory.
+
+#include "Suites.hpp"
+
+#include "ObjLoader.hpp"
+#include "TextureLoader.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+	using microbench::doNotOptimize;
+	using scop::Vec3;
+	using Positions = scop::TrackedVector<Vec3, scop::MemoryTag::Loader>;
+	namespace detail = scop::detail;
+
+	// A star in the z = 0 plane with alternating outer and inner radius, so
+	// every other corner is reflex and ear clipping has to search.
+	detail::Face makeStar(std::size_t corners, Positions &positions)
+	{
+		detail::Face face;
+		const std::size_t first = positions.size();
+		for (std::size_t i = 0; i < corners; ++i)
+		{
+			const float angle = static_cast<float>(i) / static_cast<float>(corners) * 6.2831853f;
+			const float radius = (i % 2U == 0U) ? 1.0f : 0.55f;
+			positions.push_back(Vec3(radius * std::cos(angle), radius * std::sin(angle), 0.0f));
+			face.vertices.push_back({static_cast<int>(first + i), -1, -1});
+		}
+		return face;
+	}
+
+	std::string makePpm(const char *magic, std::size_t width, std::size_t height)
+	{
+		std::ostringstream out;
+		out << magic << "\n# generated\n" << width << ' ' << height << "\n255\n";
+		const bool binary = std::string(magic) == "P6";
+		for (std::size_t i = 0; i < width * height * 3U; ++i)
+		{
+			const unsigned int value = static_cast<unsigned int>((i * 37U) & 0xFFU);
+			if (binary)
+			{
+				out.put(static_cast<char>(value));
+			}
+			else
+			{
+				out << value << ((i % 12U == 11U) ? '\n' : ' ');
+			}
+		}
+		return out.str();
+	}
+
+} // namespace
+
+bool runCoreBench(microbench::Harness &harness)
+{
+	const detail::IndexTriplet parsed = detail::parseFaceToken("-1/2/3", 10, 10, 10);
+	if (parsed.v != 9 || parsed.vt != 1 || parsed.vn != 2)
+	{
+		std::fprintf(stderr, "parseFaceToken returned %d/%d/%d for -1/2/3\n", parsed.v, parsed.vt, parsed.vn);
+		return false;
+	}
+
+	const std::vector<std::string> tokens = {"1", "12/7", "123//45", "1234/567/89", "-3/-2/-1"};
+	harness.run("obj.parse_face_token", tokens.size(), [&tokens]()
+	{
+		for (const std::string &token : tokens)
+		{
+			const detail::IndexTriplet triplet = detail::parseFaceToken(token, 5000, 5000, 5000);
+			doNotOptimize(triplet);
+		}
+	});
+
+	for (std::size_t corners : {4U, 8U, 16U, 64U})
+	{
+		Positions positions;
+		const detail::Face face = makeStar(corners, positions);
+		const std::vector<detail::Triangle> triangles = detail::triangulateFace(face, positions);
+		if (triangles.size() != corners - 2U)
+		{
+			std::fprintf(stderr, "triangulateFace made %zu triangles for %zu corners\n", triangles.size(), corners);
+			return false;
+		}
+		const std::string suffix = ".n" + std::to_string(corners);
+		harness.run("obj.compute_face_normal" + suffix, 1U, [&face, &positions]()
+		{
+			const Vec3 normal = detail::computeFaceNormal(face, positions);
+			doNotOptimize(normal);
+		});
+		harness.run("obj.triangulate_face" + suffix, 1U, [&face, &positions]()
+		{
+			const std::vector<detail::Triangle> result = detail::triangulateFace(face, positions);
+			doNotOptimize(result);
+		});
+	}
+
+	constexpr std::size_t kUvVertices = 4096U;
+	scop::Bounds bounds;
+	bounds.min = Vec3(-1.0f, -2.0f, -3.0f);
+	bounds.max = Vec3(1.0f, 2.0f, 3.0f);
+	std::vector<Vec3> uvPositions(kUvVertices);
+	std::vector<Vec3> uvNormals(kUvVertices);
+	for (std::size_t i = 0; i < kUvVertices; ++i)
+	{
+		const float t = static_cast<float>(i) * 0.37f;
+		uvPositions[i] = Vec3(std::sin(t), 2.0f * std::cos(t * 1.3f), 3.0f * std::sin(t * 0.7f));
+		uvNormals[i] = scop::normalize(Vec3(std::cos(t * 2.1f), std::sin(t * 1.7f), std::cos(t * 0.9f)));
+	}
+	std::vector<scop::Vec2> uvs(kUvVertices);
+	harness.run("obj.generate_box_uv", kUvVertices, [&]()
+	{
+		for (std::size_t i = 0; i < kUvVertices; ++i)
+		{
+			uvs[i] = detail::generateBoxUV(uvPositions[i], uvNormals[i], bounds);
+		}
+		doNotOptimize(uvs);
+	});
+
+	// Pixels per operation, so both encodings read as ns per pixel.
+	constexpr std::size_t kPpmSize = 256U;
+	for (const char *magic : {"P6", "P3"})
+	{
+		const std::string data = makePpm(magic, kPpmSize, kPpmSize);
+		std::istringstream check(data);
+		const scop::TextureImage image = scop::TextureLoader::decodePPM(check, magic);
+		if (image.width != kPpmSize || image.height != kPpmSize || image.pixels[4] != 37U * 3U || image.pixels[7] != 255U)
+		{
+			std::fprintf(stderr, "%s decode returned unexpected pixels\n", magic);
+			return false;
+		}
+		harness.run(std::string("texture.decode_ppm.") + (magic[1] == '6' ? "p6" : "p3"), kPpmSize * kPpmSize,
+					[&data, magic]()
+		{
+			std::istringstream stream(data);
+			const scop::TextureImage decoded = scop::TextureLoader::decodePPM(stream, magic);
+			doNotOptimize(decoded);
+		});
+	}
+	return true;
+}
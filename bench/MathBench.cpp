@@ -0,0 +1,358 @@
+// Times the header-only math against out-of-line scalar copies of the
+// previous Math.cpp, on the two paths that use it most: face normals in the
+// OBJ loader and the per-frame matrix setup. Then checks every instruction
+// set of the MathBatch kernels against Math.hpp and times each of them.
+
+#include "Suites.hpp"
+
+#include "Math.hpp"
+#include "MathBatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+	using scop::Mat4;
+	using scop::Vec3;
+	using scop::Vec3Array;
+	using microbench::doNotOptimize;
+	namespace MathBatch = scop::MathBatch;
+
+	// What every call cost before: one real call per operator, and a
+	// scalar triple loop for the matrix product.
+	namespace reference
+	{
+
+		[[gnu::noinline]] Vec3 subtract(const Vec3 &lhs, const Vec3 &rhs)
+		{
+			return Vec3(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z);
+		}
+
+		[[gnu::noinline]] Vec3 cross(const Vec3 &lhs, const Vec3 &rhs)
+		{
+			return Vec3(lhs.y * rhs.z - lhs.z * rhs.y, lhs.z * rhs.x - lhs.x * rhs.z, lhs.x * rhs.y - lhs.y * rhs.x);
+		}
+
+		[[gnu::noinline]] Vec3 normalize(const Vec3 &v)
+		{
+			const float len = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+			if (len <= 1e-8f)
+			{
+				return Vec3(0.0f, 0.0f, 0.0f);
+			}
+			return Vec3(v.x / len, v.y / len, v.z / len);
+		}
+
+		[[gnu::noinline]] Mat4 multiply(const Mat4 &lhs, const Mat4 &rhs)
+		{
+			Mat4 result;
+			for (std::size_t row = 0; row < 4; ++row)
+			{
+				for (std::size_t col = 0; col < 4; ++col)
+				{
+					float sum = 0.0f;
+					for (std::size_t i = 0; i < 4; ++i)
+					{
+						sum += lhs(row, i) * rhs(i, col);
+					}
+					result(row, col) = sum;
+				}
+			}
+			return result;
+		}
+
+	} // namespace reference
+
+	bool close(const Mat4 &lhs, const Mat4 &rhs)
+	{
+		for (std::size_t i = 0; i < 16; ++i)
+		{
+			if (std::fabs(lhs.m[i] - rhs.m[i]) > 1e-4f * std::max(1.0f, std::fabs(rhs.m[i])))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool same(float lhs, float rhs)
+	{
+		return std::memcmp(&lhs, &rhs, sizeof(float)) == 0;
+	}
+
+	bool same(const Vec3Array &array, std::size_t index, const Vec3 &expected)
+	{
+		const Vec3 value = array.get(index);
+		return same(value.x, expected.x) && same(value.y, expected.y) && same(value.z, expected.z);
+	}
+
+	// Runs every kernel with the given instruction set and compares each
+	// element with the per-element function it replaces. Odd counts keep
+	// the scalar tails covered.
+	bool checkBatch(MathBatch::Isa isa, const Mat4 &transform, const scop::Frustum &frustum,
+					const Vec3Array &points, const Vec3Array &extents, const std::vector<float> &radii)
+	{
+		MathBatch::setIsa(isa);
+		const std::size_t count = points.size();
+		Vec3Array out;
+		out.resize(count);
+		MathBatch::transformPoints(transform, points.streams(), out.streams(), count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (!same(out, i, scop::transformPoint(transform, points.get(i))))
+			{
+				std::fprintf(stderr, "%s transformPoints differs at %zu\n", MathBatch::isaName(isa), i);
+				return false;
+			}
+		}
+
+		Vec3Array low;
+		Vec3Array high;
+		low.resize(count);
+		high.resize(count);
+		MathBatch::transformAabbs(transform, points.streams(), extents.streams(), low.streams(), high.streams(), count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const Vec3 center = scop::transformPoint(transform, points.get(i));
+			const Vec3 extent = extents.get(i);
+			Vec3 width;
+			for (std::size_t row = 0; row < 3; ++row)
+			{
+				float sum = 0.0f;
+				for (std::size_t col = 0; col < 3; ++col)
+				{
+					sum += std::fabs(transform(row, col)) * (col == 0 ? extent.x : col == 1 ? extent.y : extent.z);
+				}
+				(row == 0 ? width.x : row == 1 ? width.y : width.z) = sum;
+			}
+			if (!same(low, i, center - width) || !same(high, i, center + width))
+			{
+				std::fprintf(stderr, "%s transformAabbs differs at %zu\n", MathBatch::isaName(isa), i);
+				return false;
+			}
+		}
+
+		std::vector<std::uint8_t> inside(count, 2U);
+		std::size_t expectedInside = 0U;
+		const std::size_t reported = MathBatch::spheresInFrustum(frustum, points.streams(), radii.data(), count, inside.data());
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const bool expected = scop::sphereInFrustum(frustum, points.get(i), radii[i]);
+			expectedInside += expected ? 1U : 0U;
+			if (inside[i] != (expected ? 1U : 0U))
+			{
+				std::fprintf(stderr, "%s spheresInFrustum differs at %zu\n", MathBatch::isaName(isa), i);
+				return false;
+			}
+		}
+		if (reported != expectedInside)
+		{
+			std::fprintf(stderr, "%s spheresInFrustum counted %zu, expected %zu\n",
+						 MathBatch::isaName(isa), reported, expectedInside);
+			return false;
+		}
+
+		Vec3Array normalized = points;
+		normalized.set(count / 3U, Vec3(0.0f, 0.0f, 0.0f));
+		MathBatch::normalize(normalized.streams(), count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const Vec3 source = i == count / 3U ? Vec3(0.0f, 0.0f, 0.0f) : points.get(i);
+			if (!same(normalized, i, scop::normalize(source)))
+			{
+				std::fprintf(stderr, "%s normalize differs at %zu\n", MathBatch::isaName(isa), i);
+				return false;
+			}
+		}
+		return true;
+	}
+
+} // namespace
+
+bool runMathBench(microbench::Harness &harness)
+{
+	constexpr std::size_t kTriangles = 1U << 16;
+	constexpr std::size_t kInstances = 4096U;
+
+	static_assert((Mat4::translation(Vec3(1.0f, 2.0f, 3.0f)) * Mat4::scale(Vec3(2.0f, 2.0f, 2.0f)))(1, 3) == 2.0f,
+				  "Mat4 products must stay usable in constant expressions");
+
+	std::srand(42);
+	const auto random = []()
+	{
+		return static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * 2.0f - 1.0f;
+	};
+
+	std::vector<Vec3> positions(kTriangles * 3U);
+	for (Vec3 &position : positions)
+	{
+		position = Vec3(random(), random(), random());
+	}
+	std::vector<Vec3> normals(kTriangles);
+
+	const Mat4 viewProjection = Mat4::perspective(0.785f, 16.0f / 9.0f, 0.1f, 100.0f) *
+								Mat4::lookAt(Vec3(0.0f, 6.0f, 10.0f), Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f));
+	std::vector<Mat4> models(kInstances);
+	for (std::size_t i = 0; i < kInstances; ++i)
+	{
+		models[i] = Mat4::translation(Vec3(random() * 20.0f, 0.0f, random() * 20.0f)) * Mat4::rotationY(random() * 3.14f);
+	}
+	std::vector<Mat4> mvps(kInstances);
+
+	for (std::size_t i = 0; i < kInstances; ++i)
+	{
+		if (!close(viewProjection * models[i], reference::multiply(viewProjection, models[i])))
+		{
+			std::fprintf(stderr, "Mat4 product differs from the scalar reference\n");
+			return false;
+		}
+	}
+
+	harness.run("math.face_normals.reference", kTriangles, [&]()
+	{
+		for (std::size_t i = 0; i < kTriangles; ++i)
+		{
+			const Vec3 &a = positions[i * 3U];
+			normals[i] = reference::normalize(reference::cross(reference::subtract(positions[i * 3U + 1U], a),
+															   reference::subtract(positions[i * 3U + 2U], a)));
+		}
+		doNotOptimize(normals);
+	});
+	harness.run("math.face_normals", kTriangles, [&]()
+	{
+		for (std::size_t i = 0; i < kTriangles; ++i)
+		{
+			const Vec3 &a = positions[i * 3U];
+			normals[i] = scop::normalize(scop::cross(positions[i * 3U + 1U] - a, positions[i * 3U + 2U] - a));
+		}
+		doNotOptimize(normals);
+	});
+	harness.run("math.cross", kTriangles, [&]()
+	{
+		for (std::size_t i = 0; i < kTriangles; ++i)
+		{
+			normals[i] = scop::cross(positions[i * 3U], positions[i * 3U + 1U]);
+		}
+		doNotOptimize(normals);
+	});
+	harness.run("math.normalize", kTriangles, [&]()
+	{
+		for (std::size_t i = 0; i < kTriangles; ++i)
+		{
+			normals[i] = scop::normalize(positions[i * 3U]);
+		}
+		doNotOptimize(normals);
+	});
+
+	harness.run("math.mat4_multiply.reference", kInstances, [&]()
+	{
+		for (std::size_t i = 0; i < kInstances; ++i)
+		{
+			mvps[i] = reference::multiply(viewProjection, models[i]);
+		}
+		doNotOptimize(mvps);
+	});
+	harness.run("math.mat4_multiply", kInstances, [&]()
+	{
+		for (std::size_t i = 0; i < kInstances; ++i)
+		{
+			mvps[i] = viewProjection * models[i];
+		}
+		doNotOptimize(mvps);
+	});
+
+	// updateFrameData: translation * rotation, then the mvp and the normal
+	// matrix pushed with every frame.
+	harness.run("math.frame_push_constants.reference", kInstances, [&]()
+	{
+		for (std::size_t i = 0; i < kInstances; ++i)
+		{
+			const Mat4 model = reference::multiply(Mat4::translation(Vec3(0.1f, 0.2f, 0.3f)), Mat4::rotationY(static_cast<float>(i) * 0.01f));
+			mvps[i] = reference::multiply(viewProjection, model);
+			mvps[i].m[3] += scop::normalMatrix(model).m[0];
+		}
+		doNotOptimize(mvps);
+	});
+	harness.run("math.frame_push_constants", kInstances, [&]()
+	{
+		for (std::size_t i = 0; i < kInstances; ++i)
+		{
+			const Mat4 model = Mat4::translation(Vec3(0.1f, 0.2f, 0.3f)) * Mat4::rotationY(static_cast<float>(i) * 0.01f);
+			mvps[i] = viewProjection * model;
+			mvps[i].m[3] += scop::normalMatrix(model).m[0];
+		}
+		doNotOptimize(mvps);
+	});
+
+	// Batch kernels over the instance field's culling input.
+	constexpr std::size_t kPoints = 1U << 16;
+	const scop::Frustum frustum = scop::frustumPlanes(viewProjection);
+	const Mat4 &transform = models[1];
+	Vec3Array points;
+	Vec3Array extents;
+	std::vector<float> radii(kPoints);
+	points.resize(kPoints);
+	extents.resize(kPoints);
+	for (std::size_t i = 0; i < kPoints; ++i)
+	{
+		points.set(i, Vec3(random() * 30.0f, random() * 5.0f, random() * 30.0f));
+		extents.set(i, Vec3(std::fabs(random()), std::fabs(random()), std::fabs(random())));
+		radii[i] = std::fabs(random()) * 2.0f;
+	}
+	std::vector<MathBatch::Isa> isas;
+	for (MathBatch::Isa isa : {MathBatch::Isa::Scalar, MathBatch::Isa::Sse4, MathBatch::Isa::Avx2})
+	{
+		if (MathBatch::setIsa(isa) != isa)
+		{
+			std::fprintf(stderr, "%s is not supported by this CPU, skipped\n", MathBatch::isaName(isa));
+			continue;
+		}
+		Vec3Array subset;
+		subset.resize(1021U);
+		for (std::size_t i = 0; i < subset.size(); ++i)
+		{
+			subset.set(i, points.get(i));
+		}
+		if (!checkBatch(isa, transform, frustum, points, extents, radii) ||
+			!checkBatch(isa, transform, frustum, subset, extents, radii))
+		{
+			return false;
+		}
+		isas.push_back(isa);
+	}
+
+	const Vec3Array &input = points;
+	Vec3Array out;
+	out.resize(kPoints);
+	std::vector<std::uint8_t> inside(kPoints);
+	for (MathBatch::Isa isa : isas)
+	{
+		MathBatch::setIsa(isa);
+		const std::string suffix = std::string(".") + MathBatch::isaName(isa);
+		harness.run("batch.transform_points" + suffix, kPoints, [&]()
+		{
+			MathBatch::transformPoints(transform, input.streams(), out.streams(), kPoints);
+			doNotOptimize(out);
+		});
+		harness.run("batch.spheres_in_frustum" + suffix, kPoints, [&]()
+		{
+			const std::size_t count = MathBatch::spheresInFrustum(frustum, input.streams(), radii.data(), kPoints, inside.data());
+			doNotOptimize(count);
+		});
+		harness.run("batch.normalize" + suffix, kPoints, [&]()
+		{
+			MathBatch::transformPoints(Mat4::identity(), input.streams(), out.streams(), kPoints);
+			MathBatch::normalize(out.streams(), kPoints);
+			doNotOptimize(out);
+		});
+	}
+	MathBatch::setIsa(MathBatch::bestIsa());
+	return true;
+}
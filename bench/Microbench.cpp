@@ -0,0 +1,136 @@
+#include "Microbench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace microbench
+{
+
+	namespace
+	{
+
+		double median(std::vector<double> values)
+		{
+			if (values.empty())
+			{
+				return 0.0;
+			}
+			const std::size_t middle = values.size() / 2U;
+			std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(middle), values.end());
+			const double upper = values[middle];
+			if (values.size() % 2U != 0U)
+			{
+				return upper;
+			}
+			const double lower = *std::max_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(middle));
+			return (lower + upper) * 0.5;
+		}
+
+		std::string escapeJson(const std::string &text)
+		{
+			std::string escaped;
+			for (char ch : text)
+			{
+				if (ch == '"' || ch == '\\')
+				{
+					escaped.push_back('\\');
+				}
+				escaped.push_back(ch);
+			}
+			return escaped;
+		}
+
+	} // namespace
+
+	Harness::Harness(std::size_t warmups, std::size_t samples, std::string filter)
+		: warmups_(std::max<std::size_t>(warmups, 1U)),
+		  samples_(std::max<std::size_t>(samples, 1U)),
+		  filter_(std::move(filter))
+	{
+	}
+
+	bool Harness::selected(const std::string &name) const
+	{
+		return filter_.empty() || name.find(filter_) != std::string::npos;
+	}
+
+	const Result *Harness::find(const std::string &name) const
+	{
+		for (const Result &result : results_)
+		{
+			if (result.name == name)
+			{
+				return &result;
+			}
+		}
+		return nullptr;
+	}
+
+	const Result &Harness::add(const std::string &name, std::size_t operations, std::size_t batch, std::vector<double> perOp)
+	{
+		Result result;
+		result.name = name;
+		result.operations = operations;
+		result.batch = batch;
+		result.samples = perOp.size();
+		result.medianNs = median(perOp);
+		result.minNs = *std::min_element(perOp.begin(), perOp.end());
+		for (double &sample : perOp)
+		{
+			sample = std::fabs(sample - result.medianNs);
+		}
+		result.madNs = median(perOp);
+		results_.push_back(result);
+		return results_.back();
+	}
+
+	void Harness::printTable(std::ostream &out) const
+	{
+		std::size_t width = 4U;
+		for (const Result &result : results_)
+		{
+			width = std::max(width, result.name.size());
+		}
+		out << std::left << std::setw(static_cast<int>(width)) << "name" << std::right
+			<< std::setw(14) << "median ns/op" << std::setw(12) << "MAD" << std::setw(8) << "MAD %" << '\n';
+		out << std::fixed;
+		for (const Result &result : results_)
+		{
+			const double madPercent = result.medianNs > 0.0 ? result.madNs / result.medianNs * 100.0 : 0.0;
+			out << std::left << std::setw(static_cast<int>(width)) << result.name << std::right
+				<< std::setprecision(3) << std::setw(14) << result.medianNs << std::setw(12) << result.madNs
+				<< std::setprecision(1) << std::setw(8) << madPercent << '\n';
+		}
+		out << std::defaultfloat;
+	}
+
+	void Harness::writeJson(std::ostream &out, const std::vector<std::pair<std::string, std::string>> &info) const
+	{
+		out << "{\n";
+		for (const std::pair<std::string, std::string> &entry : info)
+		{
+			out << "  \"" << escapeJson(entry.first) << "\": \"" << escapeJson(entry.second) << "\",\n";
+		}
+		out << "  \"warmups\": " << warmups_ << ",\n"
+			<< "  \"samples\": " << samples_ << ",\n"
+			<< "  \"unit\": \"ns/op\",\n"
+			<< "  \"results\": [";
+		out << std::fixed << std::setprecision(4);
+		for (std::size_t i = 0; i < results_.size(); ++i)
+		{
+			const Result &result = results_[i];
+			out << (i == 0 ? "\n" : ",\n")
+				<< "    {\"name\": \"" << escapeJson(result.name) << "\""
+				<< ", \"median\": " << result.medianNs
+				<< ", \"mad\": " << result.madNs
+				<< ", \"min\": " << result.minNs
+				<< ", \"operations\": " << result.operations
+				<< ", \"batch\": " << result.batch
+				<< ", \"samples\": " << result.samples << "}";
+		}
+		out << "\n  ]\n}\n";
+		out << std::defaultfloat;
+	}
+
+} // namespace microbench
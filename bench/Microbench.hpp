@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace microbench
+{
+
+	struct Result
+	{
+		std::string name;
+		// Operations per call of the body, and calls per timed sample.
+		std::size_t operations;
+		std::size_t batch;
+		std::size_t samples;
+		double medianNs;
+		// Median absolute deviation from the median.
+		double madNs;
+		double minNs;
+	};
+
+	// Keeps a value alive without letting the compiler drop the work that
+	// produced it.
+	template <typename T>
+	inline void doNotOptimize(const T &value)
+	{
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+
+	// Times a body that performs `operations` operations per call. Warm-up
+	// calls run first and size a batch so one sample lasts at least
+	// kMinSampleNs; each sample is then the mean time per operation over a
+	// batch. Results report the median and MAD of the samples in ns/op.
+	class Harness
+	{
+	public:
+		static constexpr double kMinSampleNs = 200000.0;
+
+		Harness(std::size_t warmups, std::size_t samples, std::string filter);
+
+		bool selected(const std::string &name) const;
+
+		// Returns nullptr when the filter skips name.
+		template <typename Body>
+		const Result *run(const std::string &name, std::size_t operations, Body &&body)
+		{
+			if (!selected(name))
+			{
+				return nullptr;
+			}
+			double warmupNs = 0.0;
+			for (std::size_t i = 0; i < warmups_; ++i)
+			{
+				warmupNs = elapsedNs([&body]() { body(); });
+			}
+			const std::size_t batch = warmupNs >= kMinSampleNs || warmupNs <= 0.0
+										  ? 1U
+										  : static_cast<std::size_t>(kMinSampleNs / warmupNs) + 1U;
+			std::vector<double> perOp(samples_);
+			for (double &sample : perOp)
+			{
+				const double ns = elapsedNs([&body, batch]()
+				{
+					for (std::size_t call = 0; call < batch; ++call)
+					{
+						body();
+					}
+				});
+				sample = ns / static_cast<double>(batch * operations);
+			}
+			return &add(name, operations, batch, std::move(perOp));
+		}
+
+		const std::vector<Result> &results() const { return results_; }
+		const Result *find(const std::string &name) const;
+
+		void printTable(std::ostream &out) const;
+		void writeJson(std::ostream &out, const std::vector<std::pair<std::string, std::string>> &info) const;
+
+	private:
+		template <typename Body>
+		static double elapsedNs(Body &&body)
+		{
+			const auto begin = std::chrono::steady_clock::now();
+			body();
+			return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+		}
+
+		const Result &add(const std::string &name, std::size_t operations, std::size_t batch, std::vector<double> perOp);
+
+		std::size_t warmups_;
+		std::size_t samples_;
+		std::string filter_;
+		std::vector<Result> results_;
+	};
+
+} // namespace microbench
@@ -0,0 +1,53 @@
+// Times an empty SCOP_PROFILE_ZONE with the profiler disabled and enabled.
+// Profiler::enable() cannot be undone, so this suite runs last.
+
+#include "Suites.hpp"
+
+#include "Profiler.hpp"
+
+#include <cstdio>
+
+namespace
+{
+
+	using microbench::doNotOptimize;
+
+	// Zones per call, so the loop around the body stays out of the result.
+	constexpr std::size_t kZones = 64U;
+
+	void openZones(std::size_t &counter)
+	{
+		for (std::size_t i = 0; i < kZones; ++i)
+		{
+			SCOP_PROFILE_ZONE("microbench.zone");
+			++counter;
+			doNotOptimize(counter);
+		}
+	}
+
+} // namespace
+
+bool runProfilerBench(microbench::Harness &harness)
+{
+	if (scop::Profiler::enabled())
+	{
+		std::fprintf(stderr, "profiler.zone: the profiler was enabled before its disabled run\n");
+		return false;
+	}
+	std::size_t counter = 0U;
+	const microbench::Result *disabled = harness.run("profiler.zone.disabled", kZones, [&counter]()
+	{
+		openZones(counter);
+	});
+
+	scop::Profiler::enable();
+	const microbench::Result *enabled = harness.run("profiler.zone.enabled", kZones, [&counter]()
+	{
+		openZones(counter);
+	});
+	if (disabled != nullptr && enabled != nullptr)
+	{
+		std::printf("profiler.zone: %.1f ns per recorded zone over a disabled one\n", enabled->medianNs - disabled->medianNs);
+	}
+	return true;
+}
@@ -0,0 +1,132 @@
+// Renders a textured UV sphere with the software rasterizer at each thread
+// count, checks that every count produces the same image, and reports the
+// frame throughput in triangles.
+
+#include "Suites.hpp"
+
+#include "SoftwareRasterizer.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+	using microbench::doNotOptimize;
+	using scop::Mat4;
+	using scop::Vec2;
+	using scop::Vec3;
+
+	constexpr uint32_t kWidth = 1280U;
+	constexpr uint32_t kHeight = 720U;
+	// 2 * 128 * 256 = 65536 triangles.
+	constexpr std::size_t kStacks = 128U;
+	constexpr std::size_t kSlices = 256U;
+
+	void makeSphere(std::vector<scop::Vertex> &vertices, std::vector<uint32_t> &indices)
+	{
+		for (std::size_t stack = 0; stack <= kStacks; ++stack)
+		{
+			const float v = static_cast<float>(stack) / static_cast<float>(kStacks);
+			const float phi = v * 3.14159265f;
+			for (std::size_t slice = 0; slice <= kSlices; ++slice)
+			{
+				const float u = static_cast<float>(slice) / static_cast<float>(kSlices);
+				const float theta = u * 6.2831853f;
+				const Vec3 normal(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+				vertices.push_back({normal * 0.9f, Vec3(1.0f, 1.0f, 1.0f), Vec2(u * 4.0f, v * 2.0f), normal});
+			}
+		}
+		for (std::size_t stack = 0; stack < kStacks; ++stack)
+		{
+			for (std::size_t slice = 0; slice < kSlices; ++slice)
+			{
+				const uint32_t a = static_cast<uint32_t>(stack * (kSlices + 1U) + slice);
+				const uint32_t b = a + static_cast<uint32_t>(kSlices + 1U);
+				indices.insert(indices.end(), {a, b, a + 1U, a + 1U, b, b + 1U});
+			}
+		}
+	}
+
+} // namespace
+
+bool runRasterBench(microbench::Harness &harness)
+{
+	std::vector<scop::Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeSphere(vertices, indices);
+	const scop::RasterMesh mesh{vertices.data(), vertices.size(), indices.data(), indices.size()};
+	const std::size_t triangles = indices.size() / 3U;
+
+	// The viewer's default framing of a unit-sized model, slightly turned.
+	const Mat4 model = Mat4::rotationY(0.6f);
+	Mat4 projection = Mat4::perspective(45.0f, static_cast<float>(kWidth) / static_cast<float>(kHeight), 0.1f, 100.0f);
+	projection(1, 1) *= -1.0f;
+	scop::RasterUniforms uniforms;
+	uniforms.mvp = projection * Mat4::translation(Vec3(0.0f, 0.0f, -3.0f)) * model;
+	uniforms.normalMatrix = scop::normalMatrix(model);
+	uniforms.blend = 1.0f;
+	uniforms.textured = true;
+	uniforms.material = true;
+	uniforms.kd = Vec3(0.64f, 0.64f, 0.64f);
+	uniforms.ks = Vec3(0.5f, 0.5f, 0.5f);
+	uniforms.ns = 96.0f;
+	const scop::TextureImage texture = scop::TextureLoader::makeFallbackCheckerboard();
+
+	std::vector<std::size_t> threadCounts = {1U, 2U, 4U, std::max<std::size_t>(std::thread::hardware_concurrency(), 1U)};
+	std::sort(threadCounts.begin(), threadCounts.end());
+	threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+	std::vector<std::uint8_t> reference;
+	for (std::size_t threads : threadCounts)
+	{
+		// The caller is the last thread, as in the viewer.
+		std::unique_ptr<scop::ThreadPool> pool;
+		if (threads > 1U)
+		{
+			pool = std::make_unique<scop::ThreadPool>(threads - 1U);
+		}
+		scop::SoftwareRasterizer rasterizer(pool.get());
+		rasterizer.resize(kWidth, kHeight, false);
+		rasterizer.setTexture(texture);
+		rasterizer.render(mesh, uniforms);
+
+		const std::vector<std::uint8_t> &pixels = rasterizer.pixels();
+		const std::uint8_t *corner = pixels.data();
+		const std::uint8_t *centre = pixels.data() + (static_cast<std::size_t>(kHeight / 2U) * kWidth + kWidth / 2U) * 4U;
+		if (corner[0] != 15U || corner[1] != 15U || corner[2] != 20U || (centre[0] == 15U && centre[2] == 20U))
+		{
+			std::fprintf(stderr, "raster.frame.t%zu: expected the clear colour in the corner and the sphere in the centre\n", threads);
+			return false;
+		}
+		if (reference.empty())
+		{
+			reference = pixels;
+		}
+		else if (pixels != reference)
+		{
+			std::fprintf(stderr, "raster.frame.t%zu: image differs from the single-threaded one\n", threads);
+			return false;
+		}
+
+		const microbench::Result *result = harness.run("raster.frame.t" + std::to_string(threads), triangles, [&rasterizer, &mesh, &uniforms]()
+		{
+			rasterizer.render(mesh, uniforms);
+			doNotOptimize(rasterizer.pixels().data());
+		});
+		if (result != nullptr && result->medianNs > 0.0)
+		{
+			const scop::RasterStats &stats = rasterizer.stats();
+			std::printf("raster.frame.t%zu: %.1f Mtri/s, %.2f ms/frame (vertex %.2f, bin %.2f, raster %.2f) at %ux%u\n", threads,
+						1000.0 / result->medianNs, result->medianNs * static_cast<double>(triangles) / 1.0e6, stats.vertexMs,
+						stats.binMs, stats.rasterMs, kWidth, kHeight);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Microbench.hpp"
+
+// Each suite checks its kernels against a reference before timing them and
+// returns false when a check fails.
+bool runMathBench(microbench::Harness &harness);
+bool runCoreBench(microbench::Harness &harness);
+bool runRasterBench(microbench::Harness &harness);
+bool runProfilerBench(microbench::Harness &harness);
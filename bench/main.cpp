@@ -0,0 +1,94 @@
+// Standalone microbenchmarks of the math, loader and software raster hot
+// paths.
+//
+//   microbench [--filter TEXT] [--warmups N] [--samples N]
+//              [--json PATH] [--commit ID]
+//
+// Prints a table of median and MAD per benchmark, the speedup of every
+// "<name>" entry over its "<name>.reference", and writes the results as
+// JSON when --json is given.
+
+#include "Suites.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+	std::string filter;
+	std::string jsonPath;
+	std::string commit;
+	std::size_t warmups = 3U;
+	std::size_t samples = 21U;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Usage: " << argv[0] << " [--filter TEXT] [--warmups N] [--samples N] [--json PATH] [--commit ID]\n";
+			return 2;
+		}
+		const std::string value = argv[++i];
+		if (arg == "--filter")
+			filter = value;
+		else if (arg == "--json")
+			jsonPath = value;
+		else if (arg == "--commit")
+			commit = value;
+		else if (arg == "--warmups")
+			warmups = static_cast<std::size_t>(std::strtoul(value.c_str(), nullptr, 10));
+		else if (arg == "--samples")
+			samples = static_cast<std::size_t>(std::strtoul(value.c_str(), nullptr, 10));
+		else
+		{
+			std::cerr << "Unknown option: " << arg << '\n';
+			return 2;
+		}
+	}
+
+	microbench::Harness harness(warmups, samples, filter);
+	if (!runMathBench(harness) || !runCoreBench(harness) || !runRasterBench(harness) || !runProfilerBench(harness))
+	{
+		return 1;
+	}
+
+	harness.printTable(std::cout);
+	const std::string referenceSuffix = ".reference";
+	for (const microbench::Result &reference : harness.results())
+	{
+		if (reference.name.size() <= referenceSuffix.size() ||
+			reference.name.compare(reference.name.size() - referenceSuffix.size(), referenceSuffix.size(), referenceSuffix) != 0)
+		{
+			continue;
+		}
+		const std::string name = reference.name.substr(0, reference.name.size() - referenceSuffix.size());
+		const microbench::Result *current = harness.find(name);
+		if (current != nullptr && current->medianNs > 0.0)
+		{
+			std::printf("%s: %.2fx faster than the reference\n", name.c_str(), reference.medianNs / current->medianNs);
+		}
+	}
+
+	if (!jsonPath.empty())
+	{
+		std::ofstream out(jsonPath.c_str());
+		if (!out)
+		{
+			std::cerr << "Failed to write " << jsonPath << '\n';
+			return 1;
+		}
+		std::vector<std::pair<std::string, std::string>> info = {{"compiler", __VERSION__}};
+		if (!commit.empty())
+		{
+			info.insert(info.begin(), {"commit", commit});
+		}
+		harness.writeJson(out, info);
+		std::cout << "Results written to " << jsonPath << '\n';
+	}
+	return 0;
+}
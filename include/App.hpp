@@ -4,15 +4,30 @@
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
+#include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include "AppOptions.hpp"
+#include "Benchmark.hpp"
+#include "EmbeddedShaders.hpp"
+#include "GpuAllocator.hpp"
+#include "GpuProfiler.hpp"
+#include "IdleMonitor.hpp"
+#include "LatencyTracker.hpp"
 #include "Math.hpp"
-#include "Mesh.hpp"
+#include "MathBatch.hpp"
+#include "PipelineCache.hpp"
+#include "SceneGeometry.hpp"
+#include "SceneLoader.hpp"
+#include "Simulation.hpp"
 #include "TextureLoader.hpp"
+#include "ThreadPool.hpp"
+#include "UploadBatcher.hpp"
 
 namespace scop
 {
@@ -21,6 +36,7 @@ namespace scop
 	{
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		std::optional<uint32_t> transferFamily;
 
 		bool isComplete() const
 		{
@@ -28,6 +44,50 @@ namespace scop
 		}
 	};
 
+	// Vertex-stage push constants; the whole block is 128 bytes, the minimum
+	// maxPushConstantsSize every implementation guarantees.
+	struct MeshPushConstants
+	{
+		Mat4 mvp;
+		Mat4 normalMatrix;
+	};
+
+	// Fixed placement of one instance; its transform is rebuilt every frame
+	// from these and the instance clock.
+	struct InstanceSeed
+	{
+		Vec3 position;
+		float phase;
+		float spinSpeed;
+		uint32_t material;
+		uint32_t model;
+		// Texture array layer, or SceneLoader::kNoTexture for the material colour.
+		uint32_t textureLayer;
+	};
+
+	// Contiguous run of instances that all draw one scene model.
+	struct InstanceRange
+	{
+		uint32_t first;
+		uint32_t count;
+		uint32_t model;
+	};
+
+	// Everything fetchAssets reads from disk, built aside so a reload that
+	// fails leaves the current scene untouched.
+	struct FetchedAssets
+	{
+		SceneGeometry scene;
+		std::vector<ScenePlacement> placements;
+		TextureImage texture;
+		std::vector<TextureImage> sceneTextures;
+		bool hasRealTexture = false;
+		bool hasMaterial = false;
+		Vec3 materialKd;
+		Vec3 materialKs;
+		float materialNs = 0.0f;
+	};
+
 	struct SwapChainSupportDetails
 	{
 		VkSurfaceCapabilitiesKHR capabilities;
@@ -38,34 +98,58 @@ namespace scop
 	class ScopApp
 	{
 	public:
-		ScopApp();
+		explicit ScopApp(const AppOptions &options);
 		~ScopApp();
 
-		void run(const std::string &modelPath, const std::string &texturePath);
+		void run(const std::vector<std::string> &modelPaths, const std::string &texturePath);
 
 	private:
 		static constexpr uint32_t WIDTH = 1920U;
 		static constexpr uint32_t HEIGHT = 1080U;
-		static constexpr std::size_t MAX_FRAMES_IN_FLIGHT = 2U;
 
 		static void framebufferResizeCallback(GLFWwindow *window, int width, int height);
+		static void windowRefreshCallback(GLFWwindow *window);
 
 		void initWindow();
-		void loadAssets(const std::string &modelPath, const std::string &texturePath);
-		void centerAndScaleMesh();
+		void loadAssets();
+		// Reads the models and textures from their source files;
+		// loadAssets and reloads share it. adoptAssets makes the result the
+		// CPU-side scene.
+		FetchedAssets fetchAssets();
+		std::string loadSceneFile(const std::string &path, FetchedAssets &assets);
+		void adoptAssets(FetchedAssets &&assets);
+		// Frees the CPU copies the GPU resources were built from, unless
+		// --residency keep.
+		void releaseCpuCopies();
+		// F5: re-reads the source files, then waits for the device and
+		// rebuilds every resource that depends on the scene. A file that
+		// fails to load, or a changed model count, keeps the current scene.
+		void reloadAssets();
 		void initVulkan();
 		void mainLoop();
+		void renderHeadless();
+		void applyBenchmarkPose();
+		void collectGpuTiming(std::size_t slot);
+		bool finishBenchmark();
 		void cleanup();
 
+		bool headless() const { return options_.headlessFrames > 0U; }
+		VkExtent2D requestedExtent() const;
+
 		void createInstance();
 		void createSurface();
 		void pickPhysicalDevice();
 		void createLogicalDevice();
 		void createSwapChain();
 		void createImageViews();
+		void createOffscreenTargets();
+		void destroyOffscreenTargets();
 		void createRenderPass();
 		void createDescriptorSetLayout();
 		void createGraphicsPipeline();
+		VkPipeline createPipelineVariant(std::size_t variant);
+		VkPipeline pipelineVariant(std::size_t variant);
+		std::size_t shadingVariant() const;
 		void createFramebuffers();
 		void createCommandPool();
 		void createDepthResources();
@@ -75,17 +159,43 @@ namespace scop
 		void createVertexBuffer();
 		void createIndexBuffer();
 		void createUniformBuffers();
+		void createInstanceBuffer();
+		void updateInstances(std::size_t frameIndex, const Frustum &frustum);
+		void createDrawArguments();
+		void createCullingResources();
+		void updateDrawArguments(std::size_t frameIndex);
+		void recordCulling(VkCommandBuffer commandBuffer, const Mat4 &mvp);
+		void planRecording();
+		void createSecondaryCommandBuffers();
+		void recordDraws(VkCommandBuffer commandBuffer, const MeshPushConstants &pushConstants,
+						 uint32_t firstDraw, uint32_t endDraw);
+		std::size_t drawCommandCount() const { return scene_.submeshes().size() * drawSlices_; }
+		std::string recordingSummary() const;
+		std::string cullingSummary() const;
+		void createMaterialBuffer();
 		void createDescriptorPool();
 		void createDescriptorSets();
 		void createCommandBuffers();
 		void createSyncObjects();
+		// Buffers, texture, descriptors and secondary command buffers built
+		// from the scene; everything else survives a reload.
+		void createSceneResources();
+		void destroySceneResources();
 
 		void recreateSwapChain();
 		void cleanupSwapChain();
-		void drawFrame();
-		void updateUniformBuffer(uint32_t imageIndex, float dt);
-		void processEvents(bool &running, float dt);
-
+		void cleanupPipeline();
+		void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const MeshPushConstants &pushConstants);
+		void recordReadback(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		void writeReadback(std::size_t slot);
+		void drawFrame(bool &running);
+		bool sceneIsStatic() const;
+		void pollPresentCompletion();
+		MeshPushConstants updateFrameData(std::size_t frameIndex, float dt);
+		void updateProjection();
+		void processEvents(bool &running);
+
+		bool hasDeviceExtension(VkPhysicalDevice device, const char *name) const;
 		bool checkDeviceExtensionSupport(VkPhysicalDevice device) const;
 		bool isDeviceSuitable(VkPhysicalDevice device) const;
 		QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) const;
@@ -95,23 +205,23 @@ namespace scop
 		VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes) const;
 		VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities) const;
 
-		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
 		VkFormat findDepthFormat() const;
 		VkFormat findSupportedFormat(const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features) const;
 		bool hasStencilComponent(VkFormat format) const;
 
-		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-						  VkBuffer &buffer, VkDeviceMemory &bufferMemory);
-		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-		void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
-						 VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory);
-		VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) const;
-		void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-		void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, GpuMemoryPool pool,
+						  VkBuffer &buffer, GpuAllocation &allocation);
+		void destroyBuffer(VkBuffer &buffer, GpuAllocation &allocation);
+		void createImage(uint32_t width, uint32_t height, uint32_t arrayLayers, VkFormat format, VkImageTiling tiling,
+						 VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, GpuAllocation &allocation);
+		void destroyImage(VkImage &image, GpuAllocation &allocation);
+		VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
+									VkImageViewType viewType, uint32_t layerCount) const;
+
+		VkShaderModule createShaderModule(const ShaderCode &code) const;
 
-		VkCommandBuffer beginSingleTimeCommands();
-		void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-		VkShaderModule createShaderModule(const std::vector<std::uint8_t> &code) const;
+		AppOptions options_;
+		std::size_t framesInFlight_;
 
 		GLFWwindow *window_;
 		VkInstance instance_;
@@ -120,6 +230,7 @@ namespace scop
 		VkDevice device_;
 		VkQueue graphicsQueue_;
 		VkQueue presentQueue_;
+		VkQueue transferQueue_;
 
 		VkSwapchainKHR swapChain_;
 		std::vector<VkImage> swapChainImages_;
@@ -127,33 +238,134 @@ namespace scop
 		std::vector<VkFramebuffer> swapChainFramebuffers_;
 		VkFormat swapChainImageFormat_;
 		VkExtent2D swapChainExtent_;
+		VkPresentModeKHR swapChainPresentMode_;
+
+		// Headless mode renders into these instead of swapchain images (one
+		// per frame in flight) and, when dumping frames, copies each into the
+		// matching host-visible readback buffer.
+		std::vector<GpuAllocation> offscreenAllocations_;
+		std::vector<VkBuffer> readbackBuffers_;
+		std::vector<GpuAllocation> readbackAllocations_;
+		std::vector<std::optional<std::size_t>> readbackFrames_;
+
+		uint32_t instanceApiVersion_;
+		bool presentWaitSupported_;
+		// Secondary command buffers may run inside the pipeline statistics
+		// query; without it the query is skipped on partitioned frames.
+		bool inheritedQueries_;
+		PFN_vkWaitForPresentKHR waitForPresent_;
+		uint64_t lastPresentId_;
+		LatencyTracker latency_;
 
 		VkRenderPass renderPass_;
 		VkDescriptorSetLayout descriptorSetLayout_;
 		VkPipelineLayout pipelineLayout_;
+		// Fragment shader variants indexed by kVariantTextured |
+		// kVariantMaterial | kVariantUntextured, built on first use;
+		// graphicsPipeline_ is the one bound this frame.
+		std::array<VkPipeline, 8> pipelineVariants_;
 		VkPipeline graphicsPipeline_;
 		VkCommandPool commandPool_;
 
+		GpuAllocator allocator_;
+		UploadBatcher uploader_;
+		PipelineCache pipelineCache_;
+		GpuProfiler gpuProfiler_;
+		std::optional<Benchmark> benchmark_;
+		IdleMonitor idleMonitor_;
+		std::chrono::high_resolution_clock::time_point previousDrawTime_;
+		double fenceWaitMs_;
+
 		VkImage depthImage_;
-		VkDeviceMemory depthImageMemory_;
+		GpuAllocation depthImageAllocation_;
 		VkImageView depthImageView_;
 
 		VkImage textureImage_;
-		VkDeviceMemory textureImageMemory_;
+		GpuAllocation textureImageAllocation_;
+		uint32_t textureLayerCount_;
 		VkImageView textureImageView_;
 		VkSampler textureSampler_;
 
 		VkBuffer vertexBuffer_;
-		VkDeviceMemory vertexBufferMemory_;
+		GpuAllocation vertexBufferAllocation_;
 		VkBuffer indexBuffer_;
-		VkDeviceMemory indexBufferMemory_;
-
-		std::vector<VkBuffer> uniformBuffers_;
-		std::vector<VkDeviceMemory> uniformBuffersMemory_;
-		std::vector<void *> uniformBuffersMapped_;
+		GpuAllocation indexBufferAllocation_;
+
+		// Per-instance transforms and material slots, one slice per frame in
+		// flight, rewritten every frame by the thread pool. Instances are
+		// sorted by model, so each model owns one range of every slice and
+		// its draw commands start at that range.
+		std::size_t instanceCount_;
+		std::vector<InstanceSeed> instanceSeeds_;
+		std::vector<InstanceRange> modelInstances_;
+		// Thread pool work items; a chunk never spans two models.
+		std::vector<InstanceRange> instanceChunks_;
+		VkBuffer instanceBuffer_;
+		GpuAllocation instanceAllocation_;
+		VkDeviceSize instanceSliceSize_;
+		float fieldExtent_;
+		ThreadPool threadPool_;
+
+		// Frustum culling of the instance field. The GPU path compacts the
+		// visible instances from a compute pass and draws them with
+		// vkCmdDrawIndexedIndirectCount; the CPU path compacts them while the
+		// transforms are written. Both compact each model's survivors to the
+		// front of its range.
+		CullMode cullMode_;
+		PFN_vkCmdDrawIndexedIndirectCount drawIndexedIndirectCount_;
+		// Submeshes drawn per indirect call: all of them with multiDrawIndirect,
+		// otherwise one call per submesh.
+		uint32_t maxDrawsPerCall_;
+		// Without drawIndirectFirstInstance the commands cannot start at a
+		// model's range, so several models are drawn with direct calls.
+		bool directDraws_;
+		// Model-space bounding sphere per model (xyz = centre, w = radius).
+		std::vector<Vec4> modelSpheres_;
+		std::vector<std::uint8_t> instanceVisible_;
+		// Culling input as streams for the MathBatch kernels: per-instance
+		// world-space sphere centres (rewritten every frame) and radii.
+		Vec3Array cullCenters_;
+		std::vector<float> cullRadii_;
+		std::vector<std::size_t> chunkVisible_;
+		std::vector<std::size_t> modelVisible_;
+		std::size_t visibleInstanceCount_;
+		VkDescriptorSetLayout cullSetLayout_;
+		VkPipelineLayout cullPipelineLayout_;
+		VkPipeline cullPipeline_;
+		VkDescriptorSet cullDescriptorSet_;
+		VkBuffer visibleInstanceBuffer_;
+		GpuAllocation visibleInstanceAllocation_;
+		VkBuffer modelInfoBuffer_;
+		GpuAllocation modelInfoAllocation_;
+		// One host-visible slot per frame in flight: a small header (draw
+		// count), one visible instance counter per model, then one indexed
+		// indirect command per submesh at drawCommandsOffset_.
+		VkBuffer drawArgumentsBuffer_;
+		GpuAllocation drawArgumentsAllocation_;
+		VkDeviceSize drawArgumentsStride_;
+		VkDeviceSize drawCommandsOffset_;
+
+		VkBuffer frameUniformBuffer_;
+		GpuAllocation frameUniformAllocation_;
+		VkDeviceSize frameUniformStride_;
+		VkBuffer materialBuffer_;
+		GpuAllocation materialBufferAllocation_;
 		VkDescriptorPool descriptorPool_;
-		std::vector<VkDescriptorSet> descriptorSets_;
+		VkDescriptorSet descriptorSet_;
 		std::vector<VkCommandBuffer> commandBuffers_;
+		// The draw list is split into recordPartitions_ ranges recorded in
+		// parallel into secondary buffers. Every range has its own transient
+		// pool per frame in flight (index frame * partitions + range), reset
+		// before each recording; a single range records inline instead.
+		// Each submesh draws its instances in drawSlices_ commands, so a
+		// scene with fewer submeshes than threads still splits.
+		std::size_t recordPartitions_;
+		std::size_t recordThreads_;
+		uint32_t drawSlices_;
+		std::vector<VkCommandPool> secondaryPools_;
+		std::vector<VkCommandBuffer> secondaryBuffers_;
+		double recordMsTotal_;
+		std::size_t recordedFrames_;
 
 		std::vector<VkSemaphore> imageAvailableSemaphores_;
 		std::vector<VkSemaphore> renderFinishedSemaphores_;
@@ -162,27 +374,44 @@ namespace scop
 		std::size_t currentFrame_;
 
 		bool framebufferResized_;
-		bool rotationPaused_;
-		bool textureEnabled_;
+		// Set by input, window refreshes and resizes; cleared once a frame
+		// showing the change has been submitted.
+		bool redrawRequested_;
+		// Set by F5; the main loop reloads before the next frame is drawn.
+		bool reloadRequested_;
 		bool hasRealTexture_;
-		float rotationAngle_;
-		float rotationSpeed_;
-		float textureBlend_;
-		float targetTextureBlend_;
-		Vec3 translation_;
+		// Some instances have no texture layer and keep the material colour,
+		// so the textured variants have to test the layer per fragment.
+		bool untexturedInstances_;
+		Mat4 viewProjection_;
+
+		// Rotation, translation, blend and instance time advance on the
+		// simulation's fixed step; frameState_ is the interpolated state
+		// the current frame is drawn with.
+		Simulation simulation_;
+		SimulationState frameState_;
+		bool frameSettled_;
 
 		bool prevEscape_;
 		bool prevT_;
 		bool prevSpace_;
 		bool prevR_;
+		bool prevF5_;
 
 		bool hasMaterial_;
 		Vec3 materialKd_;
 		Vec3 materialKs_;
 		float materialNs_;
 
-		MeshData mesh_;
+		SceneGeometry scene_;
+		// From --scene; texture holds the array layer once loadAssets is done.
+		std::vector<ScenePlacement> placements_;
 		TextureImage textureData_;
+		// Layers 1..n of the texture array, in scene file order.
+		std::vector<TextureImage> sceneTextures_;
+		// Kept so a reload can fetch the released CPU copies again.
+		std::vector<std::string> modelPaths_;
+		std::string texturePath_;
 	};
 
 } // namespace scop
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace scop
+{
+
+	// Auto picks Gpu when the device supports drawIndirectCount, Cpu otherwise.
+	enum class CullMode
+	{
+		Auto,
+		Gpu,
+		Cpu,
+		Off
+	};
+
+	// Auto follows the T toggle; the others pin one fragment shader variant.
+	enum class ShadingMode
+	{
+		Auto,
+		Plain,
+		Material,
+		Textured
+	};
+
+	// Release frees the CPU copies of meshes and textures once they are on
+	// the GPU; Keep holds them until exit.
+	enum class ResidencyPolicy
+	{
+		Release,
+		Keep
+	};
+
+	// Software renders on the CPU for machines without a Vulkan driver.
+	enum class RenderBackend
+	{
+		Vulkan,
+		Software
+	};
+
+	struct AppOptions
+	{
+		// Every positional .obj after the first adds another model to the
+		// scene; the first one also provides the material and texture.
+		std::vector<std::string> modelPaths;
+		std::string texturePath;
+		// Scene file listing model placements; replaces the positional models.
+		// The positional texture, if any, is used by placements that name none.
+		std::string scenePath;
+
+		RenderBackend backend;
+		// Threads rasterizing tiles with the software backend; 0 uses every
+		// hardware thread, 1 renders on the main thread.
+		std::size_t rasterThreads;
+
+		// Unset keeps the default preference (MAILBOX, then FIFO).
+		std::optional<VkPresentModeKHR> presentMode;
+		std::size_t framesInFlight;
+		// 0 disables the frame limiter.
+		double targetFps;
+		// Poll input after the frame fences and image acquire, right before
+		// the per-frame data is written, instead of at the top of the loop.
+		bool lateLatch;
+		// Block on input instead of redrawing while nothing on screen moves.
+		bool idle;
+		// Per-frame GPU timings and pipeline statistics are appended here as CSV.
+		std::string gpuCsvPath;
+		// CPU profiler zones are written here as Chrome Trace Event JSON on exit.
+		std::string tracePath;
+		// Hard budgets in MiB, 0 for none. Host memory counts the tagged
+		// loader, texture and renderer allocations; GPU memory counts the
+		// device memory blocks. Crossing either fails at that allocation.
+		std::size_t hostBudgetMiB;
+		std::size_t gpuBudgetMiB;
+		ResidencyPolicy residency;
+
+		// Non-zero renders this many frames offscreen without a window or
+		// swapchain, with a fixed timestep, then exits.
+		std::size_t headlessFrames;
+		// 0 keeps the default 1920x1080.
+		uint32_t width;
+		uint32_t height;
+		// Headless frames are written here as frame_NNNN.ppm when set.
+		std::string dumpFramesDir;
+
+		// Copies of the model drawn with one instanced call, laid out on a grid.
+		std::size_t instances;
+		CullMode culling;
+		// Threads recording the scene's draws into secondary command buffers;
+		// 0 uses every pool thread, 1 records inline into the primary buffer.
+		std::size_t recordThreads;
+		ShadingMode shading;
+
+		// Scripted benchmark: warm-up frames are rendered but not measured.
+		// With --headless the offscreen path is used and its frame count is
+		// replaced by benchWarmup + benchFrames.
+		bool bench;
+		std::size_t benchFrames;
+		std::size_t benchWarmup;
+		// Empty writes the JSON report to stdout.
+		std::string benchJsonPath;
+		std::string benchBaselinePath;
+		// Allowed regression against the baseline, in percent.
+		double benchThreshold;
+
+		AppOptions();
+
+		static AppOptions parse(int argc, char **argv);
+		static void printUsage(const char *program);
+	};
+
+	const char *presentModeName(VkPresentModeKHR mode);
+	const char *cullModeName(CullMode mode);
+	const char *shadingModeName(ShadingMode mode);
+	const char *residencyPolicyName(ResidencyPolicy policy);
+	const char *renderBackendName(RenderBackend backend);
+
+} // namespace scop
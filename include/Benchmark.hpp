@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Math.hpp"
+
+namespace scop
+{
+
+	struct BenchmarkResult
+	{
+		std::size_t frames;
+		double seconds;
+		double fps;
+		double frameMeanMs;
+		double frameP50Ms;
+		double frameP99Ms;
+		double frameMaxMs;
+		double cpuMeanMs;
+		double cpuP99Ms;
+		double fenceWaitMeanMs;
+		double fenceWaitP99Ms;
+		std::size_t gpuSamples;
+		double gpuMeanMs;
+		double gpuP50Ms;
+		double gpuP99Ms;
+	};
+
+	struct BenchmarkPose
+	{
+		Vec3 translation;
+		float rotation;
+	};
+
+	// Deterministic render benchmark: a fixed model pose script advanced by a
+	// fixed timestep, a warm-up phase that is not measured, then per-frame
+	// samples of frame interval, CPU work, fence waits and GPU time.
+	class Benchmark
+	{
+	public:
+		static constexpr float kFixedDt = 1.0f / 60.0f;
+
+		Benchmark(std::size_t warmupFrames, std::size_t measuredFrames);
+
+		static BenchmarkPose pose(std::size_t frame);
+
+		std::size_t frameIndex() const { return frameIndex_; }
+		bool measuring() const { return frameIndex_ >= warmupFrames_; }
+		bool done() const { return frameIndex_ >= warmupFrames_ + measuredFrames_; }
+
+		void addFrame(double cpuMs, double fenceWaitMs);
+		void addGpuSample(double gpuMs);
+
+		BenchmarkResult result() const;
+		static void writeJson(std::ostream &out, const BenchmarkResult &result,
+							  const std::vector<std::pair<std::string, std::string>> &info);
+		// Returns one line per metric that is worse than the baseline by more
+		// than thresholdPercent; empty when the run passes.
+		static std::vector<std::string> compareWithBaseline(const BenchmarkResult &result, const std::string &baselinePath,
+															double thresholdPercent);
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		std::size_t warmupFrames_;
+		std::size_t measuredFrames_;
+		std::size_t frameIndex_;
+		Clock::time_point lastFrame_;
+		Clock::time_point measureBegin_;
+		Clock::time_point measureEnd_;
+
+		std::vector<double> frameMs_;
+		std::vector<double> cpuMs_;
+		std::vector<double> fenceWaitMs_;
+		std::vector<double> gpuMs_;
+	};
+
+} // namespace scop
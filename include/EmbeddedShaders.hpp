@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace scop
+{
+
+	// SPIR-V compiled from shaders/ and linked into the executable, so the
+	// binary does not depend on the working directory at runtime.
+	struct ShaderCode
+	{
+		const uint32_t *words;
+		std::size_t size;
+	};
+
+	class EmbeddedShaders
+	{
+	public:
+		static ShaderCode meshVertex();
+		static ShaderCode meshFragment();
+		static ShaderCode cullCompute();
+	};
+
+} // namespace scop
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -8,5 +9,6 @@ namespace scop
 {
 
 	std::vector<std::uint8_t> readBinaryFile(const std::string &path);
+	void writeBinaryFile(const std::string &path, const void *data, std::size_t size);
 
 } // namespace scop
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <chrono>
+
+namespace scop
+{
+
+	// Caps the main loop to a target rate. Sleeps until shortly before the
+	// deadline, then spins the rest of the way, because OS sleeps routinely
+	// overshoot by a millisecond or more.
+	class FrameLimiter
+	{
+	public:
+		explicit FrameLimiter(double targetFps);
+
+		bool enabled() const { return enabled_; }
+		void wait();
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		bool enabled_;
+		Clock::duration period_;
+		Clock::time_point deadline_;
+		bool started_;
+	};
+
+} // namespace scop
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+namespace scop
+{
+
+	// Frame-time statistics: running mean/variance (Welford) for the whole
+	// run, plus a sample window that is reported and reset periodically so
+	// present modes and limiter settings can be compared.
+	class FrameStats
+	{
+	public:
+		explicit FrameStats(double reportIntervalSeconds);
+
+		void addFrame(double frameMs);
+		bool reportDue() const;
+		void report(std::ostream &out);
+		void printSummary(std::ostream &out) const;
+
+	private:
+		struct Accumulator
+		{
+			std::size_t count;
+			double mean;
+			double m2;
+			double minValue;
+			double maxValue;
+
+			Accumulator();
+			void add(double value);
+			double stddev() const;
+		};
+
+		static double percentile(std::vector<double> &samples, double fraction);
+
+		double reportIntervalMs_;
+		double windowElapsedMs_;
+		Accumulator window_;
+		Accumulator total_;
+		std::vector<double> windowSamples_;
+	};
+
+} // namespace scop
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <vector>
+
+namespace scop
+{
+
+	// Long-lived resources live in buddy-allocated pages, upload buffers in
+	// linear pages that rewind once every allocation in them is released.
+	enum class GpuMemoryPool
+	{
+		Static,
+		Staging
+	};
+
+	// Linear (buffers, linear images) and optimal-tiling resources never share
+	// a page, which keeps bufferImageGranularity out of the offset math.
+	enum class GpuResourceKind
+	{
+		Linear,
+		Optimal
+	};
+
+	struct GpuAllocation
+	{
+		VkDeviceMemory memory;
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		void *mapped;
+		uint32_t memoryTypeIndex;
+		void *block;
+
+		GpuAllocation()
+			: memory(VK_NULL_HANDLE), offset(0U), size(0U), mapped(nullptr), memoryTypeIndex(0U), block(nullptr) {}
+
+		bool valid() const { return memory != VK_NULL_HANDLE; }
+	};
+
+	struct GpuHeapStats
+	{
+		VkDeviceSize heapSize;
+		VkDeviceSize reservedBytes;
+		VkDeviceSize peakReservedBytes;
+		VkDeviceSize usedBytes;
+		VkDeviceSize peakUsedBytes;
+		// VK_EXT_memory_budget, 0 without it: how much of the heap the driver
+		// lets this process use, and how much of it the process uses now.
+		VkDeviceSize budgetBytes;
+		VkDeviceSize driverUsageBytes;
+		uint32_t blockCount;
+		uint32_t allocationCount;
+		bool deviceLocal;
+	};
+
+	class GpuAllocator
+	{
+	public:
+		GpuAllocator();
+		~GpuAllocator();
+
+		GpuAllocator(const GpuAllocator &) = delete;
+		GpuAllocator &operator=(const GpuAllocator &) = delete;
+
+		// memoryBudget: VK_EXT_memory_budget is enabled on the device.
+		void init(VkPhysicalDevice physicalDevice, VkDevice device, bool memoryBudget);
+		void shutdown();
+
+		// Hard cap on the device memory reserved from the driver, over all
+		// heaps; 0 removes it. A block that would cross it throws before
+		// vkAllocateMemory is called.
+		void setBudget(VkDeviceSize bytes);
+		bool memoryBudgetSupported() const { return memoryBudget_; }
+
+		GpuAllocation allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties,
+							   GpuMemoryPool pool, GpuResourceKind kind);
+		void free(GpuAllocation &allocation);
+
+		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		const VkPhysicalDeviceMemoryProperties &memoryProperties() const { return memoryProperties_; }
+
+		std::vector<GpuHeapStats> heapStats() const;
+		uint32_t deviceMemoryObjectCount() const;
+		void printStats(std::ostream &out) const;
+
+	private:
+		struct Block
+		{
+			VkDeviceMemory memory;
+			VkDeviceSize size;
+			void *mapped;
+			uint32_t memoryTypeIndex;
+			GpuMemoryPool pool;
+			GpuResourceKind kind;
+			bool dedicated;
+			uint32_t liveCount;
+			VkDeviceSize usedBytes;
+
+			VkDeviceSize linearHead;
+
+			uint32_t maxOrder;
+			std::vector<std::set<VkDeviceSize>> freeLists;
+			std::map<VkDeviceSize, uint32_t> allocatedOrders;
+		};
+
+		static constexpr VkDeviceSize MIN_BUDDY_NODE = 256U;
+
+		Block *createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, GpuMemoryPool pool, GpuResourceKind kind, bool dedicated);
+		void destroyBlock(Block *block);
+		VkDeviceSize blockSizeForType(uint32_t memoryTypeIndex) const;
+
+		bool allocateLinear(Block &block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+		bool allocateBuddy(Block &block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+		void freeBuddy(Block &block, VkDeviceSize offset);
+
+		VkPhysicalDevice physicalDevice_;
+		VkDevice device_;
+		VkPhysicalDeviceMemoryProperties memoryProperties_;
+		VkDeviceSize bufferImageGranularity_;
+		bool memoryBudget_;
+		VkDeviceSize budget_;
+		std::vector<std::unique_ptr<Block>> blocks_;
+		std::vector<VkDeviceSize> heapUsed_;
+		std::vector<VkDeviceSize> heapPeakUsed_;
+		std::vector<VkDeviceSize> heapReserved_;
+		std::vector<VkDeviceSize> heapPeakReserved_;
+		mutable std::mutex mutex_;
+	};
+
+} // namespace scop
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace scop
+{
+
+	// Per-frame GPU timing around the render pass, plus pipeline statistics
+	// when the device supports them. Each frame-in-flight slot owns its own
+	// queries; a slot is read back only after its fence has been waited on,
+	// so vkGetQueryPoolResults never blocks.
+	class GpuProfiler
+	{
+	public:
+		struct Percentiles
+		{
+			double p50;
+			double p95;
+			double p99;
+		};
+
+		GpuProfiler();
+		~GpuProfiler();
+
+		GpuProfiler(const GpuProfiler &) = delete;
+		GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+		void init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily,
+				  std::size_t frameSlots, bool pipelineStatistics, const std::string &csvPath);
+		void shutdown();
+
+		// statistics false leaves the pipeline statistics out of this frame,
+		// for command buffers whose secondaries cannot inherit the query.
+		void begin(VkCommandBuffer commandBuffer, std::size_t slot, bool statistics = true);
+		void end(VkCommandBuffer commandBuffer, std::size_t slot);
+		// Returns true when a new sample was read; see latestMs().
+		bool collect(std::size_t slot);
+
+		bool enabled() const { return timestampPool_ != VK_NULL_HANDLE; }
+		bool hasPipelineStatistics() const { return statisticsPool_ != VK_NULL_HANDLE; }
+		// What secondary command buffers must inherit while the query is active.
+		VkQueryPipelineStatisticFlags pipelineStatisticFlags() const;
+		bool hasSamples() const { return !samplesMs_.empty(); }
+		double latestMs() const { return latestMs_; }
+		Percentiles percentiles() const;
+		std::string titleSummary() const;
+		void report(std::ostream &out) const;
+
+	private:
+		enum Statistic
+		{
+			VertexInvocations,
+			ClippingPrimitives,
+			FragmentInvocations,
+			StatisticCount
+		};
+
+		static constexpr std::size_t kWindow = 240U;
+
+		VkDevice device_;
+		VkQueryPool timestampPool_;
+		VkQueryPool statisticsPool_;
+		double timestampPeriodNs_;
+		uint64_t timestampMask_;
+		std::vector<bool> slotRecorded_;
+		std::vector<bool> slotStatistics_;
+
+		std::vector<double> samplesMs_;
+		std::size_t nextSample_;
+		double latestMs_;
+		uint64_t frameIndex_;
+		uint64_t lastStatistics_[StatisticCount];
+		std::ofstream csv_;
+	};
+
+} // namespace scop
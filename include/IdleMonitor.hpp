@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+namespace scop
+{
+
+	// Splits wall time into rendering and idle periods and measures the
+	// process CPU time spent in each, so the cost of an unchanged frame can
+	// be compared with blocking on input instead. GPU busy time is only
+	// measured while rendering: nothing is submitted while idle.
+	class IdleMonitor
+	{
+	public:
+		IdleMonitor();
+
+		// Called once per main loop iteration; the time since the previous
+		// call is charged to the previous iteration's state.
+		void sample(bool idle);
+		// Render-pass time of a frame, charged to the rendering period.
+		void addGpuMs(double ms);
+		void report(std::ostream &out);
+		void printSummary(std::ostream &out) const;
+
+	private:
+		struct Period
+		{
+			double wallMs;
+			double cpuMs;
+			double gpuMs;
+			std::size_t iterations;
+
+			Period();
+		};
+
+		static double cpuNowMs();
+		static void print(std::ostream &out, const Period (&periods)[2]);
+
+		std::chrono::steady_clock::time_point lastWall_;
+		double lastCpuMs_;
+		bool idle_;
+		bool started_;
+		Period window_[2];
+		Period total_[2];
+	};
+
+} // namespace scop
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+namespace scop
+{
+
+	// Follows input events through the frame that consumes them. The input
+	// timestamp is taken when a key change is first seen; submit time is
+	// taken right after vkQueueSubmit, and present time when
+	// vkWaitForPresentKHR reports the frame's present id (polled, so it is
+	// an upper bound by at most one loop iteration).
+	class LatencyTracker
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		LatencyTracker();
+
+		void markInput(Clock::time_point when);
+		std::optional<Clock::time_point> consumeInput();
+
+		void frameSubmitted(std::optional<Clock::time_point> input, uint64_t presentId, Clock::time_point when);
+		uint64_t oldestPendingPresent() const;
+		void presentsCompleted(uint64_t presentId, Clock::time_point when);
+		void dropPendingPresents();
+
+		void report(std::ostream &out, bool presentTimingAvailable);
+
+	private:
+		struct PendingPresent
+		{
+			uint64_t presentId;
+			Clock::time_point input;
+		};
+
+		static void printSeries(std::ostream &out, const char *label, std::vector<double> &samples);
+
+		std::optional<Clock::time_point> pendingInput_;
+		std::deque<PendingPresent> pendingPresents_;
+		std::vector<double> inputToSubmitMs_;
+		std::vector<double> inputToPresentMs_;
+	};
+
+} // namespace scop
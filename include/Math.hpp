@@ -1,22 +1,41 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
+
+// Mat4 products use 4-wide vectors when the target guarantees them: SSE2 is
+// part of every x86-64 baseline and NEON of every AArch64 one, so no extra
+// compiler flags are needed. Anything else takes the scalar path.
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define SCOP_MATH_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SCOP_MATH_NEON 1
+#endif
 
 namespace scop
 {
 
+	// Everything here is defined in the header so the loader's and the
+	// frame loop's per-vertex math inlines into the caller; the constexpr
+	// parts also work in constant expressions.
+
 	struct Vec2
 	{
 		float x;
 		float y;
 
-		Vec2();
-		Vec2(float xv, float yv);
+		constexpr Vec2() : x(0.0f), y(0.0f) {}
+		constexpr Vec2(float xv, float yv) : x(xv), y(yv) {}
 
-		Vec2 operator+(const Vec2 &other) const;
-		Vec2 operator-(const Vec2 &other) const;
-		Vec2 operator*(float scalar) const;
+		constexpr Vec2 operator+(const Vec2 &other) const { return Vec2(x + other.x, y + other.y); }
+		constexpr Vec2 operator-(const Vec2 &other) const { return Vec2(x - other.x, y - other.y); }
+		constexpr Vec2 operator*(float scalar) const { return Vec2(x * scalar, y * scalar); }
 	};
 
 	struct Vec3
@@ -25,14 +44,20 @@ namespace scop
 		float y;
 		float z;
 
-		Vec3();
-		Vec3(float xv, float yv, float zv);
+		constexpr Vec3() : x(0.0f), y(0.0f), z(0.0f) {}
+		constexpr Vec3(float xv, float yv, float zv) : x(xv), y(yv), z(zv) {}
 
-		Vec3 operator+(const Vec3 &other) const;
-		Vec3 operator-(const Vec3 &other) const;
-		Vec3 operator*(float scalar) const;
-		Vec3 operator/(float scalar) const;
-		Vec3 &operator+=(const Vec3 &other);
+		constexpr Vec3 operator+(const Vec3 &other) const { return Vec3(x + other.x, y + other.y, z + other.z); }
+		constexpr Vec3 operator-(const Vec3 &other) const { return Vec3(x - other.x, y - other.y, z - other.z); }
+		constexpr Vec3 operator*(float scalar) const { return Vec3(x * scalar, y * scalar, z * scalar); }
+		constexpr Vec3 operator/(float scalar) const { return Vec3(x / scalar, y / scalar, z / scalar); }
+		constexpr Vec3 &operator+=(const Vec3 &other)
+		{
+			x += other.x;
+			y += other.y;
+			z += other.z;
+			return *this;
+		}
 	};
 
 	struct alignas(16) Vec4
@@ -42,38 +67,319 @@ namespace scop
 		float z;
 		float w;
 
-		Vec4();
-		Vec4(float xv, float yv, float zv, float wv);
+		constexpr Vec4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
+		constexpr Vec4(float xv, float yv, float zv, float wv) : x(xv), y(yv), z(zv), w(wv) {}
 	};
 
+	constexpr float dot(const Vec2 &lhs, const Vec2 &rhs)
+	{
+		return lhs.x * rhs.x + lhs.y * rhs.y;
+	}
+
+	constexpr float dot(const Vec3 &lhs, const Vec3 &rhs)
+	{
+		return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+	}
+
+	constexpr Vec3 cross(const Vec3 &lhs, const Vec3 &rhs)
+	{
+		return Vec3(
+			lhs.y * rhs.z - lhs.z * rhs.y,
+			lhs.z * rhs.x - lhs.x * rhs.z,
+			lhs.x * rhs.y - lhs.y * rhs.x);
+	}
+
+	inline float length(const Vec3 &v)
+	{
+		return std::sqrt(dot(v, v));
+	}
+
+	inline float length(const Vec2 &v)
+	{
+		return std::sqrt(dot(v, v));
+	}
+
+	inline Vec3 normalize(const Vec3 &v)
+	{
+		const float len = length(v);
+		if (len <= 1e-8f)
+		{
+			return Vec3(0.0f, 0.0f, 0.0f);
+		}
+		return v / len;
+	}
+
+	inline Vec2 normalize(const Vec2 &v)
+	{
+		const float len = length(v);
+		if (len <= 1e-8f)
+		{
+			return Vec2(0.0f, 0.0f);
+		}
+		return Vec2(v.x / len, v.y / len);
+	}
+
+	constexpr Vec3 minVec(const Vec3 &lhs, const Vec3 &rhs)
+	{
+		return Vec3(std::min(lhs.x, rhs.x), std::min(lhs.y, rhs.y), std::min(lhs.z, rhs.z));
+	}
+
+	constexpr Vec3 maxVec(const Vec3 &lhs, const Vec3 &rhs)
+	{
+		return Vec3(std::max(lhs.x, rhs.x), std::max(lhs.y, rhs.y), std::max(lhs.z, rhs.z));
+	}
+
+	// Column-major, like GLSL: element (row, col) is m[col * 4 + row].
 	struct alignas(16) Mat4
 	{
 		float m[16];
 
-		Mat4();
+		constexpr Mat4() : m{} {}
+
+		static constexpr Mat4 identity()
+		{
+			Mat4 result;
+			result(0, 0) = 1.0f;
+			result(1, 1) = 1.0f;
+			result(2, 2) = 1.0f;
+			result(3, 3) = 1.0f;
+			return result;
+		}
+
+		static constexpr Mat4 translation(const Vec3 &translation)
+		{
+			Mat4 result = identity();
+			result(0, 3) = translation.x;
+			result(1, 3) = translation.y;
+			result(2, 3) = translation.z;
+			return result;
+		}
+
+		static constexpr Mat4 scale(const Vec3 &scale)
+		{
+			Mat4 result = identity();
+			result(0, 0) = scale.x;
+			result(1, 1) = scale.y;
+			result(2, 2) = scale.z;
+			return result;
+		}
+
+		static Mat4 rotationAxis(const Vec3 &axis, float angleRadians)
+		{
+			Vec3 n = normalize(axis);
+			const float c = std::cos(angleRadians);
+			const float s = std::sin(angleRadians);
+			const float t = 1.0f - c;
+
+			Mat4 result = identity();
+			result(0, 0) = c + n.x * n.x * t;
+			result(0, 1) = n.x * n.y * t - n.z * s;
+			result(0, 2) = n.x * n.z * t + n.y * s;
+
+			result(1, 0) = n.y * n.x * t + n.z * s;
+			result(1, 1) = c + n.y * n.y * t;
+			result(1, 2) = n.y * n.z * t - n.x * s;
+
+			result(2, 0) = n.z * n.x * t - n.y * s;
+			result(2, 1) = n.z * n.y * t + n.x * s;
+			result(2, 2) = c + n.z * n.z * t;
+			return result;
+		}
 
-		static Mat4 identity();
-		static Mat4 translation(const Vec3 &translation);
-		static Mat4 scale(const Vec3 &scale);
-		static Mat4 rotationAxis(const Vec3 &axis, float angleRadians);
-		static Mat4 rotationY(float angleRadians);
-		static Mat4 perspective(float fovRadians, float aspect, float nearPlane, float farPlane);
-		static Mat4 lookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &up);
+		static Mat4 rotationY(float angleRadians)
+		{
+			const float c = std::cos(angleRadians);
+			const float s = std::sin(angleRadians);
 
-		float &operator()(std::size_t row, std::size_t col);
-		float operator()(std::size_t row, std::size_t col) const;
+			Mat4 result = identity();
+			result(0, 0) = c;
+			result(0, 2) = s;
+			result(2, 0) = -s;
+			result(2, 2) = c;
+			return result;
+		}
+
+		static Mat4 perspective(float fovRadians, float aspect, float nearPlane, float farPlane)
+		{
+			Mat4 result;
+			const float tanHalfFov = std::tan(fovRadians / 2.0f);
+			result(0, 0) = 1.0f / (aspect * tanHalfFov);
+			result(1, 1) = 1.0f / tanHalfFov;
+			result(2, 2) = farPlane / (nearPlane - farPlane);
+			result(2, 3) = (farPlane * nearPlane) / (nearPlane - farPlane);
+			result(3, 2) = -1.0f;
+			return result;
+		}
+
+		static Mat4 lookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &up)
+		{
+			const Vec3 f = normalize(center - eye);
+			const Vec3 s = normalize(cross(f, up));
+			const Vec3 u = cross(s, f);
+
+			Mat4 result = identity();
+			result(0, 0) = s.x;
+			result(1, 0) = s.y;
+			result(2, 0) = s.z;
+
+			result(0, 1) = u.x;
+			result(1, 1) = u.y;
+			result(2, 1) = u.z;
+
+			result(0, 2) = -f.x;
+			result(1, 2) = -f.y;
+			result(2, 2) = -f.z;
+
+			result(0, 3) = -dot(s, eye);
+			result(1, 3) = -dot(u, eye);
+			result(2, 3) = dot(f, eye);
+			return result;
+		}
+
+		constexpr float &operator()(std::size_t row, std::size_t col) { return m[col * 4 + row]; }
+		constexpr float operator()(std::size_t row, std::size_t col) const { return m[col * 4 + row]; }
 	};
 
-	Mat4 operator*(const Mat4 &lhs, const Mat4 &rhs);
-
-	float dot(const Vec2 &lhs, const Vec2 &rhs);
-	float dot(const Vec3 &lhs, const Vec3 &rhs);
-	Vec3 cross(const Vec3 &lhs, const Vec3 &rhs);
-	float length(const Vec3 &v);
-	float length(const Vec2 &v);
-	Vec3 normalize(const Vec3 &v);
-	Vec2 normalize(const Vec2 &v);
-	Vec3 minVec(const Vec3 &lhs, const Vec3 &rhs);
-	Vec3 maxVec(const Vec3 &lhs, const Vec3 &rhs);
+	namespace detail
+	{
+
+		// out = lhs * v for a column vector v, four lanes at a time: the sum
+		// of lhs's columns weighted by v's components.
+		inline void transformColumn(const Mat4 &lhs, const float *v, float *out)
+		{
+#if defined(SCOP_MATH_SSE)
+			__m128 sum = _mm_mul_ps(_mm_load_ps(lhs.m), _mm_set1_ps(v[0]));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(lhs.m + 4), _mm_set1_ps(v[1])));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(lhs.m + 8), _mm_set1_ps(v[2])));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(lhs.m + 12), _mm_set1_ps(v[3])));
+			_mm_store_ps(out, sum);
+#elif defined(SCOP_MATH_NEON)
+			float32x4_t sum = vmulq_n_f32(vld1q_f32(lhs.m), v[0]);
+			sum = vmlaq_n_f32(sum, vld1q_f32(lhs.m + 4), v[1]);
+			sum = vmlaq_n_f32(sum, vld1q_f32(lhs.m + 8), v[2]);
+			sum = vmlaq_n_f32(sum, vld1q_f32(lhs.m + 12), v[3]);
+			vst1q_f32(out, sum);
+#else
+			for (std::size_t row = 0; row < 4; ++row)
+			{
+				out[row] = lhs.m[row] * v[0] + lhs.m[4 + row] * v[1] + lhs.m[8 + row] * v[2] + lhs.m[12 + row] * v[3];
+			}
+#endif
+		}
+
+	} // namespace detail
+
+	constexpr Mat4 operator*(const Mat4 &lhs, const Mat4 &rhs)
+	{
+		Mat4 result;
+		if (!std::is_constant_evaluated())
+		{
+			// Column j of the product is lhs applied to column j of rhs.
+			for (std::size_t col = 0; col < 4; ++col)
+			{
+				detail::transformColumn(lhs, rhs.m + col * 4, result.m + col * 4);
+			}
+			return result;
+		}
+		for (std::size_t col = 0; col < 4; ++col)
+		{
+			for (std::size_t row = 0; row < 4; ++row)
+			{
+				result(row, col) = lhs(row, 0) * rhs(0, col) + lhs(row, 1) * rhs(1, col) +
+								   lhs(row, 2) * rhs(2, col) + lhs(row, 3) * rhs(3, col);
+			}
+		}
+		return result;
+	}
+
+	constexpr Vec4 operator*(const Mat4 &lhs, const Vec4 &rhs)
+	{
+		if (!std::is_constant_evaluated())
+		{
+			Vec4 result;
+			detail::transformColumn(lhs, &rhs.x, &result.x);
+			return result;
+		}
+		return Vec4(lhs(0, 0) * rhs.x + lhs(0, 1) * rhs.y + lhs(0, 2) * rhs.z + lhs(0, 3) * rhs.w,
+					lhs(1, 0) * rhs.x + lhs(1, 1) * rhs.y + lhs(1, 2) * rhs.z + lhs(1, 3) * rhs.w,
+					lhs(2, 0) * rhs.x + lhs(2, 1) * rhs.y + lhs(2, 2) * rhs.z + lhs(2, 3) * rhs.w,
+					lhs(3, 0) * rhs.x + lhs(3, 1) * rhs.y + lhs(3, 2) * rhs.z + lhs(3, 3) * rhs.w);
+	}
+
+	// Affine transform of a point (w = 1); the projective w is dropped.
+	constexpr Vec3 transformPoint(const Mat4 &transform, const Vec3 &point)
+	{
+		const Vec4 result = transform * Vec4(point.x, point.y, point.z, 1.0f);
+		return Vec3(result.x, result.y, result.z);
+	}
+
+	// Inverse-transpose of the upper 3x3 (cofactor matrix over the
+	// determinant), padded back to a Mat4 so it can live in push constants.
+	inline Mat4 normalMatrix(const Mat4 &model)
+	{
+		const float a = model(0, 0), b = model(0, 1), c = model(0, 2);
+		const float d = model(1, 0), e = model(1, 1), f = model(1, 2);
+		const float g = model(2, 0), h = model(2, 1), i = model(2, 2);
+
+		const float c00 = e * i - f * h;
+		const float c01 = f * g - d * i;
+		const float c02 = d * h - e * g;
+		const float det = a * c00 + b * c01 + c * c02;
+		const float invDet = (std::fabs(det) > 1e-12f) ? 1.0f / det : 0.0f;
+
+		Mat4 result = Mat4::identity();
+		result(0, 0) = c00 * invDet;
+		result(0, 1) = c01 * invDet;
+		result(0, 2) = c02 * invDet;
+		result(1, 0) = (c * h - b * i) * invDet;
+		result(1, 1) = (a * i - c * g) * invDet;
+		result(1, 2) = (b * g - a * h) * invDet;
+		result(2, 0) = (b * f - c * e) * invDet;
+		result(2, 1) = (c * d - a * f) * invDet;
+		result(2, 2) = (a * e - b * d) * invDet;
+		return result;
+	}
+
+	// Inward-facing planes (xyz = unit normal, w = distance) of a Vulkan
+	// clip volume (depth 0..1): left, right, bottom, top, near, far.
+	using Frustum = std::array<Vec4, 6>;
+
+	inline Frustum frustumPlanes(const Mat4 &viewProjection)
+	{
+		const Mat4 &m = viewProjection;
+		// Gribb/Hartmann: row 3 plus or minus rows 0-2; near is row 2 alone
+		// because clip-space depth starts at 0.
+		const auto combine = [&m](float w, std::size_t row, float sign)
+		{
+			return Vec4(w * m(3, 0) + sign * m(row, 0), w * m(3, 1) + sign * m(row, 1),
+						w * m(3, 2) + sign * m(row, 2), w * m(3, 3) + sign * m(row, 3));
+		};
+		Frustum frustum = {combine(1.0f, 0U, 1.0f), combine(1.0f, 0U, -1.0f),
+						   combine(1.0f, 1U, 1.0f), combine(1.0f, 1U, -1.0f),
+						   combine(0.0f, 2U, 1.0f), combine(1.0f, 2U, -1.0f)};
+
+		for (Vec4 &plane : frustum)
+		{
+			const float len = length(Vec3(plane.x, plane.y, plane.z));
+			if (len > 1e-12f)
+			{
+				plane.x /= len;
+				plane.y /= len;
+				plane.z /= len;
+				plane.w /= len;
+			}
+		}
+		return frustum;
+	}
+
+	inline bool sphereInFrustum(const Frustum &frustum, const Vec3 &center, float radius)
+	{
+		for (const Vec4 &plane : frustum)
+		{
+			if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius)
+				return false;
+		}
+		return true;
+	}
 
 } // namespace scop
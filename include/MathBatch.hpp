@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Math.hpp"
+
+namespace scop
+{
+
+	// Structure-of-arrays views: element i is (x[i], y[i], z[i]), so one
+	// vector register holds the same component of 4 or 8 elements.
+	struct Vec3Streams
+	{
+		float *x;
+		float *y;
+		float *z;
+	};
+
+	struct ConstVec3Streams
+	{
+		const float *x;
+		const float *y;
+		const float *z;
+	};
+
+	class Vec3Array
+	{
+	public:
+		void resize(std::size_t count);
+		std::size_t size() const { return x_.size(); }
+
+		void set(std::size_t index, const Vec3 &value);
+		Vec3 get(std::size_t index) const;
+
+		Vec3Streams streams(std::size_t first = 0U);
+		ConstVec3Streams streams(std::size_t first = 0U) const;
+
+	private:
+		std::vector<float> x_;
+		std::vector<float> y_;
+		std::vector<float> z_;
+	};
+
+	// Kernels over count elements of SoA streams. The instruction set is
+	// picked once from what the CPU reports (AVX2, then SSE4.1, then
+	// scalar); setIsa() narrows it for comparisons. Every set gives the
+	// same bits as the per-element functions of Math.hpp.
+	namespace MathBatch
+	{
+
+		enum class Isa
+		{
+			Scalar,
+			Sse4,
+			Avx2
+		};
+
+		Isa isa();
+		Isa bestIsa();
+		// Falls back to the best supported set below isa; returns the one used.
+		Isa setIsa(Isa isa);
+		const char *isaName(Isa isa);
+
+		// out[i] = transformPoint(transform, in[i]); out may alias in.
+		void transformPoints(const Mat4 &transform, ConstVec3Streams in, Vec3Streams out, std::size_t count);
+		// World-space boxes of count boxes given as centre and half extent,
+		// after an affine transform (Arvo: the extent goes through |M|).
+		void transformAabbs(const Mat4 &transform, ConstVec3Streams centers, ConstVec3Streams extents,
+							Vec3Streams outMin, Vec3Streams outMax, std::size_t count);
+		// inside[i] = sphereInFrustum(frustum, center[i], radius[i]) ? 1 : 0.
+		// Returns how many are inside.
+		std::size_t spheresInFrustum(const Frustum &frustum, ConstVec3Streams centers, const float *radii,
+									 std::size_t count, std::uint8_t *inside);
+		// In place; vectors shorter than 1e-8 become zero, like normalize().
+		void normalize(Vec3Streams vectors, std::size_t count);
+
+	} // namespace MathBatch
+
+} // namespace scop
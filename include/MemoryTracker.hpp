@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace scop
+{
+
+	// Owner of a host allocation: OBJ parsing and mesh building, decoded
+	// texture pixels, and the scene arrays the renderer uploads from.
+	enum class MemoryTag
+	{
+		Loader,
+		Texture,
+		Renderer
+	};
+
+	constexpr std::size_t kMemoryTagCount = 3U;
+
+	const char *memoryTagName(MemoryTag tag);
+
+	// Current and peak bytes per tag, counted by TrackingAllocator. With a
+	// budget set, an allocation that would take the total over it throws
+	// before anything is allocated.
+	class MemoryTracker
+	{
+	public:
+		// 0 removes the budget.
+		static void setHostBudget(std::size_t bytes);
+		static std::size_t hostBudget() { return budget_.load(std::memory_order_relaxed); }
+
+		static void allocated(MemoryTag tag, std::size_t bytes);
+		static void released(MemoryTag tag, std::size_t bytes);
+
+		static std::size_t current(MemoryTag tag);
+		static std::size_t peak(MemoryTag tag);
+		static std::size_t totalCurrent() { return total_.load(std::memory_order_relaxed); }
+		static std::size_t totalPeak() { return totalPeak_.load(std::memory_order_relaxed); }
+
+		static void printStats(std::ostream &out);
+
+	private:
+		static std::array<std::atomic<std::size_t>, kMemoryTagCount> current_;
+		static std::array<std::atomic<std::size_t>, kMemoryTagCount> peak_;
+		static std::atomic<std::size_t> total_;
+		static std::atomic<std::size_t> totalPeak_;
+		static std::atomic<std::size_t> budget_;
+	};
+
+	template <typename T, MemoryTag Tag>
+	class TrackingAllocator
+	{
+	public:
+		using value_type = T;
+
+		template <typename U>
+		struct rebind
+		{
+			using other = TrackingAllocator<U, Tag>;
+		};
+
+		TrackingAllocator() = default;
+		template <typename U>
+		TrackingAllocator(const TrackingAllocator<U, Tag> &) {}
+
+		T *allocate(std::size_t count)
+		{
+			MemoryTracker::allocated(Tag, count * sizeof(T));
+			try
+			{
+				return std::allocator<T>().allocate(count);
+			}
+			catch (...)
+			{
+				MemoryTracker::released(Tag, count * sizeof(T));
+				throw;
+			}
+		}
+
+		void deallocate(T *pointer, std::size_t count)
+		{
+			std::allocator<T>().deallocate(pointer, count);
+			MemoryTracker::released(Tag, count * sizeof(T));
+		}
+
+		template <typename U>
+		bool operator==(const TrackingAllocator<U, Tag> &) const { return true; }
+		template <typename U>
+		bool operator!=(const TrackingAllocator<U, Tag> &) const { return false; }
+	};
+
+	template <typename T, MemoryTag Tag>
+	using TrackedVector = std::vector<T, TrackingAllocator<T, Tag>>;
+
+} // namespace scop
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "Math.hpp"
+#include "MemoryTracker.hpp"
 
 namespace scop
 {
@@ -24,8 +26,10 @@ namespace scop
 
 	struct MeshData
 	{
-		std::vector<Vertex> vertices;
-		std::vector<uint32_t> indices;
+		// OBJ object/group name, empty when the file has none.
+		std::string name;
+		TrackedVector<Vertex, MemoryTag::Loader> vertices;
+		TrackedVector<uint32_t, MemoryTag::Loader> indices;
 		Bounds bounds;
 		bool hasSourceTexcoords;
 		bool usedGeneratedTexcoords;
@@ -1,16 +1,68 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "Mesh.hpp"
 
 namespace scop
 {
 
+	// Loader stages, exposed so bench/ can time them on their own.
+	namespace detail
+	{
+
+		// Zero-based indices; -1 when the token has no such element.
+		struct IndexTriplet
+		{
+			int v;
+			int vt;
+			int vn;
+		};
+
+		struct Face
+		{
+			std::vector<IndexTriplet> vertices;
+		};
+
+		// Corners as indices into Face::vertices.
+		struct Triangle
+		{
+			int a;
+			int b;
+			int c;
+		};
+
+		// "v", "v/vt", "v//vn" or "v/vt/vn"; negative indices count back from
+		// the given element counts.
+		IndexTriplet parseFaceToken(const std::string &token, int positionCount, int texcoordCount, int normalCount);
+		// Newell normal of the polygon, unit length.
+		Vec3 computeFaceNormal(const Face &face, const TrackedVector<Vec3, MemoryTag::Loader> &positions);
+		// Ear clipping in the plane of the face; falls back to a fan.
+		std::vector<Triangle> triangulateFace(const Face &face, const TrackedVector<Vec3, MemoryTag::Loader> &positions);
+		Vec2 generateBoxUV(const Vec3 &position, const Vec3 &normal, const Bounds &bounds);
+
+	} // namespace detail
+
+	// Kd, Ks and Ns from the OBJ's mtllib; valid stays false, with the
+	// viewer's default material, when the file names none.
+	struct ObjMaterial
+	{
+		bool valid;
+		Vec3 kd;
+		Vec3 ks;
+		float ns;
+
+		ObjMaterial();
+	};
+
 	class ObjLoader
 	{
 	public:
 		static MeshData loadFromFile(const std::string &path);
+		// One mesh per `o` / `g` group that owns faces, in file order.
+		static std::vector<MeshData> loadGroupsFromFile(const std::string &path);
+		static ObjMaterial loadMaterial(const std::string &objPath);
 	};
 
 } // namespace scop
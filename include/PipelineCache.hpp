@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <string>
+
+namespace scop
+{
+
+	// VkPipelineCache persisted between runs. The blob on disk is only reused
+	// when its header matches the current driver (vendor, device and
+	// pipelineCacheUUID); anything else starts from an empty cache.
+	class PipelineCache
+	{
+	public:
+		PipelineCache();
+		~PipelineCache();
+
+		PipelineCache(const PipelineCache &) = delete;
+		PipelineCache &operator=(const PipelineCache &) = delete;
+
+		void init(VkPhysicalDevice physicalDevice, VkDevice device);
+		void save() const;
+		void destroy();
+
+		VkPipelineCache handle() const { return cache_; }
+		bool warm() const { return warm_; }
+		std::size_t loadedBytes() const { return loadedBytes_; }
+		const std::string &path() const { return path_; }
+
+	private:
+		VkDevice device_;
+		VkPipelineCache cache_;
+		std::string path_;
+		bool warm_;
+		std::size_t loadedBytes_;
+	};
+
+} // namespace scop
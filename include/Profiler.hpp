@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Scoped CPU zones. Each thread appends completed zones to its own ring
+// buffer without locking; the rings are only walked when the trace is
+// written. With the profiler disabled a zone costs one relaxed load.
+#define SCOP_PROFILE_CONCAT_INNER(a, b) a##b
+#define SCOP_PROFILE_CONCAT(a, b) SCOP_PROFILE_CONCAT_INNER(a, b)
+#define SCOP_PROFILE_ZONE(name) const ::scop::ProfileZone SCOP_PROFILE_CONCAT(scopProfileZone_, __LINE__)(name)
+#define SCOP_PROFILE_FUNCTION() SCOP_PROFILE_ZONE(__func__)
+
+namespace scop
+{
+
+	class Profiler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		static void enable();
+		static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+		// Names must outlive the profiler (string literals or __func__).
+		static void record(const char *name, Clock::time_point begin, Clock::time_point end);
+		static void setThreadName(const std::string &name);
+
+		// Writes every recorded zone as Chrome Trace Event JSON, viewable in
+		// chrome://tracing or Perfetto. Call once the worker threads are idle.
+		static void writeChromeTrace(const std::string &path);
+
+	private:
+		static std::atomic<bool> enabled_;
+	};
+
+	class ProfileZone
+	{
+	public:
+		explicit ProfileZone(const char *name)
+			: name_(Profiler::enabled() ? name : nullptr)
+		{
+			if (name_ != nullptr)
+			{
+				begin_ = Profiler::Clock::now();
+			}
+		}
+
+		~ProfileZone()
+		{
+			if (name_ != nullptr)
+			{
+				Profiler::record(name_, begin_, Profiler::Clock::now());
+			}
+		}
+
+		ProfileZone(const ProfileZone &) = delete;
+		ProfileZone &operator=(const ProfileZone &) = delete;
+
+	private:
+		const char *name_;
+		Profiler::Clock::time_point begin_;
+	};
+
+} // namespace scop
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Mesh.hpp"
+
+namespace scop
+{
+
+	// One draw range inside the shared vertex and index arrays. Indices stay
+	// relative to the submesh and are rebased by vertexOffset at draw time.
+	struct Submesh
+	{
+		std::string name;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		int32_t vertexOffset;
+		uint32_t model;
+		Bounds bounds;
+	};
+
+	// The submeshes added by one addModel call, with their combined bounds.
+	struct SceneModel
+	{
+		uint32_t firstSubmesh;
+		uint32_t submeshCount;
+		Bounds bounds;
+	};
+
+	// Packs every mesh of the scene into one vertex array and one index
+	// array, so the whole scene lives in a single pair of GPU buffers and is
+	// drawn with one indirect command per submesh.
+	class SceneGeometry
+	{
+	public:
+		SceneGeometry();
+
+		// The meshes of one model are centred and scaled together to the
+		// viewer's unit size, then moved by offset. Returns the model index.
+		uint32_t addModel(const std::vector<MeshData> &meshes, const Vec3 &offset);
+		void clear();
+		// Frees the vertex and index arrays once they live on the GPU. The
+		// submeshes, models, bounds and counts stay; adding models needs a
+		// clear() first.
+		void releaseGeometry();
+
+		bool empty() const { return submeshes_.empty(); }
+		bool resident() const { return resident_; }
+		std::size_t modelCount() const { return models_.size(); }
+		std::size_t vertexCount() const { return vertexCount_; }
+		std::size_t indexCount() const { return indexCount_; }
+		const TrackedVector<Vertex, MemoryTag::Renderer> &vertices() const { return vertices_; }
+		const TrackedVector<uint32_t, MemoryTag::Renderer> &indices() const { return indices_; }
+		const std::vector<Submesh> &submeshes() const { return submeshes_; }
+		const std::vector<SceneModel> &models() const { return models_; }
+		const Bounds &bounds() const { return bounds_; }
+
+	private:
+		TrackedVector<Vertex, MemoryTag::Renderer> vertices_;
+		TrackedVector<uint32_t, MemoryTag::Renderer> indices_;
+		std::vector<Submesh> submeshes_;
+		std::vector<SceneModel> models_;
+		Bounds bounds_;
+		std::size_t vertexCount_;
+		std::size_t indexCount_;
+		bool resident_;
+	};
+
+} // namespace scop
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Math.hpp"
+#include "Mesh.hpp"
+#include "TextureLoader.hpp"
+
+namespace scop
+{
+
+	class ThreadPool;
+
+	// One line of a scene file. model and texture index the deduplicated
+	// asset lists of the description.
+	struct ScenePlacement
+	{
+		uint32_t model;
+		uint32_t texture;
+		Vec3 position;
+		float yaw;
+	};
+
+	struct SceneDescription
+	{
+		std::vector<std::string> modelPaths;
+		std::vector<std::string> texturePaths;
+		std::vector<ScenePlacement> placements;
+		// Model and texture paths named across all lines, duplicates included.
+		std::size_t assetReferences;
+		double parseMs;
+	};
+
+	struct SceneAssets
+	{
+		// Indexed like the description's path lists.
+		std::vector<std::vector<MeshData>> models;
+		std::vector<TextureImage> textures;
+		double loadMs;
+	};
+
+	// Text format, one placement per line, '#' starts a comment:
+	//     <model.obj> <x> <y> <z> [yaw_degrees] [texture.ppm]
+	// Relative paths are resolved against the scene file's directory, and
+	// paths that name the same file share one asset.
+	class SceneLoader
+	{
+	public:
+		static constexpr uint32_t kNoTexture = 0xFFFFFFFFU;
+
+		static SceneDescription parse(const std::string &path);
+		// Every distinct asset is loaded exactly once, spread over the pool.
+		static SceneAssets loadAssets(const SceneDescription &scene, ThreadPool &pool);
+		static void printStats(std::ostream &out, const SceneDescription &scene, const SceneAssets &assets, std::size_t threads);
+	};
+
+} // namespace scop
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "Math.hpp"
+#include "TripleBuffer.hpp"
+
+namespace scop
+{
+
+	// Everything the controls change over time. The simulation owns it; the
+	// renderer only reads published copies.
+	struct SimulationState
+	{
+		Vec3 translation;
+		float rotationAngle;
+		float textureBlend;
+		float targetTextureBlend;
+		float instanceTime;
+		bool rotationPaused;
+		bool textureEnabled;
+	};
+
+	// Keyboard state sampled on the main thread, where GLFW has to be
+	// polled. Presses are counted so none is lost between two ticks.
+	struct SimulationInput
+	{
+		bool left;
+		bool right;
+		bool up;
+		bool down;
+		bool forward;
+		bool backward;
+		uint32_t togglePresses;
+		uint32_t pausePresses;
+		uint32_t resetPresses;
+
+		bool active() const;
+	};
+
+	struct SimulationSettings
+	{
+		float rotationSpeed;
+		// T only toggles when there is a texture or a material to blend to.
+		bool canBlend;
+		// R restores the textured look only when a texture was loaded.
+		bool hasTexture;
+		// Pausing also freezes the instance spin; benchmark poses pin only
+		// the root model's rotation.
+		bool pauseInstances;
+	};
+
+	// A state ready to draw, interpolated between the last two ticks.
+	struct SimulationFrame
+	{
+		SimulationState state;
+		// Nothing will change until new input arrives, and this frame
+		// already shows the final state.
+		bool settled;
+	};
+
+	// Advances the state in fixed steps, either on its own thread (start)
+	// or synchronously with a caller-chosen timestep (advance) for the
+	// deterministic headless and benchmark runs. Each tick publishes the
+	// previous and current state through a triple buffer, and sample()
+	// blends them by how far the clock has moved into the next step, so
+	// render hitches never change the simulation and the simulation's step
+	// never shows as judder.
+	class Simulation
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+		static constexpr float kStepSeconds = 1.0f / 120.0f;
+
+		Simulation();
+		~Simulation();
+
+		Simulation(const Simulation &) = delete;
+		Simulation &operator=(const Simulation &) = delete;
+
+		void reset(const SimulationState &state, const SimulationSettings &settings);
+		void start();
+		void stop();
+		bool threaded() const { return thread_.joinable(); }
+
+		// Replaces the held keys and adds the presses of input.
+		void submitInput(const SimulationInput &input);
+		// Synchronous mode only.
+		void advance(float dt);
+		void setPose(const Vec3 &translation, float rotationAngle);
+
+		SimulationFrame sample(Clock::time_point now);
+
+	private:
+		struct Snapshot
+		{
+			SimulationState previous;
+			SimulationState current;
+			Clock::time_point time;
+			uint64_t inputSerial;
+			bool atRest;
+			// previous and current draw the same, so any blend factor
+			// shows the final state.
+			bool still;
+		};
+
+		static void tick(SimulationState &state, const SimulationSettings &settings, const SimulationInput &input, float dt);
+		bool atRest() const;
+		SimulationInput takeInput();
+		void publish(const SimulationState &previous, Clock::time_point time);
+		void run();
+
+		SimulationState state_;
+		SimulationSettings settings_;
+		TripleBuffer<Snapshot> snapshots_;
+
+		std::mutex inputMutex_;
+		std::condition_variable wake_;
+		SimulationInput pendingInput_;
+		// Bumped by every active input; a snapshot records the last serial
+		// it has consumed, so the reader can tell stale snapshots apart.
+		uint64_t inputSerial_;
+		uint64_t consumedSerial_;
+		uint64_t readerSerial_;
+		bool stopping_;
+		std::thread thread_;
+	};
+
+} // namespace scop
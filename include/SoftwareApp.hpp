@@ -0,0 +1,97 @@
+#pragma once
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "AppOptions.hpp"
+#include "Math.hpp"
+#include "SceneGeometry.hpp"
+#include "Simulation.hpp"
+#include "SoftwareRasterizer.hpp"
+#include "TextureLoader.hpp"
+#include "ThreadPool.hpp"
+
+namespace scop
+{
+
+	// The viewer on SoftwareRasterizer instead of Vulkan: same models,
+	// controls, framing and shading, for machines without a Vulkan driver.
+	// Frames go to a GLFW window through an OpenGL context, or to PPM files
+	// with --headless.
+	class SoftwareApp
+	{
+	public:
+		explicit SoftwareApp(const AppOptions &options);
+		~SoftwareApp();
+
+		SoftwareApp(const SoftwareApp &) = delete;
+		SoftwareApp &operator=(const SoftwareApp &) = delete;
+
+		void run(const std::vector<std::string> &modelPaths, const std::string &texturePath);
+
+	private:
+		static constexpr uint32_t WIDTH = 1920U;
+		static constexpr uint32_t HEIGHT = 1080U;
+
+		// The OpenGL 1.1 calls the window needs, loaded through GLFW so the
+		// binary does not link against an OpenGL library.
+		struct GlFunctions
+		{
+			void (*viewport)(int x, int y, int width, int height);
+			void (*rasterPos2f)(float x, float y);
+			void (*pixelZoom)(float x, float y);
+			void (*drawPixels)(int width, int height, unsigned int format, unsigned int type, const void *pixels);
+		};
+
+		void initWindow();
+		void loadAssets(const std::vector<std::string> &modelPaths, const std::string &texturePath);
+		void mainLoop();
+		void renderHeadless();
+		void processEvents(bool &running);
+		// Advances the simulation and rasterizes one frame at the target size.
+		void renderFrame(float dt);
+		void present();
+		void writeFrame(std::size_t frame) const;
+		void updateProjection();
+		int swapInterval() const;
+		std::string rasterSummary() const;
+		void cleanup();
+
+		bool headless() const { return options_.headlessFrames > 0U; }
+
+		AppOptions options_;
+		GLFWwindow *window_;
+		GlFunctions gl_;
+		std::optional<ThreadPool> threadPool_;
+		SoftwareRasterizer rasterizer_;
+		uint32_t width_;
+		uint32_t height_;
+
+		SceneGeometry scene_;
+		// Indices rebased onto the shared vertex array.
+		std::vector<uint32_t> indices_;
+		TextureImage textureData_;
+		bool hasRealTexture_;
+		bool hasMaterial_;
+		Vec3 materialKd_;
+		Vec3 materialKs_;
+		float materialNs_;
+
+		Simulation simulation_;
+		SimulationState frameState_;
+		Mat4 viewProjection_;
+		float fieldExtent_;
+
+		bool prevEscape_;
+		bool prevT_;
+		bool prevSpace_;
+		bool prevR_;
+	};
+
+} // namespace scop
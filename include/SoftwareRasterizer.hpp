@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Math.hpp"
+#include "Mesh.hpp"
+#include "TextureLoader.hpp"
+
+namespace scop
+{
+
+	class ThreadPool;
+
+	// One indexed triangle list; indices are absolute into vertices.
+	struct RasterMesh
+	{
+		const Vertex *vertices;
+		std::size_t vertexCount;
+		const uint32_t *indices;
+		std::size_t indexCount;
+	};
+
+	// What mesh.vert and mesh.frag read from push constants, uniforms and
+	// specialization constants for one draw.
+	struct RasterUniforms
+	{
+		Mat4 mvp;
+		Mat4 normalMatrix;
+		float blend;
+		bool textured;
+		bool material;
+		Vec3 kd;
+		Vec3 ks;
+		float ns;
+	};
+
+	struct RasterStats
+	{
+		std::size_t triangles;
+		// Left after near-plane and guard-band clipping, with degenerate
+		// and off-screen ones dropped; clipping can add some.
+		std::size_t setupTriangles;
+		// Triangle references across all tile bins.
+		std::size_t binnedTriangles;
+		double vertexMs;
+		double binMs;
+		double rasterMs;
+	};
+
+	// CPU renderer for the viewer's mesh shading, for machines without a
+	// Vulkan driver. A frame runs in three parallel passes: vertices are
+	// transformed, triangles are clipped, set up and binned into 64x64
+	// tiles in fixed chunks, and every tile is then rasterized by one
+	// thread. Coverage uses 4-wide integer edge functions on a 1/16 pixel
+	// grid with the top-left rule, and the depth test keeps a triangle id
+	// per pixel so each visible pixel is shaded once. Bins are walked in
+	// submission order, so the image does not depend on the thread count.
+	class SoftwareRasterizer
+	{
+	public:
+		static constexpr uint32_t kTileSize = 64U;
+
+		// nullptr renders on the calling thread.
+		explicit SoftwareRasterizer(ThreadPool *pool);
+
+		// srgbOutput encodes like the Vulkan backend's sRGB targets; otherwise
+		// the linear result is stored as is.
+		void resize(uint32_t width, uint32_t height, bool srgbOutput);
+		// Decoded once to linear RGB; an empty image disables texturing.
+		void setTexture(const TextureImage &texture);
+		void render(const RasterMesh &mesh, const RasterUniforms &uniforms);
+
+		uint32_t width() const { return width_; }
+		uint32_t height() const { return height_; }
+		// RGBA8, rows top to bottom.
+		const std::vector<std::uint8_t> &pixels() const { return pixels_; }
+		const RasterStats &stats() const { return stats_; }
+
+	private:
+		struct Plane
+		{
+			float dx;
+			float dy;
+			float origin;
+		};
+
+		// Set up in screen space. Edge values are relative to the pixel
+		// centre at (minX, minY), with the fill-rule bias folded in; planes
+		// are evaluated at the same origin.
+		struct Triangle
+		{
+			int32_t minX;
+			int32_t minY;
+			int32_t maxX;
+			int32_t maxY;
+			int64_t edgeOrigin[3];
+			int32_t edgeDx[3];
+			int32_t edgeDy[3];
+			Plane depth;
+			Plane invW;
+			Plane uOverW;
+			Plane vOverW;
+			Plane normalOverW[3];
+		};
+
+		// The triangles of one fixed range of the index buffer, with the
+		// per-tile lists referencing them. Ranges are processed in parallel
+		// and never share state.
+		struct Chunk
+		{
+			std::vector<Triangle> triangles;
+			std::vector<std::vector<uint32_t>> bins;
+		};
+
+		// Splits [0, count) like ThreadPool::parallelFor, or hands all of it
+		// to body at once without a pool; bodies walk their range in grain
+		// steps either way.
+		void runParallel(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)> &body);
+		void transformVertices(const RasterMesh &mesh, const RasterUniforms &uniforms, std::size_t begin, std::size_t end);
+		void setupChunk(const RasterMesh &mesh, std::size_t chunkIndex, std::size_t begin, std::size_t end);
+		void rasterizeTile(std::size_t tile, const RasterUniforms &uniforms);
+
+		ThreadPool *pool_;
+		uint32_t width_;
+		uint32_t height_;
+		bool srgbOutput_;
+		uint32_t tilesX_;
+		uint32_t tilesY_;
+		float guardX_;
+		float guardY_;
+		std::vector<std::uint8_t> pixels_;
+		std::vector<Vec4> clipPositions_;
+		std::vector<Vec3> normals_;
+		std::vector<Chunk> chunks_;
+		std::size_t chunkCount_;
+		uint32_t textureWidth_;
+		uint32_t textureHeight_;
+		std::vector<float> texels_;
+		RasterStats stats_;
+	};
+
+} // namespace scop
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <cstdint>
+#include <istream>
 #include <string>
 #include <vector>
 
+#include "MemoryTracker.hpp"
+
 namespace scop
 {
 
@@ -11,7 +14,7 @@ namespace scop
 	{
 		uint32_t width;
 		uint32_t height;
-		std::vector<std::uint8_t> pixels;
+		TrackedVector<std::uint8_t, MemoryTag::Texture> pixels;
 
 		bool empty() const;
 	};
@@ -20,7 +23,11 @@ namespace scop
 	{
 	public:
 		static TextureImage loadPPM(const std::string &path);
+		// P6 or P3 data from a binary stream; path only names it in errors.
+		static TextureImage decodePPM(std::istream &file, const std::string &path);
 		static TextureImage makeFallbackCheckerboard();
+		// Nearest-neighbour resample, used to give texture array layers one size.
+		static TextureImage resized(const TextureImage &image, uint32_t width, uint32_t height);
 	};
 
 } // namespace scop
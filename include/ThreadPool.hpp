@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scop
+{
+
+	// Fixed set of worker threads fed from one task queue. parallelFor splits
+	// a range into chunks, runs them on the workers and on the calling thread,
+	// and returns once every chunk has finished.
+	class ThreadPool
+	{
+	public:
+		// 0 picks hardware_concurrency() - 1 workers (the caller is the last).
+		explicit ThreadPool(std::size_t workerCount = 0U);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool &operator=(const ThreadPool &) = delete;
+
+		std::size_t workerCount() const { return workers_.size(); }
+
+		void parallelFor(std::size_t count, std::size_t grain,
+						 const std::function<void(std::size_t begin, std::size_t end)> &body);
+
+	private:
+		void workerLoop(std::size_t index);
+
+		std::vector<std::thread> workers_;
+		std::deque<std::function<void()>> tasks_;
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		bool stopping_;
+	};
+
+} // namespace scop
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace scop
+{
+
+	// Single-producer, single-consumer hand-off of the newest value without
+	// locks. The writer fills back() and publishes it by swapping it with
+	// the middle slot; the reader swaps the middle slot into its front slot
+	// only when something new was published, so neither side ever waits
+	// and the reader always sees a complete value.
+	template <typename T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer()
+			: slots_{},
+			  back_(0U),
+			  middle_(1U),
+			  front_(2U) {}
+
+		TripleBuffer(const TripleBuffer &) = delete;
+		TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+		T &back() { return slots_[back_]; }
+
+		void publish()
+		{
+			back_ = static_cast<uint8_t>(middle_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel) & kIndexMask);
+		}
+
+		const T &read()
+		{
+			if ((middle_.load(std::memory_order_relaxed) & kFresh) != 0U)
+			{
+				front_ = static_cast<uint8_t>(middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask);
+			}
+			return slots_[front_];
+		}
+
+	private:
+		static constexpr uint8_t kIndexMask = 3U;
+		static constexpr uint8_t kFresh = 4U;
+
+		std::array<T, 3> slots_;
+		uint8_t back_;
+		alignas(64) std::atomic<uint8_t> middle_;
+		alignas(64) uint8_t front_;
+	};
+
+} // namespace scop
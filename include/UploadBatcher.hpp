@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "GpuAllocator.hpp"
+
+namespace scop
+{
+
+	// Records every staging copy and layout transition into a single command
+	// buffer. When the device exposes a transfer-only queue family the copies
+	// run there and ownership is handed to the graphics queue with a
+	// release/acquire barrier pair chained by a semaphore. Completion is
+	// tracked with a fence; staging memory is returned to the allocator only
+	// once that fence has signalled.
+	class UploadBatcher
+	{
+	public:
+		UploadBatcher();
+		~UploadBatcher();
+
+		UploadBatcher(const UploadBatcher &) = delete;
+		UploadBatcher &operator=(const UploadBatcher &) = delete;
+
+		void init(VkDevice device, GpuAllocator &allocator,
+				  uint32_t graphicsFamily, VkQueue graphicsQueue,
+				  uint32_t transferFamily, VkQueue transferQueue);
+		void shutdown();
+
+		void uploadBuffer(const void *data, VkDeviceSize size, VkBuffer dst,
+						  VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+		// data holds layerCount tightly packed width x height layers.
+		void uploadImage(const void *data, VkDeviceSize size, VkImage dst, uint32_t width, uint32_t height,
+						 uint32_t layerCount, VkPipelineStageFlags dstStage);
+
+		void submit();
+		bool collect();
+		void wait();
+
+		bool usesTransferQueue() const { return transferFamily_ != graphicsFamily_; }
+		bool pending() const { return !inFlight_.empty() || recording_; }
+
+	private:
+		struct Staging
+		{
+			VkBuffer buffer;
+			GpuAllocation allocation;
+		};
+
+		struct BufferAcquire
+		{
+			VkBuffer buffer;
+			VkPipelineStageFlags dstStage;
+			VkAccessFlags dstAccess;
+		};
+
+		struct ImageAcquire
+		{
+			VkImage image;
+			VkPipelineStageFlags dstStage;
+		};
+
+		void begin();
+		Staging createStaging(const void *data, VkDeviceSize size);
+		void releaseStaging();
+
+		VkDevice device_;
+		GpuAllocator *allocator_;
+		uint32_t graphicsFamily_;
+		uint32_t transferFamily_;
+		VkQueue graphicsQueue_;
+		VkQueue transferQueue_;
+
+		VkCommandPool transferPool_;
+		VkCommandPool graphicsPool_;
+		VkCommandBuffer transferCommands_;
+		VkCommandBuffer acquireCommands_;
+		VkSemaphore transferDone_;
+		VkFence fence_;
+		bool recording_;
+
+		std::vector<Staging> recorded_;
+		std::vector<Staging> inFlight_;
+		std::vector<BufferAcquire> bufferAcquires_;
+		std::vector<ImageAcquire> imageAcquires_;
+	};
+
+} // namespace scop
@@ -1,49 +1,65 @@
 #version 450
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
-    mat4 view;
-    mat4 proj;
-    vec4 params; // x = blend, y = hasRealTexture, z = hasMaterial
+layout(binding = 0) uniform FrameUniforms {
+    vec4 params; // x = blend
+} frame;
+
+// Baked per pipeline variant so untextured or material-less draws carry
+// neither the texture fetch nor the branches.
+layout(constant_id = 0) const bool kTextured = true;
+layout(constant_id = 1) const bool kMaterial = true;
+// Whether any instance lacks a texture layer. The layer is chosen per
+// instance, and one draw can mix textured and untextured instances of a
+// model, so a pipeline per draw cannot resolve it; only then does the
+// textured variant keep the per-fragment test.
+layout(constant_id = 2) const bool kUntexturedInstances = true;
+
+// Layer 0 is the default texture, scene textures follow.
+layout(binding = 1) uniform sampler2DArray texSampler;
+
+struct Material {
     vec4 kd;
     vec4 ksNs;
-} ubo;
+};
 
-layout(binding = 1) uniform sampler2D texSampler;
+// Slot 0 is the model's material, 1-7 tinted variants used by instances.
+layout(binding = 2) uniform MaterialUniforms {
+    Material entries[8];
+} materials;
 
 layout(location = 0) in vec2 fragUV;
 layout(location = 1) in vec3 fragNormal;
+layout(location = 2) flat in uint fragMaterial;
+// 0xFFFFFFFF: the instance has no texture and keeps the material colour.
+layout(location = 3) flat in uint fragTextureLayer;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
+    Material material = materials.entries[fragMaterial];
     vec3 N = normalize(fragNormal);
     vec3 L = normalize(vec3(0.45, 0.85, 0.35));
     vec3 V = normalize(vec3(0.0, 0.0, 1.0));
     vec3 R = reflect(-L, N);
 
     float diffuse = max(dot(N, L), 0.0);
-    float specular = pow(max(dot(R, V), 0.0), max(ubo.ksNs.w, 1.0));
+    float specular = pow(max(dot(R, V), 0.0), max(material.ksNs.w, 1.0));
 
     vec4 whiteColor = vec4(1.0, 1.0, 1.0, 1.0);
-    vec4 materialColor = vec4(ubo.kd.rgb, 1.0);
-    vec4 texColor = texture(texSampler, fragUV);
-
-    float blend = clamp(ubo.params.x, 0.0, 1.0);
-    float hasRealTexture = ubo.params.y;
-    float hasMaterial = ubo.params.z;
+    vec4 materialColor = vec4(material.kd.rgb, 1.0);
+    float blend = clamp(frame.params.x, 0.0, 1.0);
 
     vec4 targetColor = whiteColor;
-    if (hasRealTexture > 0.5) {
-        targetColor = texColor;
-    } else if (hasMaterial > 0.5) {
+    if (kTextured && (!kUntexturedInstances || fragTextureLayer != 0xFFFFFFFFu)) {
+        targetColor = texture(texSampler, vec3(fragUV, float(fragTextureLayer)));
+    } else if (kMaterial) {
         targetColor = materialColor;
     }
 
     vec4 baseColor = mix(whiteColor, targetColor, blend);
 
     float shade = 0.55 + 0.45 * diffuse;
-    vec3 spec = ubo.ksNs.rgb * specular * 0.18;
+    vec3 spec = material.ksNs.rgb * specular * 0.18;
 
     outColor = vec4(baseColor.rgb * shade + spec, 1.0);
 }
\ No newline at end of file
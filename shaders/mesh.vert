@@ -5,20 +5,28 @@ layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inUV;
 layout(location = 3) in vec3 inNormal;
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
-    mat4 view;
-    mat4 proj;
-    vec4 params;
-} ubo;
+// Per instance: model matrix (locations 4-7), material slot and texture
+// array layer.
+layout(location = 4) in mat4 inInstanceModel;
+layout(location = 8) in uint inMaterial;
+layout(location = 9) in uint inTextureLayer;
+
+layout(push_constant) uniform MeshPushConstants {
+    mat4 mvp;
+    mat4 normalMatrix;
+} pc;
 
 layout(location = 0) out vec2 fragUV;
 layout(location = 1) out vec3 fragNormal;
+layout(location = 2) flat out uint fragMaterial;
+layout(location = 3) flat out uint fragTextureLayer;
 
 void main() {
-    mat3 normalMatrix = mat3(ubo.model);
-
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPos, 1.0);
+    gl_Position = pc.mvp * inInstanceModel * vec4(inPos, 1.0);
     fragUV = inUV;
-    fragNormal = normalize(normalMatrix * inNormal);
+    // Instance transforms are rigid (rotation + translation), so their upper
+    // 3x3 is already a valid normal matrix.
+    fragNormal = normalize(mat3(pc.normalMatrix) * mat3(inInstanceModel) * inNormal);
+    fragMaterial = inMaterial;
+    fragTextureLayer = inTextureLayer;
 }
\ No newline at end of file
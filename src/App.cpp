@@ -1,12 +1,19 @@
 #include "App.hpp"
 
 #include "FileUtils.hpp"
+#include "FrameLimiter.hpp"
+#include "FrameStats.hpp"
+#include "MemoryTracker.hpp"
 #include "ObjLoader.hpp"
+#include "Profiler.hpp"
 
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <cmath>
 #include <cstring>
+#include <filesystem>
+#include <iomanip>
 #include <iostream>
 #include <limits>
 #include <set>
@@ -14,158 +21,142 @@
 #include <vector>
 #include <fstream>
 #include <sstream>
-#include <cctype>
+#include <utility>
 
 namespace scop
 {
 	namespace
 	{
-		struct ParsedMaterial
+		// Per-frame data, one slot of the dynamic-offset ring per frame in flight.
+		struct FrameUniforms
 		{
-			bool valid;
-			scop::Vec3 kd;
-			scop::Vec3 ks;
-			float ns;
-
-			ParsedMaterial()
-				: valid(false), kd(0.64f, 0.64f, 0.64f), ks(0.50f, 0.50f, 0.50f), ns(96.078431f) {}
+			float params[4];
 		};
 
-		static std::string trim(const std::string &value)
+		// Written once after the model is loaded. Slot 0 is the model's own
+		// material, the others are tinted variants picked per instance.
+		constexpr std::size_t kMaterialSlots = 8U;
+
+		struct MaterialUniforms
 		{
-			std::size_t start = 0;
-			while (start < value.size() && std::isspace(static_cast<unsigned char>(value[start])))
-				++start;
+			struct Entry
+			{
+				float kd[4];
+				float ksNs[4];
+			};
+			Entry entries[kMaterialSlots];
+		};
 
-			std::size_t end = value.size();
-			while (end > start && std::isspace(static_cast<unsigned char>(value[end - 1])))
-				--end;
+		// Binding 1, advanced once per instance: a column-major model matrix
+		// (locations 4-7) and a material slot (location 8).
+		struct InstanceData
+		{
+			float model[16];
+			uint32_t material;
+			uint32_t textureLayer;
+			uint32_t sceneModel;
+			uint32_t padding;
+		};
 
-			return value.substr(start, end - start);
-		}
+		constexpr float kInstanceSpacing = 2.0f;
+		constexpr float kModelSpacing = 2.0f;
+		constexpr std::size_t kInstanceGrain = 4096U;
+		constexpr VkDeviceSize kTextureArrayBudget = 256ULL * 1024ULL * 1024ULL;
+		// Upper bound on one idle wait, so the loop still notices a close
+		// request that arrives without an event.
+		constexpr double kIdleWaitSeconds = 0.25;
 
-		static std::string directoryOf(const std::string &path)
+		// Compute-stage push constants of the culling pass: the frustum of the
+		// root model's mvp plus the instance and model counts and the pass.
+		struct CullPushConstants
 		{
-			const std::size_t slash = path.find_last_of("/\\");
-			if (slash == std::string::npos)
-				return ".";
-			if (slash == 0)
-				return "/";
-			return path.substr(0, slash);
-		}
+			Vec4 planes[6];
+			uint32_t counts[4];
+		};
 
-		static std::string joinPath(const std::string &baseDir, const std::string &path)
+		// Static per-model data read by the culling pass.
+		struct ModelInfo
 		{
-			if (path.empty())
-				return path;
-			if (!path.empty() && (path[0] == '/' || path[0] == '\\'))
-				return path;
-			if (baseDir.empty() || baseDir == ".")
-				return path;
-			if (baseDir.back() == '/' || baseDir.back() == '\\')
-				return baseDir + path;
-			return baseDir + "/" + path;
-		}
+			Vec4 sphere;
+			uint32_t firstInstance;
+			uint32_t firstSubmesh;
+			uint32_t submeshCount;
+			uint32_t instanceCount;
+		};
 
-		static std::string findMtllibInObj(const std::string &objPath)
-		{
-			std::ifstream file(objPath.c_str());
-			if (!file)
-				return "";
+		constexpr uint32_t kCullGroupSize = 64U;
 
-			std::string line;
-			while (std::getline(file, line))
-			{
-				const std::string s = trim(line);
-				if (s.empty() || s[0] == '#')
-					continue;
-				if (s.rfind("mtllib ", 0) == 0)
-					return trim(s.substr(7));
-			}
-			return "";
+		// Draw slices split a model's instance range into equal parts, each
+		// one an indirect command of its own. Culling compacts the visible
+		// instances to the front of the range, so a slice draws the part of
+		// the visible prefix that falls inside it. cull.comp mirrors both.
+		uint32_t sliceStart(uint32_t count, uint32_t slice, uint32_t slices)
+		{
+			return (count / slices) * slice + std::min(slice, count % slices);
 		}
 
-		static ParsedMaterial loadMaterialFromObj(const std::string &objPath)
+		uint32_t sliceVisible(uint32_t visible, uint32_t count, uint32_t slice, uint32_t slices)
 		{
-			ParsedMaterial material;
-
-			const std::string mtllib = findMtllibInObj(objPath);
-			if (mtllib.empty())
-				return material;
+			const uint32_t begin = sliceStart(count, slice, slices);
+			const uint32_t end = sliceStart(count, slice + 1U, slices);
+			return std::min(std::max(visible, begin), end) - begin;
+		}
 
-			const std::string mtlPath = joinPath(directoryOf(objPath), mtllib);
-			std::ifstream file(mtlPath.c_str());
-			if (!file)
-				return material;
+		// Bits of a pipeline variant index, mirrored by the fragment shader's
+		// specialization constants.
+		constexpr std::size_t kVariantMaterial = 1U;
+		constexpr std::size_t kVariantTextured = 2U;
+		// Only with kVariantTextured: keeps the per-fragment test for
+		// instances without a texture layer.
+		constexpr std::size_t kVariantUntextured = 4U;
 
-			std::string line;
-			while (std::getline(file, line))
+		const char *shadingVariantName(std::size_t variant)
+		{
+			switch (variant & (kVariantTextured | kVariantMaterial))
 			{
-				const std::string s = trim(line);
-				if (s.empty() || s[0] == '#')
-					continue;
-
-				std::istringstream iss(s);
-				std::string key;
-				iss >> key;
-
-				if (key == "Kd")
-				{
-					float r, g, b;
-					if (iss >> r >> g >> b)
-					{
-						material.kd = scop::Vec3(r, g, b);
-						material.valid = true;
-					}
-				}
-				else if (key == "Ks")
-				{
-					float r, g, b;
-					if (iss >> r >> g >> b)
-					{
-						material.ks = scop::Vec3(r, g, b);
-						material.valid = true;
-					}
-				}
-				else if (key == "Ns")
-				{
-					float ns;
-					if (iss >> ns)
-					{
-						material.ns = ns;
-						material.valid = true;
-					}
-				}
+			case kVariantMaterial:
+				return "material";
+			case kVariantTextured:
+				return "textured";
+			case kVariantTextured | kVariantMaterial:
+				return "textured+material";
+			default:
+				return "plain";
 			}
-
-			return material;
 		}
 
-		struct UniformBufferObject
+		// Start of every draw-argument slot, followed by one uint32_t visible
+		// instance counter per model and one VkDrawIndexedIndirectCommand per
+		// submesh instance slice. drawCount is the count buffer of
+		// vkCmdDrawIndexedIndirectCount.
+		struct DrawHeader
 		{
-			Mat4 model;
-			Mat4 view;
-			Mat4 proj;
-			float params[4];
-			float kd[4];
-			float ksNs[4];
+			uint32_t drawCount;
+			uint32_t padding[3];
 		};
 
+		static_assert(sizeof(MeshPushConstants) == 128U, "push constants must fit the guaranteed 128 bytes");
+		static_assert(sizeof(CullPushConstants) <= 128U, "push constants must fit the guaranteed 128 bytes");
+
 		const std::vector<const char *> kDeviceExtensions = {
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
-		VkVertexInputBindingDescription getVertexBindingDescription()
+		std::array<VkVertexInputBindingDescription, 2> getVertexBindingDescriptions()
 		{
-			VkVertexInputBindingDescription bindingDescription{};
-			bindingDescription.binding = 0;
-			bindingDescription.stride = sizeof(Vertex);
-			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-			return bindingDescription;
+			std::array<VkVertexInputBindingDescription, 2> bindingDescriptions{};
+			bindingDescriptions[0].binding = 0;
+			bindingDescriptions[0].stride = sizeof(Vertex);
+			bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			bindingDescriptions[1].binding = 1;
+			bindingDescriptions[1].stride = sizeof(InstanceData);
+			bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+			return bindingDescriptions;
 		}
 
-		std::array<VkVertexInputAttributeDescription, 4> getVertexAttributeDescriptions()
+		std::array<VkVertexInputAttributeDescription, 10> getVertexAttributeDescriptions()
 		{
-			std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions{};
+			std::array<VkVertexInputAttributeDescription, 10> attributeDescriptions{};
 
 			attributeDescriptions[0].binding = 0;
 			attributeDescriptions[0].location = 0;
@@ -187,52 +178,104 @@ namespace scop
 			attributeDescriptions[3].format = VK_FORMAT_R32G32B32_SFLOAT;
 			attributeDescriptions[3].offset = offsetof(Vertex, normal);
 
+			for (uint32_t column = 0; column < 4U; ++column)
+			{
+				attributeDescriptions[4U + column].binding = 1;
+				attributeDescriptions[4U + column].location = 4U + column;
+				attributeDescriptions[4U + column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+				attributeDescriptions[4U + column].offset = offsetof(InstanceData, model) + column * 4U * sizeof(float);
+			}
+
+			attributeDescriptions[8].binding = 1;
+			attributeDescriptions[8].location = 8;
+			attributeDescriptions[8].format = VK_FORMAT_R32_UINT;
+			attributeDescriptions[8].offset = offsetof(InstanceData, material);
+
+			attributeDescriptions[9].binding = 1;
+			attributeDescriptions[9].location = 9;
+			attributeDescriptions[9].format = VK_FORMAT_R32_UINT;
+			attributeDescriptions[9].offset = offsetof(InstanceData, textureLayer);
+
 			return attributeDescriptions;
 		}
 
 	} // namespace
 
-	ScopApp::ScopApp()
-		: window_(nullptr),
+	ScopApp::ScopApp(const AppOptions &options)
+		: options_(options),
+		  framesInFlight_(options.framesInFlight),
+		  window_(nullptr),
 		  instance_(VK_NULL_HANDLE),
 		  surface_(VK_NULL_HANDLE),
 		  physicalDevice_(VK_NULL_HANDLE),
 		  device_(VK_NULL_HANDLE),
 		  graphicsQueue_(VK_NULL_HANDLE),
 		  presentQueue_(VK_NULL_HANDLE),
+		  transferQueue_(VK_NULL_HANDLE),
 		  swapChain_(VK_NULL_HANDLE),
 		  swapChainImageFormat_(VK_FORMAT_UNDEFINED),
+		  swapChainPresentMode_(VK_PRESENT_MODE_FIFO_KHR),
+		  instanceApiVersion_(VK_API_VERSION_1_0),
+		  presentWaitSupported_(false),
+		  inheritedQueries_(false),
+		  waitForPresent_(nullptr),
+		  lastPresentId_(0U),
 		  renderPass_(VK_NULL_HANDLE),
 		  descriptorSetLayout_(VK_NULL_HANDLE),
 		  pipelineLayout_(VK_NULL_HANDLE),
+		  pipelineVariants_{},
 		  graphicsPipeline_(VK_NULL_HANDLE),
 		  commandPool_(VK_NULL_HANDLE),
+		  fenceWaitMs_(0.0),
 		  depthImage_(VK_NULL_HANDLE),
-		  depthImageMemory_(VK_NULL_HANDLE),
 		  depthImageView_(VK_NULL_HANDLE),
 		  textureImage_(VK_NULL_HANDLE),
-		  textureImageMemory_(VK_NULL_HANDLE),
+		  textureLayerCount_(1U),
 		  textureImageView_(VK_NULL_HANDLE),
 		  textureSampler_(VK_NULL_HANDLE),
 		  vertexBuffer_(VK_NULL_HANDLE),
-		  vertexBufferMemory_(VK_NULL_HANDLE),
 		  indexBuffer_(VK_NULL_HANDLE),
-		  indexBufferMemory_(VK_NULL_HANDLE),
+		  instanceCount_(options.instances),
+		  instanceBuffer_(VK_NULL_HANDLE),
+		  instanceSliceSize_(0U),
+		  fieldExtent_(0.0f),
+		  cullMode_(options.culling),
+		  drawIndexedIndirectCount_(nullptr),
+		  maxDrawsPerCall_(1U),
+		  directDraws_(false),
+		  visibleInstanceCount_(0U),
+		  cullSetLayout_(VK_NULL_HANDLE),
+		  cullPipelineLayout_(VK_NULL_HANDLE),
+		  cullPipeline_(VK_NULL_HANDLE),
+		  cullDescriptorSet_(VK_NULL_HANDLE),
+		  visibleInstanceBuffer_(VK_NULL_HANDLE),
+		  modelInfoBuffer_(VK_NULL_HANDLE),
+		  drawArgumentsBuffer_(VK_NULL_HANDLE),
+		  drawArgumentsStride_(0U),
+		  drawCommandsOffset_(0U),
+		  frameUniformBuffer_(VK_NULL_HANDLE),
+		  frameUniformStride_(0U),
+		  materialBuffer_(VK_NULL_HANDLE),
 		  descriptorPool_(VK_NULL_HANDLE),
+		  descriptorSet_(VK_NULL_HANDLE),
+		  recordPartitions_(1U),
+		  recordThreads_(1U),
+		  drawSlices_(1U),
+		  recordMsTotal_(0.0),
+		  recordedFrames_(0U),
 		  currentFrame_(0U),
 		  framebufferResized_(false),
-		  rotationPaused_(false),
-		  textureEnabled_(true),
+		  redrawRequested_(true),
+		  reloadRequested_(false),
 		  hasRealTexture_(false),
-		  rotationAngle_(0.0f),
-		  rotationSpeed_(0.85f),
-		  textureBlend_(0.0f),
-		  targetTextureBlend_(1.0f),
-		  translation_(0.0f, 0.0f, 0.0f),
+		  untexturedInstances_(false),
+		  frameState_{},
+		  frameSettled_(false),
 		  prevEscape_(false),
 		  prevT_(false),
 		  prevSpace_(false),
 		  prevR_(false),
+		  prevF5_(false),
 		  hasMaterial_(false),
 		  materialKd_(0.64f, 0.64f, 0.64f),
 		  materialKs_(0.50f, 0.50f, 0.50f),
@@ -261,13 +304,48 @@ namespace scop
 		}
 	}
 
-	void ScopApp::run(const std::string &modelPath, const std::string &texturePath)
+	void ScopApp::windowRefreshCallback(GLFWwindow *window)
+	{
+		ScopApp *app = static_cast<ScopApp *>(glfwGetWindowUserPointer(window));
+		if (app != nullptr)
+		{
+			app->redrawRequested_ = true;
+		}
+	}
+
+	void ScopApp::run(const std::vector<std::string> &modelPaths, const std::string &texturePath)
 	{
-		initWindow();
-		loadAssets(modelPath, texturePath);
+		const auto startupBegin = std::chrono::steady_clock::now();
+		MemoryTracker::setHostBudget(options_.hostBudgetMiB * 1024U * 1024U);
+		if (!headless())
+		{
+			initWindow();
+		}
+		modelPaths_ = modelPaths;
+		texturePath_ = texturePath;
+		loadAssets();
 		initVulkan();
-		mainLoop();
+		const double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin).count();
+		std::cout << "Startup: " << startupMs << " ms ("
+				  << (pipelineCache_.warm() ? "warm" : "cold") << " pipeline cache)" << std::endl;
+		if (options_.bench)
+		{
+			benchmark_.emplace(options_.benchWarmup, options_.benchFrames);
+		}
+		if (headless())
+		{
+			renderHeadless();
+		}
+		else
+		{
+			mainLoop();
+		}
+		const bool benchmarkPassed = !benchmark_.has_value() || finishBenchmark();
 		cleanup();
+		if (!benchmarkPassed)
+		{
+			throw std::runtime_error("Benchmark regressed against " + options_.benchBaselinePath);
+		}
 	}
 
 	void ScopApp::initWindow()
@@ -280,9 +358,10 @@ namespace scop
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
+		const VkExtent2D extent = requestedExtent();
 		window_ = glfwCreateWindow(
-			static_cast<int>(WIDTH),
-			static_cast<int>(HEIGHT),
+			static_cast<int>(extent.width),
+			static_cast<int>(extent.height),
 			"scop - Vulkan OBJ viewer",
 			nullptr,
 			nullptr);
@@ -295,151 +374,535 @@ namespace scop
 
 		glfwSetWindowUserPointer(window_, this);
 		glfwSetFramebufferSizeCallback(window_, ScopApp::framebufferResizeCallback);
+		glfwSetWindowRefreshCallback(window_, ScopApp::windowRefreshCallback);
 	}
 
-	void ScopApp::loadAssets(const std::string &modelPath, const std::string &texturePath)
+	VkExtent2D ScopApp::requestedExtent() const
 	{
-		mesh_ = ObjLoader::loadFromFile(modelPath);
-		centerAndScaleMesh();
-
-		ParsedMaterial parsed = loadMaterialFromObj(modelPath);
-		hasMaterial_ = parsed.valid;
-		materialKd_ = parsed.kd;
-		materialKs_ = parsed.ks;
-		materialNs_ = parsed.ns;
+		VkExtent2D extent{};
+		extent.width = options_.width != 0U ? options_.width : WIDTH;
+		extent.height = options_.height != 0U ? options_.height : HEIGHT;
+		return extent;
+	}
 
-		if (texturePath.empty())
-		{
-			textureData_ = TextureLoader::makeFallbackCheckerboard();
-			hasRealTexture_ = false;
-			textureEnabled_ = false;
-			textureBlend_ = 0.0f;
-			targetTextureBlend_ = 0.0f;
-			return;
-		}
+	void ScopApp::loadAssets()
+	{
+		SCOP_PROFILE_FUNCTION();
+		adoptAssets(fetchAssets());
+
+		frameState_ = SimulationState{};
+		frameState_.translation = Vec3(0.0f, 0.0f, 0.0f);
+		frameState_.textureEnabled = hasRealTexture_;
+		frameState_.textureBlend = hasRealTexture_ ? 1.0f : 0.0f;
+		frameState_.targetTextureBlend = frameState_.textureBlend;
+
+		SimulationSettings settings;
+		settings.rotationSpeed = 0.85f;
+		settings.canBlend = hasRealTexture_ || hasMaterial_;
+		settings.hasTexture = !textureData_.empty();
+		settings.pauseInstances = !options_.bench;
+		simulation_.reset(frameState_, settings);
+	}
 
-		try
+	FetchedAssets ScopApp::fetchAssets()
+	{
+		SCOP_PROFILE_FUNCTION();
+		FetchedAssets assets;
+		SceneGeometry &scene = assets.scene;
+		std::string materialSource;
+		if (!options_.scenePath.empty())
 		{
-			textureData_ = TextureLoader::loadPPM(texturePath);
-			hasRealTexture_ = !textureData_.empty();
+			materialSource = loadSceneFile(options_.scenePath, assets);
 		}
-		catch (const std::exception &e)
+		else
 		{
-			std::cerr << "Warning: " << e.what() << "\nUsing fallback checkerboard texture instead.\n";
-			textureData_ = TextureLoader::makeFallbackCheckerboard();
-			hasRealTexture_ = false;
+			// Models sit side by side along X, each one scaled to the unit size
+			// a single model always had; its o / g groups become submeshes.
+			for (std::size_t i = 0; i < modelPaths_.size(); ++i)
+			{
+				const float offset = kModelSpacing * (static_cast<float>(i) - 0.5f * static_cast<float>(modelPaths_.size() - 1U));
+				scene.addModel(ObjLoader::loadGroupsFromFile(modelPaths_[i]), Vec3(offset, 0.0f, 0.0f));
+			}
+			materialSource = modelPaths_.front();
 		}
+		std::cout << "Scene: " << scene.modelCount() << " model(s), " << scene.submeshes().size() << " submesh(es), "
+				  << scene.vertexCount() << " vertices, " << scene.indexCount() / 3U << " triangles" << std::endl;
+
+		const ObjMaterial parsed = ObjLoader::loadMaterial(materialSource);
+		assets.hasMaterial = parsed.valid;
+		assets.materialKd = parsed.kd;
+		assets.materialKs = parsed.ks;
+		assets.materialNs = parsed.ns;
 
-		if (hasRealTexture_)
+		if (texturePath_.empty())
 		{
-			textureEnabled_ = true;
-			textureBlend_ = 1.0f;
-			targetTextureBlend_ = 1.0f;
+			assets.texture = TextureLoader::makeFallbackCheckerboard();
+			assets.hasRealTexture = false;
 		}
 		else
 		{
-			textureEnabled_ = false;
-			textureBlend_ = 0.0f;
-			targetTextureBlend_ = 0.0f;
+			try
+			{
+				assets.texture = TextureLoader::loadPPM(texturePath_);
+				assets.hasRealTexture = !assets.texture.empty();
+			}
+			catch (const std::exception &e)
+			{
+				std::cerr << "Warning: " << e.what() << "\nUsing fallback checkerboard texture instead.\n";
+				assets.texture = TextureLoader::makeFallbackCheckerboard();
+				assets.hasRealTexture = false;
+			}
+		}
+
+		// Layer 0 of the texture array is the default texture and scene
+		// textures follow it. Placements without a texture use layer 0 only
+		// when it is a real texture, otherwise they keep the material colour.
+		for (ScenePlacement &placement : assets.placements)
+		{
+			if (placement.texture != SceneLoader::kNoTexture)
+			{
+				placement.texture += 1U;
+			}
+			else if (assets.hasRealTexture)
+			{
+				placement.texture = 0U;
+			}
 		}
+		assets.hasRealTexture = assets.hasRealTexture || !assets.sceneTextures.empty();
+		return assets;
+	}
+
+	void ScopApp::adoptAssets(FetchedAssets &&assets)
+	{
+		scene_ = std::move(assets.scene);
+		placements_ = std::move(assets.placements);
+		textureData_ = std::move(assets.texture);
+		sceneTextures_ = std::move(assets.sceneTextures);
+		hasRealTexture_ = assets.hasRealTexture;
+		hasMaterial_ = assets.hasMaterial;
+		materialKd_ = assets.materialKd;
+		materialKs_ = assets.materialKs;
+		materialNs_ = assets.materialNs;
+		// Scene placements keep kNoTexture only without a default texture;
+		// the grid of a single model takes the default texture or none.
+		untexturedInstances_ = placements_.empty()
+								   ? !hasRealTexture_
+								   : std::any_of(placements_.begin(), placements_.end(), [](const ScenePlacement &placement)
+												 { return placement.texture == SceneLoader::kNoTexture; });
 	}
 
-	void ScopApp::centerAndScaleMesh()
+	std::string ScopApp::loadSceneFile(const std::string &path, FetchedAssets &assets)
 	{
-		Vec3 minBounds(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
-		Vec3 maxBounds(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+		SCOP_PROFILE_FUNCTION();
+		const SceneDescription description = SceneLoader::parse(path);
+		SceneAssets loaded = SceneLoader::loadAssets(description, threadPool_);
+		SceneLoader::printStats(std::cout, description, loaded, threadPool_.workerCount() + 1U);
 
-		for (const Vertex &vertex : mesh_.vertices)
+		// Each distinct model is added once at the origin; the placements
+		// become its instances.
+		for (const std::vector<MeshData> &model : loaded.models)
 		{
-			minBounds = minVec(minBounds, vertex.position);
-			maxBounds = maxVec(maxBounds, vertex.position);
+			assets.scene.addModel(model, Vec3(0.0f, 0.0f, 0.0f));
 		}
+		assets.sceneTextures = std::move(loaded.textures);
+		assets.placements = description.placements;
+		return description.modelPaths[description.placements.front().model];
+	}
 
-		const Vec3 center = (minBounds + maxBounds) * 0.5f;
-		const Vec3 extent = maxBounds - minBounds;
-		const float maxExtent = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-4f));
-		const float scale = 1.6f / maxExtent;
-
-		for (Vertex &vertex : mesh_.vertices)
+	void ScopApp::releaseCpuCopies()
+	{
+		if (options_.residency == ResidencyPolicy::Keep)
 		{
-			vertex.position = (vertex.position - center) * scale;
+			std::cout << "Residency: " << residencyPolicyName(options_.residency)
+					  << ", CPU mesh and texture data stays resident" << std::endl;
+			return;
 		}
+		// The uploader copies into staging memory while recording, so the
+		// arrays are no longer read. Submeshes, bounds and counts stay for
+		// culling and the draw arguments; a reload reads the files again.
+		const std::size_t before = MemoryTracker::totalCurrent();
+		scene_.releaseGeometry();
+		textureData_ = TextureImage{};
+		std::vector<TextureImage>().swap(sceneTextures_);
+		const std::size_t released = before - std::min(before, MemoryTracker::totalCurrent());
+		std::cout << "Residency: " << residencyPolicyName(options_.residency) << ", freed " << std::fixed << std::setprecision(2)
+				  << static_cast<double>(released) / (1024.0 * 1024.0) << " MiB of CPU mesh and texture data"
+				  << std::defaultfloat << std::endl;
+	}
 
-		mesh_.bounds.min = (minBounds - center) * scale;
-		mesh_.bounds.max = (maxBounds - center) * scale;
+	void ScopApp::reloadAssets()
+	{
+		SCOP_PROFILE_FUNCTION();
+		reloadRequested_ = false;
+		const auto begin = std::chrono::steady_clock::now();
+		FetchedAssets assets;
+		try
+		{
+			assets = fetchAssets();
+			// The draw path and culling mode were chosen for this model
+			// count when the device was created.
+			if (assets.scene.modelCount() != scene_.modelCount())
+			{
+				throw std::runtime_error("Reload changed the scene from " + std::to_string(scene_.modelCount()) + " to " +
+										 std::to_string(assets.scene.modelCount()) + " models; restart to load it");
+			}
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << "Reload failed: " << e.what() << "\nKeeping the current scene.\n";
+			return;
+		}
+		// Nothing in flight may still reference the buffers, image or
+		// descriptor sets about to be destroyed.
+		vkDeviceWaitIdle(device_);
+		uploader_.collect();
+		destroySceneResources();
+		adoptAssets(std::move(assets));
+		createSceneResources();
+		releaseCpuCopies();
+		const double reloadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		std::cout << "Reload: " << reloadMs << " ms" << std::endl;
+		redrawRequested_ = true;
 	}
 
 	void ScopApp::initVulkan()
 	{
+		SCOP_PROFILE_FUNCTION();
 		createInstance();
-		createSurface();
+		if (!headless())
+		{
+			createSurface();
+		}
 		pickPhysicalDevice();
 		createLogicalDevice();
-		createSwapChain();
+		if (headless())
+		{
+			createOffscreenTargets();
+		}
+		else
+		{
+			createSwapChain();
+		}
 		createImageViews();
+		updateProjection();
 		createRenderPass();
 		createDescriptorSetLayout();
+
+		const auto pipelineBegin = std::chrono::steady_clock::now();
 		createGraphicsPipeline();
+		const double pipelineMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pipelineBegin).count();
+		const std::size_t builtVariants = static_cast<std::size_t>(
+			std::count_if(pipelineVariants_.begin(), pipelineVariants_.end(),
+						  [](VkPipeline pipeline) { return pipeline != VK_NULL_HANDLE; }));
+		std::cout << "Graphics pipeline: " << pipelineMs << " ms for " << builtVariants << " variant(s), "
+				  << (pipelineCache_.warm() ? "warm cache (" + std::to_string(pipelineCache_.loadedBytes()) + " bytes)" : std::string("cold cache"))
+				  << " at " << pipelineCache_.path() << "; shading " << shadingModeName(options_.shading)
+				  << " (" << shadingVariantName(shadingVariant()) << ")" << std::endl;
+
 		createCommandPool();
 		createDepthResources();
 		createFramebuffers();
-		createTextureImage();
-		createTextureImageView();
 		createTextureSampler();
-		createVertexBuffer();
-		createIndexBuffer();
 		createUniformBuffers();
-		createDescriptorPool();
-		createDescriptorSets();
+		createSceneResources();
 		createCommandBuffers();
 		createSyncObjects();
+		releaseCpuCopies();
+
+		allocator_.printStats(std::cout);
+		MemoryTracker::printStats(std::cout);
+		pipelineCache_.save();
 	}
 
 	void ScopApp::mainLoop()
 	{
 		bool running = true;
+		FrameLimiter limiter(options_.targetFps);
+		FrameStats stats(5.0);
+		const bool idleEnabled = options_.idle && !benchmark_;
+
+		std::cout << "Present mode: " << presentModeName(swapChainPresentMode_)
+				  << ", frames in flight: " << framesInFlight_
+				  << ", frame cap: " << (limiter.enabled() ? std::to_string(static_cast<int>(options_.targetFps)) + " fps" : std::string("off"))
+				  << ", late latch: " << (options_.lateLatch ? "on" : "off")
+				  << ", present timing: " << (presentWaitSupported_ ? "VK_KHR_present_wait" : "unavailable")
+				  << ", culling: " << cullModeName(cullMode_)
+				  << ", recording: " << recordPartitions_ << " partition(s)"
+				  << ", idle: " << (idleEnabled ? "on" : "off")
+				  << std::endl;
+
+		// Benchmark poses are applied per frame, so the benchmark keeps the
+		// simulation on the render thread with its fixed timestep.
+		if (!benchmark_)
+		{
+			simulation_.start();
+		}
+
 		auto previous = std::chrono::high_resolution_clock::now();
+		auto lastTitleUpdate = previous;
+		previousDrawTime_ = previous;
 
 		while (running)
 		{
+			SCOP_PROFILE_ZONE("Frame");
+			if (idleEnabled && sceneIsStatic())
+			{
+				// The last submitted frame already shows this state: block
+				// until an event arrives instead of acquiring, recording and
+				// presenting the same image again.
+				SCOP_PROFILE_ZONE("Idle");
+				idleMonitor_.sample(true);
+				glfwWaitEventsTimeout(kIdleWaitSeconds);
+				processEvents(running);
+				previous = std::chrono::high_resolution_clock::now();
+				previousDrawTime_ = previous;
+				continue;
+			}
+			if (idleEnabled)
+			{
+				idleMonitor_.sample(false);
+			}
+			{
+				SCOP_PROFILE_ZONE("Frame limiter");
+				limiter.wait();
+			}
+
 			auto current = std::chrono::high_resolution_clock::now();
 			const float dt = std::chrono::duration<float>(current - previous).count();
 			previous = current;
 
-			processEvents(running, dt);
-			drawFrame();
+			stats.addFrame(static_cast<double>(dt) * 1000.0);
+			if (stats.reportDue())
+			{
+				stats.report(std::cout);
+				latency_.report(std::cout, presentWaitSupported_);
+				gpuProfiler_.report(std::cout);
+				std::cout << "Culling: " << cullingSummary() << std::endl;
+				std::cout << "Recording: " << recordingSummary() << std::endl;
+				if (idleEnabled)
+				{
+					idleMonitor_.report(std::cout);
+				}
+			}
+			if (current - lastTitleUpdate >= std::chrono::milliseconds(500))
+			{
+				std::string title = "scop - Vulkan OBJ viewer | ";
+				if (gpuProfiler_.hasSamples())
+				{
+					title += gpuProfiler_.titleSummary() + " | ";
+				}
+				title += cullingSummary();
+				glfwSetWindowTitle(window_, title.c_str());
+				lastTitleUpdate = current;
+			}
+
+			if (!options_.lateLatch)
+			{
+				processEvents(running);
+			}
+			if (reloadRequested_)
+			{
+				reloadAssets();
+			}
+			if (benchmark_)
+			{
+				applyBenchmarkPose();
+			}
+			drawFrame(running);
+			redrawRequested_ = false;
+
+			if (benchmark_)
+			{
+				const double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - current).count();
+				benchmark_->addFrame(cpuMs, fenceWaitMs_);
+				running = running && !benchmark_->done();
+			}
 		}
 
+		simulation_.stop();
 		vkDeviceWaitIdle(device_);
+		for (std::size_t slot = 0; slot < framesInFlight_; ++slot)
+		{
+			collectGpuTiming(slot);
+		}
+		stats.printSummary(std::cout);
+		if (idleEnabled)
+		{
+			idleMonitor_.sample(false);
+			idleMonitor_.printSummary(std::cout);
+		}
 	}
 
-	void ScopApp::cleanupSwapChain()
+	bool ScopApp::sceneIsStatic() const
+	{
+		return frameSettled_ && !redrawRequested_ && !framebufferResized_;
+	}
+
+	void ScopApp::renderHeadless()
 	{
-		if (!commandBuffers_.empty())
+		// Fixed timestep so the rotation, and therefore every dumped frame,
+		// is identical from run to run.
+		const float dt = 1.0f / 60.0f;
+		FrameStats stats(5.0);
+
+		std::cout << "Headless: " << options_.headlessFrames << " frames at " << swapChainExtent_.width << "x"
+				  << swapChainExtent_.height << ", frames in flight: " << framesInFlight_
+				  << ", frame dump: " << (options_.dumpFramesDir.empty() ? std::string("off") : options_.dumpFramesDir)
+				  << ", culling: " << cullModeName(cullMode_)
+				  << ", recording: " << recordPartitions_ << " partition(s)"
+				  << std::endl;
+
+		const auto begin = std::chrono::steady_clock::now();
+		auto previous = begin;
+		for (std::size_t frame = 0; frame < options_.headlessFrames; ++frame)
+		{
+			SCOP_PROFILE_ZONE("Headless frame");
+			const auto frameBegin = std::chrono::steady_clock::now();
+			{
+				SCOP_PROFILE_ZONE("Wait frame fence");
+				vkWaitForFences(device_, 1U, &inFlightFences_[currentFrame_], VK_TRUE, UINT64_MAX);
+			}
+			fenceWaitMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameBegin).count();
+			uploader_.collect();
+			collectGpuTiming(currentFrame_);
+			writeReadback(currentFrame_);
+			if (benchmark_)
+			{
+				applyBenchmarkPose();
+			}
+
+			const uint32_t imageIndex = static_cast<uint32_t>(currentFrame_);
+			const MeshPushConstants pushConstants = updateFrameData(currentFrame_, dt);
+			recordCommandBuffer(commandBuffers_[currentFrame_], imageIndex, pushConstants);
+			if (!readbackBuffers_.empty())
+			{
+				readbackFrames_[currentFrame_] = frame;
+			}
+
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1U;
+			submitInfo.pCommandBuffers = &commandBuffers_[currentFrame_];
+
+			vkResetFences(device_, 1U, &inFlightFences_[currentFrame_]);
+			if (vkQueueSubmit(graphicsQueue_, 1U, &submitInfo, inFlightFences_[currentFrame_]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to submit headless frame");
+			}
+			currentFrame_ = (currentFrame_ + 1U) % framesInFlight_;
+
+			const auto now = std::chrono::steady_clock::now();
+			if (benchmark_)
+			{
+				benchmark_->addFrame(std::chrono::duration<double, std::milli>(now - frameBegin).count(), fenceWaitMs_);
+			}
+			stats.addFrame(std::chrono::duration<double, std::milli>(now - previous).count());
+			previous = now;
+			if (stats.reportDue())
+			{
+				stats.report(std::cout);
+				gpuProfiler_.report(std::cout);
+				std::cout << "Culling: " << cullingSummary() << std::endl;
+				std::cout << "Recording: " << recordingSummary() << std::endl;
+			}
+		}
+
+		vkDeviceWaitIdle(device_);
+		for (std::size_t slot = 0; slot < framesInFlight_; ++slot)
 		{
-			vkFreeCommandBuffers(device_, commandPool_, static_cast<uint32_t>(commandBuffers_.size()), commandBuffers_.data());
-			commandBuffers_.clear();
+			collectGpuTiming(slot);
+			writeReadback(slot);
 		}
 
-		for (std::size_t i = 0; i < uniformBuffers_.size(); ++i)
+		const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		std::cout << "Headless: rendered " << options_.headlessFrames << " frames in " << totalMs << " ms ("
+				  << static_cast<double>(options_.headlessFrames) * 1000.0 / totalMs << " fps)" << std::endl;
+		stats.printSummary(std::cout);
+		gpuProfiler_.report(std::cout);
+		std::cout << "Culling: " << cullingSummary() << std::endl;
+		std::cout << "Recording: " << recordingSummary() << std::endl;
+	}
+
+	void ScopApp::applyBenchmarkPose()
+	{
+		const BenchmarkPose pose = Benchmark::pose(benchmark_->frameIndex());
+		simulation_.setPose(pose.translation, pose.rotation);
+	}
+
+	void ScopApp::collectGpuTiming(std::size_t slot)
+	{
+		if (!gpuProfiler_.collect(slot))
 		{
-			if (uniformBuffersMapped_[i] != nullptr)
+			return;
+		}
+		idleMonitor_.addGpuMs(gpuProfiler_.latestMs());
+		if (benchmark_)
+		{
+			benchmark_->addGpuSample(gpuProfiler_.latestMs());
+		}
+	}
+
+	bool ScopApp::finishBenchmark()
+	{
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+
+		const BenchmarkResult result = benchmark_->result();
+		const std::vector<std::pair<std::string, std::string>> info = {
+			{"model", options_.scenePath.empty() ? options_.modelPaths.front() : options_.scenePath},
+			{"models", std::to_string(scene_.modelCount())},
+			{"submeshes", std::to_string(scene_.submeshes().size())},
+			{"mode", headless() ? "offscreen" : "windowed"},
+			{"device", properties.deviceName},
+			{"extent", std::to_string(swapChainExtent_.width) + "x" + std::to_string(swapChainExtent_.height)},
+			{"present_mode", headless() ? "none" : presentModeName(swapChainPresentMode_)},
+			{"frames_in_flight", std::to_string(framesInFlight_)},
+			{"warmup_frames", std::to_string(options_.benchWarmup)},
+			{"instances", std::to_string(instanceCount_)},
+			{"culling", cullModeName(cullMode_)},
+			{"shading", shadingVariantName(shadingVariant())},
+			{"residency", residencyPolicyName(options_.residency)},
+			{"visible_instances", std::to_string(visibleInstanceCount_)},
+			{"record_threads", std::to_string(std::min(recordThreads_, recordPartitions_))},
+			{"record_partitions", std::to_string(recordPartitions_)},
+			{"record_ms_mean", std::to_string(recordedFrames_ > 0U ? recordMsTotal_ / static_cast<double>(recordedFrames_) : 0.0)},
+		};
+
+		if (options_.benchJsonPath.empty())
+		{
+			Benchmark::writeJson(std::cout, result, info);
+		}
+		else
+		{
+			std::ofstream out(options_.benchJsonPath.c_str(), std::ios::trunc);
+			if (!out)
 			{
-				vkUnmapMemory(device_, uniformBuffersMemory_[i]);
+				throw std::runtime_error("Failed to open benchmark report: " + options_.benchJsonPath);
 			}
-			vkDestroyBuffer(device_, uniformBuffers_[i], nullptr);
-			vkFreeMemory(device_, uniformBuffersMemory_[i], nullptr);
+			Benchmark::writeJson(out, result, info);
+			std::cout << "Benchmark: " << result.frames << " frames, " << result.fps << " fps, report written to "
+					  << options_.benchJsonPath << std::endl;
 		}
-		uniformBuffers_.clear();
-		uniformBuffersMemory_.clear();
-		uniformBuffersMapped_.clear();
 
-		if (descriptorPool_ != VK_NULL_HANDLE)
+		if (options_.benchBaselinePath.empty())
 		{
-			vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
-			descriptorPool_ = VK_NULL_HANDLE;
+			return true;
 		}
+		const std::vector<std::string> regressions =
+			Benchmark::compareWithBaseline(result, options_.benchBaselinePath, options_.benchThreshold);
+		for (const std::string &regression : regressions)
+		{
+			std::cerr << "Benchmark regression: " << regression << std::endl;
+		}
+		if (regressions.empty())
+		{
+			std::cout << "Benchmark: within " << options_.benchThreshold << "% of " << options_.benchBaselinePath << std::endl;
+		}
+		return regressions.empty();
+	}
 
+	void ScopApp::cleanupSwapChain()
+	{
 		for (VkFramebuffer framebuffer : swapChainFramebuffers_)
 		{
 			vkDestroyFramebuffer(device_, framebuffer, nullptr);
@@ -451,22 +914,26 @@ namespace scop
 			vkDestroyImageView(device_, depthImageView_, nullptr);
 			depthImageView_ = VK_NULL_HANDLE;
 		}
-		if (depthImage_ != VK_NULL_HANDLE)
-		{
-			vkDestroyImage(device_, depthImage_, nullptr);
-			depthImage_ = VK_NULL_HANDLE;
-		}
-		if (depthImageMemory_ != VK_NULL_HANDLE)
+		destroyImage(depthImage_, depthImageAllocation_);
+
+		for (VkImageView imageView : swapChainImageViews_)
 		{
-			vkFreeMemory(device_, depthImageMemory_, nullptr);
-			depthImageMemory_ = VK_NULL_HANDLE;
+			vkDestroyImageView(device_, imageView, nullptr);
 		}
+		swapChainImageViews_.clear();
+	}
 
-		if (graphicsPipeline_ != VK_NULL_HANDLE)
+	void ScopApp::cleanupPipeline()
+	{
+		for (VkPipeline &pipeline : pipelineVariants_)
 		{
-			vkDestroyPipeline(device_, graphicsPipeline_, nullptr);
-			graphicsPipeline_ = VK_NULL_HANDLE;
+			if (pipeline != VK_NULL_HANDLE)
+			{
+				vkDestroyPipeline(device_, pipeline, nullptr);
+				pipeline = VK_NULL_HANDLE;
+			}
 		}
+		graphicsPipeline_ = VK_NULL_HANDLE;
 		if (pipelineLayout_ != VK_NULL_HANDLE)
 		{
 			vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
@@ -477,18 +944,6 @@ namespace scop
 			vkDestroyRenderPass(device_, renderPass_, nullptr);
 			renderPass_ = VK_NULL_HANDLE;
 		}
-
-		for (VkImageView imageView : swapChainImageViews_)
-		{
-			vkDestroyImageView(device_, imageView, nullptr);
-		}
-		swapChainImageViews_.clear();
-
-		if (swapChain_ != VK_NULL_HANDLE)
-		{
-			vkDestroySwapchainKHR(device_, swapChain_, nullptr);
-			swapChain_ = VK_NULL_HANDLE;
-		}
 	}
 
 	void ScopApp::cleanup()
@@ -497,46 +952,32 @@ namespace scop
 		{
 			vkDeviceWaitIdle(device_);
 			cleanupSwapChain();
-
-			if (textureSampler_ != VK_NULL_HANDLE)
+			destroyOffscreenTargets();
+			if (swapChain_ != VK_NULL_HANDLE)
 			{
-				vkDestroySampler(device_, textureSampler_, nullptr);
-			}
-			if (textureImageView_ != VK_NULL_HANDLE)
-			{
-				vkDestroyImageView(device_, textureImageView_, nullptr);
+				vkDestroySwapchainKHR(device_, swapChain_, nullptr);
+				swapChain_ = VK_NULL_HANDLE;
 			}
-			if (textureImage_ != VK_NULL_HANDLE)
+
+			if (!commandBuffers_.empty())
 			{
-				vkDestroyImage(device_, textureImage_, nullptr);
+				vkFreeCommandBuffers(device_, commandPool_, static_cast<uint32_t>(commandBuffers_.size()), commandBuffers_.data());
+				commandBuffers_.clear();
 			}
-			if (textureImageMemory_ != VK_NULL_HANDLE)
+			destroySceneResources();
+			destroyBuffer(frameUniformBuffer_, frameUniformAllocation_);
+			cleanupPipeline();
+
+			if (textureSampler_ != VK_NULL_HANDLE)
 			{
-				vkFreeMemory(device_, textureImageMemory_, nullptr);
+				vkDestroySampler(device_, textureSampler_, nullptr);
 			}
-
 			if (descriptorSetLayout_ != VK_NULL_HANDLE)
 			{
 				vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr);
 			}
-			if (indexBuffer_ != VK_NULL_HANDLE)
-			{
-				vkDestroyBuffer(device_, indexBuffer_, nullptr);
-			}
-			if (indexBufferMemory_ != VK_NULL_HANDLE)
-			{
-				vkFreeMemory(device_, indexBufferMemory_, nullptr);
-			}
-			if (vertexBuffer_ != VK_NULL_HANDLE)
-			{
-				vkDestroyBuffer(device_, vertexBuffer_, nullptr);
-			}
-			if (vertexBufferMemory_ != VK_NULL_HANDLE)
-			{
-				vkFreeMemory(device_, vertexBufferMemory_, nullptr);
-			}
 
-			for (std::size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+			for (std::size_t i = 0; i < framesInFlight_; ++i)
 			{
 				if (imageAvailableSemaphores_.size() > i)
 				{
@@ -560,6 +1001,11 @@ namespace scop
 			{
 				vkDestroyCommandPool(device_, commandPool_, nullptr);
 			}
+			pipelineCache_.save();
+			pipelineCache_.destroy();
+			gpuProfiler_.shutdown();
+			uploader_.shutdown();
+			allocator_.shutdown();
 			vkDestroyDevice(device_, nullptr);
 			device_ = VK_NULL_HANDLE;
 		}
@@ -582,16 +1028,79 @@ namespace scop
 		glfwTerminate();
 	}
 
-	void ScopApp::createInstance()
+	void ScopApp::createSceneResources()
 	{
-		uint32_t extensionCount = 0U;
-		const char **glfwExtensions = glfwGetRequiredInstanceExtensions(&extensionCount);
-		if (glfwExtensions == nullptr || extensionCount == 0U)
+		createTextureImage();
+		createTextureImageView();
+		createVertexBuffer();
+		createIndexBuffer();
+		createMaterialBuffer();
+		uploader_.submit();
+		createInstanceBuffer();
+		createDescriptorPool();
+		createDescriptorSets();
+		planRecording();
+		createDrawArguments();
+		createCullingResources();
+		createSecondaryCommandBuffers();
+	}
+
+	void ScopApp::destroySceneResources()
+	{
+		for (VkCommandPool pool : secondaryPools_)
 		{
-			throw std::runtime_error("glfwGetRequiredInstanceExtensions failed");
+			vkDestroyCommandPool(device_, pool, nullptr);
 		}
+		secondaryPools_.clear();
+		secondaryBuffers_.clear();
+		destroyBuffer(instanceBuffer_, instanceAllocation_);
+		destroyBuffer(visibleInstanceBuffer_, visibleInstanceAllocation_);
+		destroyBuffer(modelInfoBuffer_, modelInfoAllocation_);
+		destroyBuffer(drawArgumentsBuffer_, drawArgumentsAllocation_);
+		destroyBuffer(materialBuffer_, materialBufferAllocation_);
+		if (descriptorPool_ != VK_NULL_HANDLE)
+		{
+			vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
+			descriptorPool_ = VK_NULL_HANDLE;
+		}
+		if (cullPipeline_ != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(device_, cullPipeline_, nullptr);
+			cullPipeline_ = VK_NULL_HANDLE;
+		}
+		if (cullPipelineLayout_ != VK_NULL_HANDLE)
+		{
+			vkDestroyPipelineLayout(device_, cullPipelineLayout_, nullptr);
+			cullPipelineLayout_ = VK_NULL_HANDLE;
+		}
+		if (cullSetLayout_ != VK_NULL_HANDLE)
+		{
+			vkDestroyDescriptorSetLayout(device_, cullSetLayout_, nullptr);
+			cullSetLayout_ = VK_NULL_HANDLE;
+		}
+		if (textureImageView_ != VK_NULL_HANDLE)
+		{
+			vkDestroyImageView(device_, textureImageView_, nullptr);
+			textureImageView_ = VK_NULL_HANDLE;
+		}
+		destroyImage(textureImage_, textureImageAllocation_);
+		destroyBuffer(indexBuffer_, indexBufferAllocation_);
+		destroyBuffer(vertexBuffer_, vertexBufferAllocation_);
+	}
 
-		std::vector<const char *> extensions(glfwExtensions, glfwExtensions + extensionCount);
+	void ScopApp::createInstance()
+	{
+		std::vector<const char *> extensions;
+		if (!headless())
+		{
+			uint32_t extensionCount = 0U;
+			const char **glfwExtensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+			if (glfwExtensions == nullptr || extensionCount == 0U)
+			{
+				throw std::runtime_error("glfwGetRequiredInstanceExtensions failed");
+			}
+			extensions.assign(glfwExtensions, glfwExtensions + extensionCount);
+		}
 
 #ifdef __APPLE__
 		extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
@@ -603,7 +1112,21 @@ namespace scop
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "scop";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		// Ask for up to 1.2 when the loader supports it (vkGetPhysicalDeviceFeatures2
+		// is needed to probe optional features); a 1.0 loader has no
+		// vkEnumerateInstanceVersion.
+		instanceApiVersion_ = VK_API_VERSION_1_0;
+		const PFN_vkEnumerateInstanceVersion enumerateInstanceVersion =
+			reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion"));
+		if (enumerateInstanceVersion != nullptr)
+		{
+			uint32_t loaderVersion = VK_API_VERSION_1_0;
+			if (enumerateInstanceVersion(&loaderVersion) == VK_SUCCESS)
+			{
+				instanceApiVersion_ = std::min(loaderVersion, static_cast<uint32_t>(VK_API_VERSION_1_2));
+			}
+		}
+		appInfo.apiVersion = instanceApiVersion_;
 
 		VkInstanceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -647,20 +1170,66 @@ namespace scop
 				indices.graphicsFamily = i;
 			}
 
+			// Without a surface (headless) nothing is presented; the graphics
+			// family stands in so the rest of the setup stays unchanged.
 			VkBool32 presentSupport = VK_FALSE;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+			if (surface_ == VK_NULL_HANDLE)
+			{
+				presentSupport = (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
+			}
+			else
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+			}
 			if (presentSupport == VK_TRUE)
 			{
 				indices.presentFamily = i;
 			}
 
-			if (indices.isComplete())
+			if (indices.isComplete())
+			{
+				break;
+			}
+		}
+
+		// Prefer a transfer-only family (DMA engine), then any non-graphics
+		// family that can transfer.
+		for (uint32_t i = 0U; i < queueFamilyCount; ++i)
+		{
+			const VkQueueFlags flags = queueFamilies[i].queueFlags;
+			if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				continue;
+			}
+			if (!(flags & VK_QUEUE_COMPUTE_BIT))
+			{
+				indices.transferFamily = i;
+				break;
+			}
+			if (!indices.transferFamily.has_value())
+			{
+				indices.transferFamily = i;
+			}
+		}
+
+		return indices;
+	}
+
+	bool ScopApp::hasDeviceExtension(VkPhysicalDevice device, const char *name) const
+	{
+		uint32_t extensionCount = 0U;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+		for (const VkExtensionProperties &extension : availableExtensions)
+		{
+			if (std::strcmp(extension.extensionName, name) == 0)
 			{
-				break;
+				return true;
 			}
 		}
-
-		return indices;
+		return false;
 	}
 
 	bool ScopApp::checkDeviceExtensionSupport(VkPhysicalDevice device) const
@@ -705,6 +1274,11 @@ namespace scop
 	bool ScopApp::isDeviceSuitable(VkPhysicalDevice device) const
 	{
 		const QueueFamilyIndices indices = findQueueFamilies(device);
+		if (headless())
+		{
+			return indices.isComplete();
+		}
+
 		const bool extensionsSupported = checkDeviceExtensionSupport(device);
 
 		bool swapChainAdequate = false;
@@ -714,10 +1288,7 @@ namespace scop
 			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 		}
 
-		VkPhysicalDeviceFeatures features{};
-		vkGetPhysicalDeviceFeatures(device, &features);
-
-		return indices.isComplete() && extensionsSupported && swapChainAdequate && features.samplerAnisotropy == VK_TRUE;
+		return indices.isComplete() && extensionsSupported && swapChainAdequate;
 	}
 
 	void ScopApp::pickPhysicalDevice()
@@ -750,7 +1321,8 @@ namespace scop
 	void ScopApp::createLogicalDevice()
 	{
 		const QueueFamilyIndices indices = findQueueFamilies(physicalDevice_);
-		const std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+		const uint32_t transferFamily = indices.transferFamily.value_or(indices.graphicsFamily.value());
+		const std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value(), transferFamily};
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		const float queuePriority = 1.0f;
@@ -764,16 +1336,94 @@ namespace scop
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures{};
+		vkGetPhysicalDeviceFeatures(physicalDevice_, &supportedFeatures);
+
 		VkPhysicalDeviceFeatures deviceFeatures{};
-		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		deviceFeatures.samplerAnisotropy = supportedFeatures.samplerAnisotropy;
+		deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+		deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+		deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+		deviceFeatures.inheritedQueries = supportedFeatures.inheritedQueries;
+
+		std::vector<const char *> extensions;
+		if (!headless())
+		{
+			extensions = kDeviceExtensions;
+		}
+
+		VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+		presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+		VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+		presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+		presentIdFeatures.pNext = &presentWaitFeatures;
+
+		VkPhysicalDeviceProperties deviceProperties{};
+		vkGetPhysicalDeviceProperties(physicalDevice_, &deviceProperties);
+		const bool features2Available = instanceApiVersion_ >= VK_API_VERSION_1_1 && deviceProperties.apiVersion >= VK_API_VERSION_1_1;
+		if (features2Available && !headless() &&
+			hasDeviceExtension(physicalDevice_, VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+			hasDeviceExtension(physicalDevice_, VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+		{
+			VkPhysicalDeviceFeatures2 features2{};
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features2.pNext = &presentIdFeatures;
+			vkGetPhysicalDeviceFeatures2(physicalDevice_, &features2);
+			presentWaitSupported_ = presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+		}
+		if (presentWaitSupported_)
+		{
+			extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+			extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+		}
+
+		// drawIndirectCount is a Vulkan 1.2 feature, or VK_KHR_draw_indirect_count
+		// on older devices; without it culling stays on the CPU.
+		VkPhysicalDeviceVulkan12Features vulkan12Features{};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+		const bool vulkan12Available = instanceApiVersion_ >= VK_API_VERSION_1_2 && deviceProperties.apiVersion >= VK_API_VERSION_1_2;
+		const char *drawIndirectCountName = nullptr;
+		if (vulkan12Available)
+		{
+			VkPhysicalDeviceVulkan12Features supported12{};
+			supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+			VkPhysicalDeviceFeatures2 features2{};
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features2.pNext = &supported12;
+			vkGetPhysicalDeviceFeatures2(physicalDevice_, &features2);
+			vulkan12Features.drawIndirectCount = supported12.drawIndirectCount;
+			if (supported12.drawIndirectCount == VK_TRUE)
+			{
+				drawIndirectCountName = "vkCmdDrawIndexedIndirectCount";
+			}
+		}
+		else if (hasDeviceExtension(physicalDevice_, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+		{
+			extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+			drawIndirectCountName = "vkCmdDrawIndexedIndirectCountKHR";
+		}
+		// Per-heap driver budgets for the memory report, read through
+		// vkGetPhysicalDeviceMemoryProperties2.
+		const bool memoryBudget = features2Available && hasDeviceExtension(physicalDevice_, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		if (memoryBudget)
+		{
+			extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		}
+		void *featureChain = vulkan12Available ? &vulkan12Features : nullptr;
+		if (presentWaitSupported_)
+		{
+			presentWaitFeatures.pNext = featureChain;
+			featureChain = &presentIdFeatures;
+		}
 
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pNext = featureChain;
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
 		createInfo.pEnabledFeatures = &deviceFeatures;
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(kDeviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = kDeviceExtensions.data();
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+		createInfo.ppEnabledExtensionNames = extensions.data();
 
 		if (vkCreateDevice(physicalDevice_, &createInfo, nullptr, &device_) != VK_SUCCESS)
 		{
@@ -782,6 +1432,41 @@ namespace scop
 
 		vkGetDeviceQueue(device_, indices.graphicsFamily.value(), 0U, &graphicsQueue_);
 		vkGetDeviceQueue(device_, indices.presentFamily.value(), 0U, &presentQueue_);
+
+		vkGetDeviceQueue(device_, transferFamily, 0U, &transferQueue_);
+
+		if (presentWaitSupported_)
+		{
+			waitForPresent_ = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(device_, "vkWaitForPresentKHR"));
+			presentWaitSupported_ = waitForPresent_ != nullptr;
+		}
+		maxDrawsPerCall_ = (deviceFeatures.multiDrawIndirect == VK_TRUE) ? std::max(deviceProperties.limits.maxDrawIndirectCount, 1U) : 1U;
+		if (drawIndirectCountName != nullptr)
+		{
+			drawIndexedIndirectCount_ = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(vkGetDeviceProcAddr(device_, drawIndirectCountName));
+		}
+		// Only the first model's instances start at 0.
+		directDraws_ = scene_.modelCount() > 1U && deviceFeatures.drawIndirectFirstInstance != VK_TRUE;
+		const bool gpuCulling = drawIndexedIndirectCount_ != nullptr && !directDraws_;
+		if (cullMode_ == CullMode::Auto)
+		{
+			cullMode_ = gpuCulling ? CullMode::Gpu : CullMode::Cpu;
+		}
+		else if (cullMode_ == CullMode::Gpu && !gpuCulling)
+		{
+			std::cerr << "Warning: GPU culling needs drawIndirectCount and drawIndirectFirstInstance, culling on the CPU instead\n";
+			cullMode_ = CullMode::Cpu;
+		}
+
+		allocator_.init(physicalDevice_, device_, memoryBudget);
+		allocator_.setBudget(static_cast<VkDeviceSize>(options_.gpuBudgetMiB) * 1024U * 1024U);
+		uploader_.init(device_, allocator_, indices.graphicsFamily.value(), graphicsQueue_, transferFamily, transferQueue_);
+		pipelineCache_.init(physicalDevice_, device_);
+		gpuProfiler_.init(physicalDevice_, device_, indices.graphicsFamily.value(), framesInFlight_,
+						  deviceFeatures.pipelineStatisticsQuery == VK_TRUE, options_.gpuCsvPath);
+		inheritedQueries_ = deviceFeatures.inheritedQueries == VK_TRUE;
+		std::cout << "Uploads: " << (uploader_.usesTransferQueue() ? "dedicated transfer queue family " : "graphics queue family ")
+				  << transferFamily << std::endl;
 	}
 
 	VkSurfaceFormatKHR ScopApp::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats) const
@@ -798,6 +1483,17 @@ namespace scop
 
 	VkPresentModeKHR ScopApp::chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes) const
 	{
+		if (options_.presentMode.has_value())
+		{
+			const VkPresentModeKHR requested = options_.presentMode.value();
+			if (std::find(availablePresentModes.begin(), availablePresentModes.end(), requested) != availablePresentModes.end())
+			{
+				return requested;
+			}
+			std::cerr << "Warning: present mode " << presentModeName(requested) << " is not supported, using fifo\n";
+			return VK_PRESENT_MODE_FIFO_KHR;
+		}
+
 		for (VkPresentModeKHR presentMode : availablePresentModes)
 		{
 			if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
@@ -869,12 +1565,20 @@ namespace scop
 		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		createInfo.presentMode = presentMode;
 		createInfo.clipped = VK_TRUE;
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		// Passing the current swapchain lets the presentation engine hand its
+		// images over instead of tearing everything down mid-resize.
+		const VkSwapchainKHR oldSwapChain = swapChain_;
+		createInfo.oldSwapchain = oldSwapChain;
 
 		if (vkCreateSwapchainKHR(device_, &createInfo, nullptr, &swapChain_) != VK_SUCCESS)
 		{
+			swapChain_ = oldSwapChain;
 			throw std::runtime_error("Failed to create swap chain");
 		}
+		if (oldSwapChain != VK_NULL_HANDLE)
+		{
+			vkDestroySwapchainKHR(device_, oldSwapChain, nullptr);
+		}
 
 		vkGetSwapchainImagesKHR(device_, swapChain_, &imageCount, nullptr);
 		swapChainImages_.resize(imageCount);
@@ -882,6 +1586,7 @@ namespace scop
 
 		swapChainImageFormat_ = surfaceFormat.format;
 		swapChainExtent_ = extent;
+		swapChainPresentMode_ = presentMode;
 	}
 
 	void ScopApp::createImageViews()
@@ -889,8 +1594,64 @@ namespace scop
 		swapChainImageViews_.resize(swapChainImages_.size());
 		for (std::size_t i = 0; i < swapChainImages_.size(); ++i)
 		{
-			swapChainImageViews_[i] = createImageView(swapChainImages_[i], swapChainImageFormat_, VK_IMAGE_ASPECT_COLOR_BIT);
+			swapChainImageViews_[i] = createImageView(swapChainImages_[i], swapChainImageFormat_, VK_IMAGE_ASPECT_COLOR_BIT,
+													  VK_IMAGE_VIEW_TYPE_2D, 1U);
+		}
+	}
+
+	void ScopApp::createOffscreenTargets()
+	{
+		// sRGB like the window's swapchain, so dumped frames match what is
+		// shown on screen.
+		swapChainImageFormat_ = VK_FORMAT_R8G8B8A8_SRGB;
+		swapChainExtent_ = requestedExtent();
+
+		swapChainImages_.assign(framesInFlight_, VK_NULL_HANDLE);
+		offscreenAllocations_.resize(framesInFlight_);
+		for (std::size_t i = 0; i < framesInFlight_; ++i)
+		{
+			createImage(swapChainExtent_.width, swapChainExtent_.height, 1U, swapChainImageFormat_, VK_IMAGE_TILING_OPTIMAL,
+						VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+						swapChainImages_[i], offscreenAllocations_[i]);
+		}
+
+		if (options_.dumpFramesDir.empty())
+		{
+			return;
+		}
+		std::filesystem::create_directories(options_.dumpFramesDir);
+
+		const VkDeviceSize frameBytes = static_cast<VkDeviceSize>(swapChainExtent_.width) * swapChainExtent_.height * 4U;
+		readbackBuffers_.assign(framesInFlight_, VK_NULL_HANDLE);
+		readbackAllocations_.resize(framesInFlight_);
+		readbackFrames_.assign(framesInFlight_, std::nullopt);
+		for (std::size_t i = 0; i < framesInFlight_; ++i)
+		{
+			createBuffer(frameBytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+						 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, GpuMemoryPool::Static,
+						 readbackBuffers_[i], readbackAllocations_[i]);
+		}
+	}
+
+	void ScopApp::destroyOffscreenTargets()
+	{
+		for (std::size_t i = 0; i < readbackBuffers_.size(); ++i)
+		{
+			destroyBuffer(readbackBuffers_[i], readbackAllocations_[i]);
+		}
+		readbackBuffers_.clear();
+		readbackAllocations_.clear();
+		readbackFrames_.clear();
+
+		for (std::size_t i = 0; i < offscreenAllocations_.size(); ++i)
+		{
+			destroyImage(swapChainImages_[i], offscreenAllocations_[i]);
+		}
+		if (!offscreenAllocations_.empty())
+		{
+			swapChainImages_.clear();
 		}
+		offscreenAllocations_.clear();
 	}
 
 	void ScopApp::createRenderPass()
@@ -903,7 +1664,7 @@ namespace scop
 		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		colorAttachment.finalLayout = headless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 		VkAttachmentDescription depthAttachment{};
 		depthAttachment.format = findDepthFormat();
@@ -936,6 +1697,16 @@ namespace scop
 		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+		// Headless frames are copied out right after the pass.
+		VkSubpassDependency readbackDependency{};
+		readbackDependency.srcSubpass = 0U;
+		readbackDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+		readbackDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		readbackDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		readbackDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		readbackDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		const std::array<VkSubpassDependency, 2> dependencies = {dependency, readbackDependency};
+
 		std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
 		VkRenderPassCreateInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -943,8 +1714,8 @@ namespace scop
 		renderPassInfo.pAttachments = attachments.data();
 		renderPassInfo.subpassCount = 1U;
 		renderPassInfo.pSubpasses = &subpass;
-		renderPassInfo.dependencyCount = 1U;
-		renderPassInfo.pDependencies = &dependency;
+		renderPassInfo.dependencyCount = headless() ? 2U : 1U;
+		renderPassInfo.pDependencies = dependencies.data();
 
 		if (vkCreateRenderPass(device_, &renderPassInfo, nullptr, &renderPass_) != VK_SUCCESS)
 		{
@@ -956,9 +1727,9 @@ namespace scop
 	{
 		VkDescriptorSetLayoutBinding uboLayoutBinding{};
 		uboLayoutBinding.binding = 0U;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		uboLayoutBinding.descriptorCount = 1U;
-		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 		VkDescriptorSetLayoutBinding samplerLayoutBinding{};
 		samplerLayoutBinding.binding = 1U;
@@ -966,7 +1737,13 @@ namespace scop
 		samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 		samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-		const std::array<VkDescriptorSetLayoutBinding, 2> bindings = {uboLayoutBinding, samplerLayoutBinding};
+		VkDescriptorSetLayoutBinding materialLayoutBinding{};
+		materialLayoutBinding.binding = 2U;
+		materialLayoutBinding.descriptorCount = 1U;
+		materialLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		materialLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		const std::array<VkDescriptorSetLayoutBinding, 3> bindings = {uboLayoutBinding, samplerLayoutBinding, materialLayoutBinding};
 		VkDescriptorSetLayoutCreateInfo layoutInfo{};
 		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
@@ -978,12 +1755,12 @@ namespace scop
 		}
 	}
 
-	VkShaderModule ScopApp::createShaderModule(const std::vector<std::uint8_t> &code) const
+	VkShaderModule ScopApp::createShaderModule(const ShaderCode &code) const
 	{
 		VkShaderModuleCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+		createInfo.codeSize = code.size;
+		createInfo.pCode = code.words;
 
 		VkShaderModule shaderModule = VK_NULL_HANDLE;
 		if (vkCreateShaderModule(device_, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
@@ -995,11 +1772,33 @@ namespace scop
 
 	void ScopApp::createGraphicsPipeline()
 	{
-		const std::vector<std::uint8_t> vertShaderCode = readBinaryFile("shaders/mesh.vert.spv");
-		const std::vector<std::uint8_t> fragShaderCode = readBinaryFile("shaders/mesh.frag.spv");
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1U;
+		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout_;
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstantRange.offset = 0U;
+		pushConstantRange.size = sizeof(MeshPushConstants);
+		pipelineLayoutInfo.pushConstantRangeCount = 1U;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create pipeline layout");
+		}
 
-		const VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-		const VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+		// The plain variant is warmed up front so the first T press does not
+		// stall; other variants are built the first time they are selected.
+		graphicsPipeline_ = pipelineVariant(shadingVariant());
+		pipelineVariant(0U);
+	}
+
+	VkPipeline ScopApp::createPipelineVariant(std::size_t variant)
+	{
+		const VkShaderModule vertShaderModule = createShaderModule(EmbeddedShaders::meshVertex());
+		const VkShaderModule fragShaderModule = createShaderModule(EmbeddedShaders::meshFragment());
 
 		VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
 		vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -1013,15 +1812,33 @@ namespace scop
 		fragShaderStageInfo.module = fragShaderModule;
 		fragShaderStageInfo.pName = "main";
 
+		const std::array<VkBool32, 3> specializationValues = {
+			(variant & kVariantTextured) != 0U ? VK_TRUE : VK_FALSE,
+			(variant & kVariantMaterial) != 0U ? VK_TRUE : VK_FALSE,
+			(variant & kVariantUntextured) != 0U ? VK_TRUE : VK_FALSE};
+		std::array<VkSpecializationMapEntry, 3> specializationEntries{};
+		for (uint32_t i = 0U; i < specializationEntries.size(); ++i)
+		{
+			specializationEntries[i].constantID = i;
+			specializationEntries[i].offset = i * static_cast<uint32_t>(sizeof(VkBool32));
+			specializationEntries[i].size = sizeof(VkBool32);
+		}
+		VkSpecializationInfo specializationInfo{};
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+		specializationInfo.pMapEntries = specializationEntries.data();
+		specializationInfo.dataSize = sizeof(specializationValues);
+		specializationInfo.pData = specializationValues.data();
+		fragShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
 		VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
 
-		const VkVertexInputBindingDescription bindingDescription = getVertexBindingDescription();
+		const auto bindingDescriptions = getVertexBindingDescriptions();
 		const auto attributeDescriptions = getVertexAttributeDescriptions();
 
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = 1U;
-		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+		vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
 		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
@@ -1030,24 +1847,16 @@ namespace scop
 		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 		inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(swapChainExtent_.width);
-		viewport.height = static_cast<float>(swapChainExtent_.height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D scissor{};
-		scissor.offset = {0, 0};
-		scissor.extent = swapChainExtent_;
-
 		VkPipelineViewportStateCreateInfo viewportState{};
 		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 		viewportState.viewportCount = 1U;
-		viewportState.pViewports = &viewport;
 		viewportState.scissorCount = 1U;
-		viewportState.pScissors = &scissor;
+
+		const std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+		VkPipelineDynamicStateCreateInfo dynamicState{};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+		dynamicState.pDynamicStates = dynamicStates.data();
 
 		VkPipelineRasterizationStateCreateInfo rasterizer{};
 		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -1083,16 +1892,6 @@ namespace scop
 		colorBlending.attachmentCount = 1U;
 		colorBlending.pAttachments = &colorBlendAttachment;
 
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 1U;
-		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout_;
-
-		if (vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to create pipeline layout");
-		}
-
 		VkGraphicsPipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 		pipelineInfo.stageCount = 2U;
@@ -1104,17 +1903,52 @@ namespace scop
 		pipelineInfo.pMultisampleState = &multisampling;
 		pipelineInfo.pDepthStencilState = &depthStencil;
 		pipelineInfo.pColorBlendState = &colorBlending;
+		pipelineInfo.pDynamicState = &dynamicState;
 		pipelineInfo.layout = pipelineLayout_;
 		pipelineInfo.renderPass = renderPass_;
 		pipelineInfo.subpass = 0U;
 
-		if (vkCreateGraphicsPipelines(device_, VK_NULL_HANDLE, 1U, &pipelineInfo, nullptr, &graphicsPipeline_) != VK_SUCCESS)
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		const VkResult result = vkCreateGraphicsPipelines(device_, pipelineCache_.handle(), 1U, &pipelineInfo, nullptr, &pipeline);
+		vkDestroyShaderModule(device_, fragShaderModule, nullptr);
+		vkDestroyShaderModule(device_, vertShaderModule, nullptr);
+		if (result != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create graphics pipeline");
 		}
+		return pipeline;
+	}
 
-		vkDestroyShaderModule(device_, fragShaderModule, nullptr);
-		vkDestroyShaderModule(device_, vertShaderModule, nullptr);
+	VkPipeline ScopApp::pipelineVariant(std::size_t variant)
+	{
+		if (pipelineVariants_[variant] == VK_NULL_HANDLE)
+		{
+			pipelineVariants_[variant] = createPipelineVariant(variant);
+		}
+		return pipelineVariants_[variant];
+	}
+
+	std::size_t ScopApp::shadingVariant() const
+	{
+		const std::size_t material = hasMaterial_ ? kVariantMaterial : 0U;
+		const std::size_t textured = kVariantTextured | (untexturedInstances_ ? kVariantUntextured : 0U);
+		switch (options_.shading)
+		{
+		case ShadingMode::Plain:
+			return 0U;
+		case ShadingMode::Material:
+			return kVariantMaterial;
+		case ShadingMode::Textured:
+			return textured | material;
+		default:
+			break;
+		}
+		// Fully faded to white nothing reads the texture or the material.
+		if (frameState_.textureBlend <= 0.0f && frameState_.targetTextureBlend <= 0.0f)
+		{
+			return 0U;
+		}
+		return (hasRealTexture_ ? textured : 0U) | material;
 	}
 
 	void ScopApp::createFramebuffers()
@@ -1155,23 +1989,8 @@ namespace scop
 		}
 	}
 
-	uint32_t ScopApp::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
-	{
-		VkPhysicalDeviceMemoryProperties memProperties{};
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memProperties);
-
-		for (uint32_t i = 0U; i < memProperties.memoryTypeCount; ++i)
-		{
-			if ((typeFilter & (1U << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-			{
-				return i;
-			}
-		}
-		throw std::runtime_error("Failed to find suitable memory type");
-	}
-
-	void ScopApp::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-							   VkBuffer &buffer, VkDeviceMemory &bufferMemory)
+	void ScopApp::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, GpuMemoryPool pool,
+							   VkBuffer &buffer, GpuAllocation &allocation)
 	{
 		VkBufferCreateInfo bufferInfo{};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -1187,142 +2006,551 @@ namespace scop
 		VkMemoryRequirements memRequirements{};
 		vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+		allocation = allocator_.allocate(memRequirements, properties, pool, GpuResourceKind::Linear);
+		if (vkBindBufferMemory(device_, buffer, allocation.memory, allocation.offset) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to bind buffer memory");
+		}
+	}
 
-		if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+	void ScopApp::destroyBuffer(VkBuffer &buffer, GpuAllocation &allocation)
+	{
+		if (buffer != VK_NULL_HANDLE)
 		{
-			throw std::runtime_error("Failed to allocate buffer memory");
+			vkDestroyBuffer(device_, buffer, nullptr);
+			buffer = VK_NULL_HANDLE;
 		}
+		allocator_.free(allocation);
+	}
+
+	void ScopApp::createVertexBuffer()
+	{
+		const TrackedVector<Vertex, MemoryTag::Renderer> &vertices = scene_.vertices();
+		const VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+
+		createBuffer(bufferSize,
+					 VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+					 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuMemoryPool::Static,
+					 vertexBuffer_, vertexBufferAllocation_);
 
-		vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+		uploader_.uploadBuffer(vertices.data(), bufferSize, vertexBuffer_,
+							   VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 	}
 
-	VkCommandBuffer ScopApp::beginSingleTimeCommands()
+	void ScopApp::createIndexBuffer()
 	{
-		VkCommandBufferAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = commandPool_;
-		allocInfo.commandBufferCount = 1U;
+		const TrackedVector<uint32_t, MemoryTag::Renderer> &indices = scene_.indices();
+		const VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
 
-		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
-		vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+		createBuffer(bufferSize,
+					 VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+					 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuMemoryPool::Static,
+					 indexBuffer_, indexBufferAllocation_);
 
-		VkCommandBufferBeginInfo beginInfo{};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-		vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		return commandBuffer;
+		uploader_.uploadBuffer(indices.data(), bufferSize, indexBuffer_,
+							   VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
 	}
 
-	void ScopApp::endSingleTimeCommands(VkCommandBuffer commandBuffer)
+	void ScopApp::createUniformBuffers()
 	{
-		vkEndCommandBuffer(commandBuffer);
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+		const VkDeviceSize alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1U);
+		frameUniformStride_ = (sizeof(FrameUniforms) + alignment - 1U) / alignment * alignment;
 
-		VkSubmitInfo submitInfo{};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1U;
-		submitInfo.pCommandBuffers = &commandBuffer;
+		createBuffer(frameUniformStride_ * framesInFlight_,
+					 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+					 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					 GpuMemoryPool::Static, frameUniformBuffer_, frameUniformAllocation_);
+	}
+
+	void ScopApp::createMaterialBuffer()
+	{
+		static const Vec3 kTints[kMaterialSlots] = {
+			Vec3(1.00f, 1.00f, 1.00f), Vec3(1.00f, 0.45f, 0.40f), Vec3(0.45f, 1.00f, 0.50f), Vec3(0.45f, 0.60f, 1.00f),
+			Vec3(1.00f, 0.85f, 0.35f), Vec3(0.85f, 0.45f, 1.00f), Vec3(0.40f, 0.95f, 0.95f), Vec3(0.70f, 0.70f, 0.70f)};
+
+		MaterialUniforms material{};
+		for (std::size_t slot = 0; slot < kMaterialSlots; ++slot)
+		{
+			MaterialUniforms::Entry &entry = material.entries[slot];
+			entry.kd[0] = materialKd_.x * kTints[slot].x;
+			entry.kd[1] = materialKd_.y * kTints[slot].y;
+			entry.kd[2] = materialKd_.z * kTints[slot].z;
+			entry.kd[3] = 1.0f;
+
+			entry.ksNs[0] = materialKs_.x;
+			entry.ksNs[1] = materialKs_.y;
+			entry.ksNs[2] = materialKs_.z;
+			entry.ksNs[3] = materialNs_;
+		}
+
+		createBuffer(sizeof(MaterialUniforms),
+					 VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+					 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuMemoryPool::Static,
+					 materialBuffer_, materialBufferAllocation_);
+		uploader_.uploadBuffer(&material, sizeof(MaterialUniforms), materialBuffer_,
+							   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_UNIFORM_READ_BIT);
+	}
+
+	void ScopApp::createInstanceBuffer()
+	{
+		const std::vector<SceneModel> &models = scene_.models();
+		std::vector<InstanceSeed> seeds;
+		if (!placements_.empty())
+		{
+			// Scene placements keep their layout, centred on the origin; they
+			// do not spin.
+			Bounds field{placements_.front().position, placements_.front().position};
+			for (const ScenePlacement &placement : placements_)
+			{
+				field.min = minVec(field.min, placement.position);
+				field.max = maxVec(field.max, placement.position);
+			}
+			const Vec3 center = (field.min + field.max) * 0.5f;
+			fieldExtent_ = std::max(field.max.x - field.min.x, field.max.z - field.min.z) + kInstanceSpacing;
+
+			seeds.reserve(placements_.size());
+			for (const ScenePlacement &placement : placements_)
+			{
+				seeds.push_back({placement.position - center, placement.yaw, 0.0f, 0U, placement.model, placement.texture});
+			}
+			std::stable_sort(seeds.begin(), seeds.end(),
+							 [](const InstanceSeed &a, const InstanceSeed &b) { return a.model < b.model; });
+		}
+		else
+		{
+			// Square grid centred on the origin, repeated for every model; a
+			// single instance sits exactly where the models were before
+			// instancing. Wide multi-model scenes spread the grid out so
+			// copies do not overlap.
+			const Bounds &bounds = scene_.bounds();
+			const std::size_t gridCount = options_.instances;
+			const float spacing = std::max(kInstanceSpacing, std::max(bounds.max.x - bounds.min.x, bounds.max.z - bounds.min.z) + 0.4f);
+			const std::size_t side = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(gridCount))));
+			const float origin = -0.5f * spacing * static_cast<float>(side - 1U);
+			fieldExtent_ = spacing * static_cast<float>(side);
+
+			seeds.resize(gridCount * models.size());
+			for (std::size_t i = 0; i < gridCount; ++i)
+			{
+				// Cheap integer hash so the layout is identical on every run.
+				uint32_t hash = static_cast<uint32_t>(i) * 2654435761U;
+				hash ^= hash >> 16;
+				InstanceSeed seed;
+				seed.position = Vec3(origin + spacing * static_cast<float>(i % side), 0.0f,
+									 origin + spacing * static_cast<float>(i / side));
+				seed.phase = (i == 0U) ? 0.0f : static_cast<float>(hash & 0xFFFFU) / 65535.0f * 6.2831853f;
+				seed.spinSpeed = (i == 0U) ? 0.0f : 0.5f + static_cast<float>((hash >> 16) & 0xFFU) / 255.0f;
+				seed.material = (i == 0U) ? 0U : static_cast<uint32_t>(hash % kMaterialSlots);
+				seed.textureLayer = hasRealTexture_ ? 0U : SceneLoader::kNoTexture;
+				for (std::size_t model = 0; model < models.size(); ++model)
+				{
+					seed.model = static_cast<uint32_t>(model);
+					seeds[model * gridCount + i] = seed;
+				}
+			}
+		}
+		instanceSeeds_ = std::move(seeds);
+		instanceCount_ = instanceSeeds_.size();
+
+		modelInstances_.assign(models.size(), InstanceRange{0U, 0U, 0U});
+		for (const InstanceSeed &seed : instanceSeeds_)
+		{
+			++modelInstances_[seed.model].count;
+		}
+		instanceChunks_.clear();
+		uint32_t first = 0U;
+		for (std::size_t model = 0; model < modelInstances_.size(); ++model)
+		{
+			InstanceRange &range = modelInstances_[model];
+			range.first = first;
+			range.model = static_cast<uint32_t>(model);
+			first += range.count;
+			for (uint32_t offset = 0U; offset < range.count; offset += static_cast<uint32_t>(kInstanceGrain))
+			{
+				instanceChunks_.push_back({range.first + offset,
+										   std::min(range.count - offset, static_cast<uint32_t>(kInstanceGrain)),
+										   range.model});
+			}
+		}
+
+		// Slices double as dynamic storage-buffer ranges for the culling pass.
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+		const VkDeviceSize alignment = std::max<VkDeviceSize>(properties.limits.minStorageBufferOffsetAlignment, 1U);
+		instanceSliceSize_ = (static_cast<VkDeviceSize>(instanceCount_ * sizeof(InstanceData)) + alignment - 1U) / alignment * alignment;
+		createBuffer(instanceSliceSize_ * framesInFlight_,
+					 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+					 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					 GpuMemoryPool::Static, instanceBuffer_, instanceAllocation_);
+
+		// Instance transforms are rigid, so one model-space sphere per model
+		// serves all of its instances.
+		modelSpheres_.clear();
+		modelVisible_.clear();
+		for (std::size_t model = 0; model < models.size(); ++model)
+		{
+			const Bounds &bounds = models[model].bounds;
+			const Vec3 center = (bounds.min + bounds.max) * 0.5f;
+			modelSpheres_.push_back(Vec4(center.x, center.y, center.z, length(bounds.max - bounds.min) * 0.5f));
+			modelVisible_.push_back(modelInstances_[model].count);
+		}
+		visibleInstanceCount_ = instanceCount_;
+		instanceVisible_.assign(cullMode_ == CullMode::Cpu ? instanceCount_ : 0U, 0U);
+		cullCenters_.resize(instanceVisible_.size());
+		cullRadii_.assign(instanceVisible_.size(), 0.0f);
+		for (std::size_t i = 0; i < cullRadii_.size(); ++i)
+		{
+			cullRadii_[i] = modelSpheres_[instanceSeeds_[i].model].w;
+		}
+		chunkVisible_.assign(instanceChunks_.size(), 0U);
+		updateProjection();
+	}
+
+	void ScopApp::updateInstances(std::size_t frameIndex, const Frustum &frustum)
+	{
+		SCOP_PROFILE_FUNCTION();
+		InstanceData *instances = reinterpret_cast<InstanceData *>(
+			static_cast<std::uint8_t *>(instanceAllocation_.mapped) + instanceSliceSize_ * frameIndex);
+		const float time = frameState_.instanceTime;
+		const bool cull = cullMode_ == CullMode::Cpu;
+
+		// CPU culling runs in two passes over the same chunks: the first
+		// tests every sphere and counts survivors per chunk, the second
+		// writes each model's survivors to the front of its range after a
+		// prefix sum of the counts within the model.
+		if (cull)
+		{
+			threadPool_.parallelFor(instanceChunks_.size(), 1U, [this, &frustum, time](std::size_t begin, std::size_t end)
+			{
+				SCOP_PROFILE_ZONE("Instance culling");
+				for (std::size_t chunkIndex = begin; chunkIndex < end; ++chunkIndex)
+				{
+					const InstanceRange &chunk = instanceChunks_[chunkIndex];
+					const Vec4 &sphere = modelSpheres_[chunk.model];
+					for (std::size_t i = chunk.first; i < chunk.first + chunk.count; ++i)
+					{
+						const InstanceSeed &seed = instanceSeeds_[i];
+						const float angle = seed.phase + seed.spinSpeed * time;
+						const float c = std::cos(angle);
+						const float s = std::sin(angle);
+						cullCenters_.set(i, Vec3(seed.position.x + c * sphere.x + s * sphere.z,
+												 seed.position.y + sphere.y,
+												 seed.position.z - s * sphere.x + c * sphere.z));
+					}
+					chunkVisible_[chunkIndex] = MathBatch::spheresInFrustum(
+						frustum, std::as_const(cullCenters_).streams(chunk.first), cullRadii_.data() + chunk.first,
+						chunk.count, instanceVisible_.data() + chunk.first);
+				}
+			});
+
+			std::fill(modelVisible_.begin(), modelVisible_.end(), 0U);
+			for (std::size_t chunkIndex = 0; chunkIndex < instanceChunks_.size(); ++chunkIndex)
+			{
+				std::size_t &modelCount = modelVisible_[instanceChunks_[chunkIndex].model];
+				const std::size_t chunkCount = chunkVisible_[chunkIndex];
+				chunkVisible_[chunkIndex] = modelCount;
+				modelCount += chunkCount;
+			}
+			visibleInstanceCount_ = 0U;
+			for (std::size_t count : modelVisible_)
+			{
+				visibleInstanceCount_ += count;
+			}
+		}
+
+		threadPool_.parallelFor(instanceChunks_.size(), 1U, [this, instances, time, cull](std::size_t begin, std::size_t end)
+		{
+			SCOP_PROFILE_ZONE("Instance transforms");
+			for (std::size_t chunkIndex = begin; chunkIndex < end; ++chunkIndex)
+			{
+				const InstanceRange &chunk = instanceChunks_[chunkIndex];
+				std::size_t slot = cull ? modelInstances_[chunk.model].first + chunkVisible_[chunkIndex] : chunk.first;
+				for (std::size_t i = chunk.first; i < chunk.first + chunk.count; ++i)
+				{
+					if (cull && instanceVisible_[i] == 0U)
+					{
+						continue;
+					}
+					const InstanceSeed &seed = instanceSeeds_[i];
+					const float angle = seed.phase + seed.spinSpeed * time;
+					const float c = std::cos(angle);
+					const float s = std::sin(angle);
+
+					// translation(position) * rotationY(angle), column-major.
+					InstanceData data{};
+					data.model[0] = c;
+					data.model[2] = -s;
+					data.model[5] = 1.0f;
+					data.model[8] = s;
+					data.model[10] = c;
+					data.model[12] = seed.position.x;
+					data.model[13] = seed.position.y;
+					data.model[14] = seed.position.z;
+					data.model[15] = 1.0f;
+					data.material = seed.material;
+					data.textureLayer = seed.textureLayer;
+					data.sceneModel = seed.model;
+					std::memcpy(&instances[slot], &data, sizeof(InstanceData));
+					++slot;
+				}
+			}
+		});
+	}
+
+	void ScopApp::createDrawArguments()
+	{
+		// Storage alignment keeps every slot usable as a dynamic offset by
+		// the culling pass.
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+		const VkDeviceSize alignment = std::max<VkDeviceSize>(properties.limits.minStorageBufferOffsetAlignment, 4U);
+		drawCommandsOffset_ = sizeof(DrawHeader) + sizeof(uint32_t) * scene_.modelCount();
+		const VkDeviceSize slotSize = drawCommandsOffset_ + sizeof(VkDrawIndexedIndirectCommand) * drawCommandCount();
+		drawArgumentsStride_ = (slotSize + alignment - 1U) / alignment * alignment;
+		createBuffer(drawArgumentsStride_ * framesInFlight_,
+					 VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+					 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					 GpuMemoryPool::Static, drawArgumentsBuffer_, drawArgumentsAllocation_);
+
+		// Only instanceCount changes per frame; the ranges are written once.
+		// Command submesh * drawSlices_ + slice draws that slice of the
+		// submesh's instances.
+		std::vector<VkDrawIndexedIndirectCommand> commands;
+		commands.reserve(drawCommandCount());
+		for (const Submesh &submesh : scene_.submeshes())
+		{
+			const InstanceRange &range = modelInstances_[submesh.model];
+			for (uint32_t slice = 0; slice < drawSlices_; ++slice)
+			{
+				const uint32_t instanceCount = (cullMode_ == CullMode::Gpu) ? 0U : sliceVisible(range.count, range.count, slice, drawSlices_);
+				commands.push_back({submesh.indexCount, instanceCount, submesh.firstIndex, submesh.vertexOffset,
+									range.first + sliceStart(range.count, slice, drawSlices_)});
+			}
+		}
+		for (std::size_t slot = 0; slot < framesInFlight_; ++slot)
+		{
+			std::uint8_t *base = static_cast<std::uint8_t *>(drawArgumentsAllocation_.mapped) + drawArgumentsStride_ * slot;
+			std::memset(base, 0, static_cast<std::size_t>(drawCommandsOffset_));
+			std::memcpy(base + drawCommandsOffset_, commands.data(), sizeof(VkDrawIndexedIndirectCommand) * commands.size());
+		}
+	}
+
+	void ScopApp::createCullingResources()
+	{
+		if (cullMode_ != CullMode::Gpu)
+		{
+			return;
+		}
+
+		// Bindings 0-2 move with the frame slot; the model table is static.
+		std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+		for (uint32_t binding = 0; binding < bindings.size(); ++binding)
+		{
+			bindings[binding].binding = binding;
+			bindings[binding].descriptorType = (binding < 3U) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			bindings[binding].descriptorCount = 1U;
+			bindings[binding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+		if (vkCreateDescriptorSetLayout(device_, &layoutInfo, nullptr, &cullSetLayout_) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create culling descriptor set layout");
+		}
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0U;
+		pushConstantRange.size = sizeof(CullPushConstants);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1U;
+		pipelineLayoutInfo.pSetLayouts = &cullSetLayout_;
+		pipelineLayoutInfo.pushConstantRangeCount = 1U;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &cullPipelineLayout_) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create culling pipeline layout");
+		}
+
+		const VkShaderModule computeShaderModule = createShaderModule(EmbeddedShaders::cullCompute());
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = computeShaderModule;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.layout = cullPipelineLayout_;
+		const VkResult result = vkCreateComputePipelines(device_, pipelineCache_.handle(), 1U, &pipelineInfo, nullptr, &cullPipeline_);
+		vkDestroyShaderModule(device_, computeShaderModule, nullptr);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create culling pipeline");
+		}
+
+		createBuffer(instanceSliceSize_ * framesInFlight_,
+					 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+					 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuMemoryPool::Static,
+					 visibleInstanceBuffer_, visibleInstanceAllocation_);
 
-		vkQueueSubmit(graphicsQueue_, 1U, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(graphicsQueue_);
+		std::vector<ModelInfo> modelInfos;
+		for (const SceneModel &model : scene_.models())
+		{
+			const uint32_t index = static_cast<uint32_t>(modelInfos.size());
+			modelInfos.push_back({modelSpheres_[index], modelInstances_[index].first, model.firstSubmesh, model.submeshCount,
+									 modelInstances_[index].count});
+		}
+		const VkDeviceSize modelInfoSize = sizeof(ModelInfo) * modelInfos.size();
+		createBuffer(modelInfoSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+					 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					 GpuMemoryPool::Static, modelInfoBuffer_, modelInfoAllocation_);
+		std::memcpy(modelInfoAllocation_.mapped, modelInfos.data(), static_cast<std::size_t>(modelInfoSize));
 
-		vkFreeCommandBuffers(device_, commandPool_, 1U, &commandBuffer);
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorPool_;
+		allocInfo.descriptorSetCount = 1U;
+		allocInfo.pSetLayouts = &cullSetLayout_;
+		if (vkAllocateDescriptorSets(device_, &allocInfo, &cullDescriptorSet_) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate culling descriptor set");
+		}
+
+		const VkDeviceSize instanceRange = static_cast<VkDeviceSize>(instanceCount_ * sizeof(InstanceData));
+		const VkDeviceSize argumentsRange = drawCommandsOffset_ + sizeof(VkDrawIndexedIndirectCommand) * drawCommandCount();
+		const std::array<VkDescriptorBufferInfo, 4> bufferInfos = {{{instanceBuffer_, 0U, instanceRange},
+																	{visibleInstanceBuffer_, 0U, instanceRange},
+																	{drawArgumentsBuffer_, 0U, argumentsRange},
+																	{modelInfoBuffer_, 0U, modelInfoSize}}};
+		std::array<VkWriteDescriptorSet, 4> descriptorWrites{};
+		for (std::size_t i = 0; i < descriptorWrites.size(); ++i)
+		{
+			descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[i].dstSet = cullDescriptorSet_;
+			descriptorWrites[i].dstBinding = static_cast<uint32_t>(i);
+			descriptorWrites[i].descriptorType = bindings[i].descriptorType;
+			descriptorWrites[i].descriptorCount = 1U;
+			descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+		}
+		vkUpdateDescriptorSets(device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0U, nullptr);
 	}
 
-	void ScopApp::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+	void ScopApp::updateDrawArguments(std::size_t frameIndex)
 	{
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkBufferCopy copyRegion{};
-		copyRegion.size = size;
-		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1U, &copyRegion);
+		std::uint8_t *base = static_cast<std::uint8_t *>(drawArgumentsAllocation_.mapped) + drawArgumentsStride_ * frameIndex;
+		if (cullMode_ == CullMode::Gpu)
+		{
+			// The slot's fence has signalled, so the counts the culling pass
+			// left behind are final; they are framesInFlight_ frames old by now.
+			visibleInstanceCount_ = 0U;
+			for (std::size_t model = 0; model < modelVisible_.size(); ++model)
+			{
+				uint32_t count = 0U;
+				std::memcpy(&count, base + sizeof(DrawHeader) + sizeof(uint32_t) * model, sizeof(count));
+				modelVisible_[model] = count;
+				visibleInstanceCount_ += count;
+			}
+			std::memset(base, 0, static_cast<std::size_t>(drawCommandsOffset_));
+			return;
+		}
+		if (directDraws_)
+		{
+			return;
+		}
 
-		endSingleTimeCommands(commandBuffer);
+		VkDrawIndexedIndirectCommand *commands = reinterpret_cast<VkDrawIndexedIndirectCommand *>(base + drawCommandsOffset_);
+		for (std::size_t i = 0; i < drawCommandCount(); ++i)
+		{
+			const uint32_t model = scene_.submeshes()[i / drawSlices_].model;
+			const uint32_t instanceCount = sliceVisible(static_cast<uint32_t>(modelVisible_[model]), modelInstances_[model].count,
+														static_cast<uint32_t>(i % drawSlices_), drawSlices_);
+			std::memcpy(&commands[i].instanceCount, &instanceCount, sizeof(instanceCount));
+		}
 	}
 
-	void ScopApp::createVertexBuffer()
+	void ScopApp::recordCulling(VkCommandBuffer commandBuffer, const Mat4 &mvp)
 	{
-		const VkDeviceSize bufferSize = sizeof(mesh_.vertices[0]) * mesh_.vertices.size();
-
-		VkBuffer stagingBuffer = VK_NULL_HANDLE;
-		VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-					 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-					 stagingBuffer, stagingBufferMemory);
-
-		void *data = nullptr;
-		vkMapMemory(device_, stagingBufferMemory, 0, bufferSize, 0, &data);
-		std::memcpy(data, mesh_.vertices.data(), static_cast<std::size_t>(bufferSize));
-		vkUnmapMemory(device_, stagingBufferMemory);
-
-		createBuffer(bufferSize,
-					 VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-					 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					 vertexBuffer_, vertexBufferMemory_);
-
-		copyBuffer(stagingBuffer, vertexBuffer_, bufferSize);
-
-		vkDestroyBuffer(device_, stagingBuffer, nullptr);
-		vkFreeMemory(device_, stagingBufferMemory, nullptr);
+		const Frustum frustum = frustumPlanes(mvp);
+		CullPushConstants constants{};
+		for (std::size_t i = 0; i < frustum.size(); ++i)
+		{
+			constants.planes[i] = frustum[i];
+		}
+		constants.counts[0] = static_cast<uint32_t>(instanceCount_);
+		constants.counts[1] = static_cast<uint32_t>(scene_.modelCount());
+		constants.counts[3] = drawSlices_;
+
+		const uint32_t instanceOffset = static_cast<uint32_t>(instanceSliceSize_ * currentFrame_);
+		const std::array<uint32_t, 3> offsets = {instanceOffset, instanceOffset,
+												 static_cast<uint32_t>(drawArgumentsStride_ * currentFrame_)};
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline_);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout_, 0U, 1U,
+								&cullDescriptorSet_, static_cast<uint32_t>(offsets.size()), offsets.data());
+
+		// Pass 0 compacts the visible instances of each model, pass 1 stamps
+		// every model's count into its submeshes' commands.
+		constants.counts[2] = 0U;
+		vkCmdPushConstants(commandBuffer, cullPipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0U,
+						   sizeof(CullPushConstants), &constants);
+		vkCmdDispatch(commandBuffer, (constants.counts[0] + kCullGroupSize - 1U) / kCullGroupSize, 1U, 1U);
+
+		VkMemoryBarrier countBarrier{};
+		countBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		countBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		countBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+							 0U, 1U, &countBarrier, 0U, nullptr, 0U, nullptr);
+
+		constants.counts[2] = 1U;
+		vkCmdPushConstants(commandBuffer, cullPipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0U,
+						   sizeof(CullPushConstants), &constants);
+		vkCmdDispatch(commandBuffer, (constants.counts[1] + kCullGroupSize - 1U) / kCullGroupSize, 1U, 1U);
+
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+							 VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+							 0U, 1U, &barrier, 0U, nullptr, 0U, nullptr);
 	}
 
-	void ScopApp::createIndexBuffer()
+	std::string ScopApp::recordingSummary() const
 	{
-		const VkDeviceSize bufferSize = sizeof(mesh_.indices[0]) * mesh_.indices.size();
-
-		VkBuffer stagingBuffer = VK_NULL_HANDLE;
-		VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-					 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-					 stagingBuffer, stagingBufferMemory);
-
-		void *data = nullptr;
-		vkMapMemory(device_, stagingBufferMemory, 0, bufferSize, 0, &data);
-		std::memcpy(data, mesh_.indices.data(), static_cast<std::size_t>(bufferSize));
-		vkUnmapMemory(device_, stagingBufferMemory);
-
-		createBuffer(bufferSize,
-					 VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-					 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					 indexBuffer_, indexBufferMemory_);
-
-		copyBuffer(stagingBuffer, indexBuffer_, bufferSize);
-
-		vkDestroyBuffer(device_, stagingBuffer, nullptr);
-		vkFreeMemory(device_, stagingBufferMemory, nullptr);
+		std::ostringstream out;
+		out << recordPartitions_ << " partition(s) of " << drawCommandCount() << " draw(s) on "
+			<< std::min(recordThreads_, recordPartitions_) << " thread(s), "
+			<< (recordedFrames_ > 0U ? recordMsTotal_ / static_cast<double>(recordedFrames_) : 0.0) << " ms mean";
+		return out.str();
 	}
 
-	void ScopApp::createUniformBuffers()
+	std::string ScopApp::cullingSummary() const
 	{
-		const VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-		uniformBuffers_.resize(swapChainImages_.size());
-		uniformBuffersMemory_.resize(swapChainImages_.size());
-		uniformBuffersMapped_.resize(swapChainImages_.size());
-
-		for (std::size_t i = 0; i < swapChainImages_.size(); ++i)
-		{
-			createBuffer(bufferSize,
-						 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-						 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-						 uniformBuffers_[i], uniformBuffersMemory_[i]);
-			vkMapMemory(device_, uniformBuffersMemory_[i], 0, bufferSize, 0, &uniformBuffersMapped_[i]);
-		}
+		std::ostringstream out;
+		out << cullModeName(cullMode_) << " culling, " << visibleInstanceCount_ << "/" << instanceCount_ << " visible, "
+			<< (instanceCount_ - std::min(visibleInstanceCount_, instanceCount_)) << " culled";
+		return out.str();
 	}
 
 	void ScopApp::createDescriptorPool()
 	{
-		const std::array<VkDescriptorPoolSize, 2> poolSizes = {{{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, static_cast<uint32_t>(swapChainImages_.size())},
-																{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast<uint32_t>(swapChainImages_.size())}}};
+		const std::array<VkDescriptorPoolSize, 5> poolSizes = {{{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1U},
+																{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1U},
+																{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1U},
+																{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 3U},
+																{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1U}}};
 
 		VkDescriptorPoolCreateInfo poolInfo{};
 		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = static_cast<uint32_t>(swapChainImages_.size());
+		poolInfo.maxSets = 2U;
 
 		if (vkCreateDescriptorPool(device_, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS)
 		{
@@ -1332,63 +2560,71 @@ namespace scop
 
 	void ScopApp::createDescriptorSets()
 	{
-		std::vector<VkDescriptorSetLayout> layouts(swapChainImages_.size(), descriptorSetLayout_);
 		VkDescriptorSetAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 		allocInfo.descriptorPool = descriptorPool_;
-		allocInfo.descriptorSetCount = static_cast<uint32_t>(swapChainImages_.size());
-		allocInfo.pSetLayouts = layouts.data();
+		allocInfo.descriptorSetCount = 1U;
+		allocInfo.pSetLayouts = &descriptorSetLayout_;
 
-		descriptorSets_.resize(swapChainImages_.size());
-		if (vkAllocateDescriptorSets(device_, &allocInfo, descriptorSets_.data()) != VK_SUCCESS)
+		if (vkAllocateDescriptorSets(device_, &allocInfo, &descriptorSet_) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to allocate descriptor sets");
 		}
 
-		for (std::size_t i = 0; i < swapChainImages_.size(); ++i)
-		{
-			VkDescriptorBufferInfo bufferInfo{};
-			bufferInfo.buffer = uniformBuffers_[i];
-			bufferInfo.offset = 0;
-			bufferInfo.range = sizeof(UniformBufferObject);
-
-			VkDescriptorImageInfo imageInfo{};
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = textureImageView_;
-			imageInfo.sampler = textureSampler_;
-
-			std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
-
-			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[0].dstSet = descriptorSets_[i];
-			descriptorWrites[0].dstBinding = 0U;
-			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			descriptorWrites[0].descriptorCount = 1U;
-			descriptorWrites[0].pBufferInfo = &bufferInfo;
-
-			descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[1].dstSet = descriptorSets_[i];
-			descriptorWrites[1].dstBinding = 1U;
-			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			descriptorWrites[1].descriptorCount = 1U;
-			descriptorWrites[1].pImageInfo = &imageInfo;
-
-			vkUpdateDescriptorSets(device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0U, nullptr);
-		}
+		VkDescriptorBufferInfo frameInfo{};
+		frameInfo.buffer = frameUniformBuffer_;
+		frameInfo.offset = 0;
+		frameInfo.range = sizeof(FrameUniforms);
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = textureImageView_;
+		imageInfo.sampler = textureSampler_;
+
+		VkDescriptorBufferInfo materialInfo{};
+		materialInfo.buffer = materialBuffer_;
+		materialInfo.offset = 0;
+		materialInfo.range = sizeof(MaterialUniforms);
+
+		std::array<VkWriteDescriptorSet, 3> descriptorWrites{};
+
+		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[0].dstSet = descriptorSet_;
+		descriptorWrites[0].dstBinding = 0U;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		descriptorWrites[0].descriptorCount = 1U;
+		descriptorWrites[0].pBufferInfo = &frameInfo;
+
+		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[1].dstSet = descriptorSet_;
+		descriptorWrites[1].dstBinding = 1U;
+		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[1].descriptorCount = 1U;
+		descriptorWrites[1].pImageInfo = &imageInfo;
+
+		descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[2].dstSet = descriptorSet_;
+		descriptorWrites[2].dstBinding = 2U;
+		descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[2].descriptorCount = 1U;
+		descriptorWrites[2].pBufferInfo = &materialInfo;
+
+		vkUpdateDescriptorSets(device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0U, nullptr);
 	}
 
-	VkImageView ScopApp::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) const
+	VkImageView ScopApp::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
+										 VkImageViewType viewType, uint32_t layerCount) const
 	{
 		VkImageViewCreateInfo viewInfo{};
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 		viewInfo.image = image;
-		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.viewType = viewType;
 		viewInfo.format = format;
 		viewInfo.subresourceRange.aspectMask = aspectFlags;
 		viewInfo.subresourceRange.baseMipLevel = 0U;
 		viewInfo.subresourceRange.levelCount = 1U;
 		viewInfo.subresourceRange.baseArrayLayer = 0U;
-		viewInfo.subresourceRange.layerCount = 1U;
+		viewInfo.subresourceRange.layerCount = layerCount;
 
 		VkImageView imageView = VK_NULL_HANDLE;
 		if (vkCreateImageView(device_, &viewInfo, nullptr, &imageView) != VK_SUCCESS)
@@ -1429,8 +2665,8 @@ namespace scop
 		return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 	}
 
-	void ScopApp::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
-							  VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory)
+	void ScopApp::createImage(uint32_t width, uint32_t height, uint32_t arrayLayers, VkFormat format, VkImageTiling tiling,
+							  VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, GpuAllocation &allocation)
 	{
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -1439,7 +2675,7 @@ namespace scop
 		imageInfo.extent.height = height;
 		imageInfo.extent.depth = 1U;
 		imageInfo.mipLevels = 1U;
-		imageInfo.arrayLayers = 1U;
+		imageInfo.arrayLayers = arrayLayers;
 		imageInfo.format = format;
 		imageInfo.tiling = tiling;
 		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -1455,151 +2691,91 @@ namespace scop
 		VkMemoryRequirements memRequirements{};
 		vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
+		const GpuResourceKind kind = (tiling == VK_IMAGE_TILING_LINEAR) ? GpuResourceKind::Linear : GpuResourceKind::Optimal;
+		allocation = allocator_.allocate(memRequirements, properties, GpuMemoryPool::Static, kind);
+		if (vkBindImageMemory(device_, image, allocation.memory, allocation.offset) != VK_SUCCESS)
 		{
-			throw std::runtime_error("Failed to allocate image memory");
+			throw std::runtime_error("Failed to bind image memory");
 		}
-
-		vkBindImageMemory(device_, image, imageMemory, 0);
 	}
 
-	void ScopApp::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout)
+	void ScopApp::destroyImage(VkImage &image, GpuAllocation &allocation)
 	{
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkImageMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.oldLayout = oldLayout;
-		barrier.newLayout = newLayout;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.image = image;
-
-		if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-		{
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-			if (hasStencilComponent(format))
-			{
-				barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
-			}
-		}
-		else
-		{
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		}
-
-		barrier.subresourceRange.baseMipLevel = 0U;
-		barrier.subresourceRange.levelCount = 1U;
-		barrier.subresourceRange.baseArrayLayer = 0U;
-		barrier.subresourceRange.layerCount = 1U;
-
-		VkPipelineStageFlags sourceStage = 0;
-		VkPipelineStageFlags destinationStage = 0;
-
-		if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+		if (image != VK_NULL_HANDLE)
 		{
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			vkDestroyImage(device_, image, nullptr);
+			image = VK_NULL_HANDLE;
 		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		{
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-		{
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		}
-		else
-		{
-			throw std::runtime_error("Unsupported layout transition");
-		}
-
-		vkCmdPipelineBarrier(
-			commandBuffer,
-			sourceStage, destinationStage,
-			0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier);
-
-		endSingleTimeCommands(commandBuffer);
-	}
-
-	void ScopApp::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
-	{
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkBufferImageCopy region{};
-		region.bufferOffset = 0;
-		region.bufferRowLength = 0;
-		region.bufferImageHeight = 0;
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0U;
-		region.imageSubresource.baseArrayLayer = 0U;
-		region.imageSubresource.layerCount = 1U;
-		region.imageOffset = {0, 0, 0};
-		region.imageExtent = {width, height, 1U};
-
-		vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1U, &region);
-		endSingleTimeCommands(commandBuffer);
+		allocator_.free(allocation);
 	}
 
 	void ScopApp::createDepthResources()
 	{
 		const VkFormat depthFormat = findDepthFormat();
-		createImage(swapChainExtent_.width, swapChainExtent_.height, depthFormat, VK_IMAGE_TILING_OPTIMAL,
+		createImage(swapChainExtent_.width, swapChainExtent_.height, 1U, depthFormat, VK_IMAGE_TILING_OPTIMAL,
 					VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					depthImage_, depthImageMemory_);
-		depthImageView_ = createImageView(depthImage_, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
-		transitionImageLayout(depthImage_, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+					depthImage_, depthImageAllocation_);
+		depthImageView_ = createImageView(depthImage_, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_VIEW_TYPE_2D, 1U);
 	}
 
 	void ScopApp::createTextureImage()
 	{
-		TextureImage image = textureData_.empty() ? TextureLoader::makeFallbackCheckerboard() : textureData_;
+		std::vector<const TextureImage *> layers;
+		const TextureImage fallback = TextureLoader::makeFallbackCheckerboard();
+		layers.push_back(textureData_.empty() ? &fallback : &textureData_);
+		for (const TextureImage &texture : sceneTextures_)
+		{
+			layers.push_back(&texture);
+		}
 
-		const VkDeviceSize imageSize = static_cast<VkDeviceSize>(image.width) * static_cast<VkDeviceSize>(image.height) * 4U;
-		VkBuffer stagingBuffer = VK_NULL_HANDLE;
-		VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
+		// Array layers share one size: the largest texture, capped by the
+		// device limit and halved until the array fits kTextureArrayBudget.
+		// Other textures are resampled to it.
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+		uint32_t width = 1U;
+		uint32_t height = 1U;
+		for (const TextureImage *layer : layers)
+		{
+			width = std::max(width, layer->width);
+			height = std::max(height, layer->height);
+		}
+		width = std::min(width, properties.limits.maxImageDimension2D);
+		height = std::min(height, properties.limits.maxImageDimension2D);
+		const uint32_t layerCount = static_cast<uint32_t>(std::min<std::size_t>(layers.size(), properties.limits.maxImageArrayLayers));
+		if (layerCount < layers.size())
+		{
+			std::cerr << "Warning: device supports " << layerCount << " texture layers, scene needs " << layers.size() << std::endl;
+		}
 
-		createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-					 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-					 stagingBuffer, stagingBufferMemory);
+		while (static_cast<VkDeviceSize>(width) * height * 4U * layerCount > kTextureArrayBudget && (width > 1U || height > 1U))
+		{
+			width = std::max(width / 2U, 1U);
+			height = std::max(height / 2U, 1U);
+		}
 
-		void *data = nullptr;
-		vkMapMemory(device_, stagingBufferMemory, 0, imageSize, 0, &data);
-		std::memcpy(data, image.pixels.data(), static_cast<std::size_t>(imageSize));
-		vkUnmapMemory(device_, stagingBufferMemory);
+		const VkDeviceSize layerSize = static_cast<VkDeviceSize>(width) * static_cast<VkDeviceSize>(height) * 4U;
+		TrackedVector<std::uint8_t, MemoryTag::Texture> pixels(static_cast<std::size_t>(layerSize * layerCount));
+		for (uint32_t i = 0; i < layerCount; ++i)
+		{
+			const TextureImage layer = TextureLoader::resized(*layers[i], width, height);
+			std::memcpy(pixels.data() + layerSize * i, layer.pixels.data(), static_cast<std::size_t>(layerSize));
+		}
 
-		createImage(image.width, image.height, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
+		createImage(width, height, layerCount, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
 					VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					textureImage_, textureImageMemory_);
-
-		transitionImageLayout(textureImage_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		copyBufferToImage(stagingBuffer, textureImage_, image.width, image.height);
-		transitionImageLayout(textureImage_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+					textureImage_, textureImageAllocation_);
+		textureLayerCount_ = layerCount;
 
-		vkDestroyBuffer(device_, stagingBuffer, nullptr);
-		vkFreeMemory(device_, stagingBufferMemory, nullptr);
+		uploader_.uploadImage(pixels.data(), layerSize * layerCount, textureImage_, width, height, layerCount,
+							  VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
 	}
 
 	void ScopApp::createTextureImageView()
 	{
-		textureImageView_ = createImageView(textureImage_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
+		textureImageView_ = createImageView(textureImage_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT,
+											VK_IMAGE_VIEW_TYPE_2D_ARRAY, textureLayerCount_);
 	}
 
 	void ScopApp::createTextureSampler()
@@ -1614,8 +2790,10 @@ namespace scop
 		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.anisotropyEnable = VK_TRUE;
-		samplerInfo.maxAnisotropy = std::min(8.0f, properties.limits.maxSamplerAnisotropy);
+		VkPhysicalDeviceFeatures features{};
+		vkGetPhysicalDeviceFeatures(physicalDevice_, &features);
+		samplerInfo.anisotropyEnable = features.samplerAnisotropy;
+		samplerInfo.maxAnisotropy = features.samplerAnisotropy == VK_TRUE ? std::min(8.0f, properties.limits.maxSamplerAnisotropy) : 1.0f;
 		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 		samplerInfo.unnormalizedCoordinates = VK_FALSE;
 		samplerInfo.compareEnable = VK_FALSE;
@@ -1631,7 +2809,7 @@ namespace scop
 
 	void ScopApp::createCommandBuffers()
 	{
-		commandBuffers_.resize(swapChainFramebuffers_.size());
+		commandBuffers_.resize(framesInFlight_);
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -1643,54 +2821,298 @@ namespace scop
 		{
 			throw std::runtime_error("Failed to allocate command buffers");
 		}
+	}
 
-		for (std::size_t i = 0; i < commandBuffers_.size(); ++i)
+	void ScopApp::planRecording()
+	{
+		recordThreads_ = (options_.recordThreads == 0U) ? threadPool_.workerCount() + 1U : options_.recordThreads;
+		// With fewer submeshes than threads, as with one model drawn as many
+		// instances, each submesh's instances are sliced as well so every
+		// thread still gets draws to record.
+		const std::size_t submeshCount = std::max<std::size_t>(scene_.submeshes().size(), 1U);
+		std::size_t largestModel = 1U;
+		for (const InstanceRange &range : modelInstances_)
+		{
+			largestModel = std::max<std::size_t>(largestModel, range.count);
+		}
+		drawSlices_ = static_cast<uint32_t>(std::min((recordThreads_ + submeshCount - 1U) / submeshCount, largestModel));
+		recordPartitions_ = std::max<std::size_t>(std::min(recordThreads_, drawCommandCount()), 1U);
+	}
+
+	void ScopApp::createSecondaryCommandBuffers()
+	{
+		if (recordPartitions_ == 1U)
 		{
-			VkCommandBufferBeginInfo beginInfo{};
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			return;
+		}
+
+		const QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice_);
+		secondaryPools_.assign(framesInFlight_ * recordPartitions_, VK_NULL_HANDLE);
+		secondaryBuffers_.assign(secondaryPools_.size(), VK_NULL_HANDLE);
+		for (std::size_t i = 0; i < secondaryPools_.size(); ++i)
+		{
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+			if (vkCreateCommandPool(device_, &poolInfo, nullptr, &secondaryPools_[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create secondary command pool");
+			}
 
-			if (vkBeginCommandBuffer(commandBuffers_[i], &beginInfo) != VK_SUCCESS)
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = secondaryPools_[i];
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1U;
+			if (vkAllocateCommandBuffers(device_, &allocInfo, &secondaryBuffers_[i]) != VK_SUCCESS)
 			{
-				throw std::runtime_error("Failed to begin command buffer recording");
+				throw std::runtime_error("Failed to allocate secondary command buffers");
 			}
+		}
+	}
 
-			std::array<VkClearValue, 2> clearValues{};
-			clearValues[0].color = {{0.06f, 0.06f, 0.08f, 1.0f}};
-			clearValues[1].depthStencil = {1.0f, 0U};
+	void ScopApp::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const MeshPushConstants &pushConstants)
+	{
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin command buffer recording");
+		}
+
+		std::array<VkClearValue, 2> clearValues{};
+		clearValues[0].color = {{0.06f, 0.06f, 0.08f, 1.0f}};
+		clearValues[1].depthStencil = {1.0f, 0U};
+
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = renderPass_;
+		renderPassInfo.framebuffer = swapChainFramebuffers_[imageIndex];
+		renderPassInfo.renderArea.offset = {0, 0};
+		renderPassInfo.renderArea.extent = swapChainExtent_;
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassInfo.pClearValues = clearValues.data();
+
+		graphicsPipeline_ = pipelineVariant(shadingVariant());
+		// Secondaries may only execute inside the statistics query when they
+		// inherit it, which needs inheritedQueries.
+		gpuProfiler_.begin(commandBuffer, currentFrame_, recordPartitions_ == 1U || inheritedQueries_);
+		if (cullMode_ == CullMode::Gpu)
+		{
+			recordCulling(commandBuffer, pushConstants.mvp);
+		}
+		const uint32_t drawCount = static_cast<uint32_t>(drawCommandCount());
+		const auto recordBegin = std::chrono::steady_clock::now();
+		if (recordPartitions_ == 1U)
+		{
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+			recordDraws(commandBuffer, pushConstants, 0U, drawCount);
+		}
+		else
+		{
+			// Each range is claimed by exactly one thread, so its pool is
+			// never used concurrently; the frame fence has already retired
+			// the buffers recorded into it last time.
+			const std::size_t partitions = recordPartitions_;
+			VkCommandBuffer *secondaries = &secondaryBuffers_[currentFrame_ * partitions];
+			const VkFramebuffer framebuffer = renderPassInfo.framebuffer;
+			threadPool_.parallelFor(partitions, 1U, [this, &pushConstants, secondaries, framebuffer, partitions, drawCount](std::size_t begin, std::size_t end)
+			{
+				for (std::size_t partition = begin; partition < end; ++partition)
+				{
+					SCOP_PROFILE_ZONE("Record partition");
+					vkResetCommandPool(device_, secondaryPools_[currentFrame_ * partitions + partition], 0U);
+
+					VkCommandBufferInheritanceInfo inheritance{};
+					inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+					inheritance.renderPass = renderPass_;
+					inheritance.subpass = 0U;
+					inheritance.framebuffer = framebuffer;
+					inheritance.pipelineStatistics = inheritedQueries_ ? gpuProfiler_.pipelineStatisticFlags() : 0U;
+
+					VkCommandBufferBeginInfo secondaryBegin{};
+					secondaryBegin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+					secondaryBegin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+					secondaryBegin.pInheritanceInfo = &inheritance;
+					if (vkBeginCommandBuffer(secondaries[partition], &secondaryBegin) != VK_SUCCESS)
+					{
+						throw std::runtime_error("Failed to begin secondary command buffer");
+					}
+					const uint32_t first = static_cast<uint32_t>(drawCount * partition / partitions);
+					const uint32_t last = static_cast<uint32_t>(drawCount * (partition + 1U) / partitions);
+					recordDraws(secondaries[partition], pushConstants, first, last);
+					if (vkEndCommandBuffer(secondaries[partition]) != VK_SUCCESS)
+					{
+						throw std::runtime_error("Failed to record secondary command buffer");
+					}
+				}
+			});
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(partitions), secondaries);
+		}
+		recordMsTotal_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordBegin).count();
+		++recordedFrames_;
+		vkCmdEndRenderPass(commandBuffer);
+		if (cullMode_ == CullMode::Gpu)
+		{
+			// Makes the visible count available to updateDrawArguments() once
+			// the frame fence has signalled.
+			VkMemoryBarrier readback{};
+			readback.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			readback.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			readback.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+								 0U, 1U, &readback, 0U, nullptr, 0U, nullptr);
+		}
+		gpuProfiler_.end(commandBuffer, currentFrame_);
+		if (!readbackBuffers_.empty())
+		{
+			recordReadback(commandBuffer, imageIndex);
+		}
 
-			VkRenderPassBeginInfo renderPassInfo{};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = renderPass_;
-			renderPassInfo.framebuffer = swapChainFramebuffers_[i];
-			renderPassInfo.renderArea.offset = {0, 0};
-			renderPassInfo.renderArea.extent = swapChainExtent_;
-			renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-			renderPassInfo.pClearValues = clearValues.data();
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record command buffer");
+		}
+	}
 
-			vkCmdBeginRenderPass(commandBuffers_[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-			vkCmdBindPipeline(commandBuffers_[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
+	// Binds the scene state and draws commands [firstDraw, endDraw);
+	// secondary buffers inherit nothing, so every range binds everything.
+	void ScopApp::recordDraws(VkCommandBuffer commandBuffer, const MeshPushConstants &pushConstants,
+							  uint32_t firstDraw, uint32_t endDraw)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
 
-			VkBuffer vertexBuffers[] = {vertexBuffer_};
-			VkDeviceSize offsets[] = {0};
-			vkCmdBindVertexBuffers(commandBuffers_[i], 0U, 1U, vertexBuffers, offsets);
-			vkCmdBindIndexBuffer(commandBuffers_[i], indexBuffer_, 0U, VK_INDEX_TYPE_UINT32);
-			vkCmdBindDescriptorSets(commandBuffers_[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0U, 1U,
-									&descriptorSets_[i], 0U, nullptr);
-			vkCmdDrawIndexed(commandBuffers_[i], static_cast<uint32_t>(mesh_.indices.size()), 1U, 0U, 0, 0U);
-			vkCmdEndRenderPass(commandBuffers_[i]);
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(swapChainExtent_.width);
+		viewport.height = static_cast<float>(swapChainExtent_.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0U, 1U, &viewport);
 
-			if (vkEndCommandBuffer(commandBuffers_[i]) != VK_SUCCESS)
+		VkRect2D scissor{};
+		scissor.offset = {0, 0};
+		scissor.extent = swapChainExtent_;
+		vkCmdSetScissor(commandBuffer, 0U, 1U, &scissor);
+
+		VkBuffer vertexBuffers[] = {vertexBuffer_, (cullMode_ == CullMode::Gpu) ? visibleInstanceBuffer_ : instanceBuffer_};
+		VkDeviceSize offsets[] = {0, instanceSliceSize_ * currentFrame_};
+		vkCmdBindVertexBuffers(commandBuffer, 0U, 2U, vertexBuffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer_, 0U, VK_INDEX_TYPE_UINT32);
+		const uint32_t frameOffset = static_cast<uint32_t>(frameUniformStride_ * currentFrame_);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0U, 1U,
+								&descriptorSet_, 1U, &frameOffset);
+		vkCmdPushConstants(commandBuffer, pipelineLayout_, VK_SHADER_STAGE_VERTEX_BIT, 0U,
+						   sizeof(MeshPushConstants), &pushConstants);
+		// Every submesh comes from the same vertex and index buffers, so a
+		// range is one bind and as few indirect calls as the device allows.
+		const VkDeviceSize slotOffset = drawArgumentsStride_ * currentFrame_;
+		if (directDraws_)
+		{
+			for (uint32_t index = firstDraw; index < endDraw; ++index)
+			{
+				const Submesh &submesh = scene_.submeshes()[index / drawSlices_];
+				const InstanceRange &range = modelInstances_[submesh.model];
+				const uint32_t slice = index % drawSlices_;
+				const uint32_t instanceCount = sliceVisible(static_cast<uint32_t>(modelVisible_[submesh.model]), range.count, slice, drawSlices_);
+				if (instanceCount > 0U)
+				{
+					vkCmdDrawIndexed(commandBuffer, submesh.indexCount, instanceCount, submesh.firstIndex,
+									 submesh.vertexOffset, range.first + sliceStart(range.count, slice, drawSlices_));
+				}
+			}
+		}
+		else
+		{
+			for (uint32_t first = firstDraw; first < endDraw; first += maxDrawsPerCall_)
 			{
-				throw std::runtime_error("Failed to record command buffer");
+				const uint32_t drawCount = std::min(maxDrawsPerCall_, endDraw - first);
+				const VkDeviceSize commandOffset = slotOffset + drawCommandsOffset_ + sizeof(VkDrawIndexedIndirectCommand) * first;
+				if (cullMode_ == CullMode::Gpu)
+				{
+					drawIndexedIndirectCount_(commandBuffer, drawArgumentsBuffer_, commandOffset,
+											  drawArgumentsBuffer_, slotOffset + offsetof(DrawHeader, drawCount),
+											  drawCount, sizeof(VkDrawIndexedIndirectCommand));
+				}
+				else
+				{
+					vkCmdDrawIndexedIndirect(commandBuffer, drawArgumentsBuffer_, commandOffset, drawCount,
+											 sizeof(VkDrawIndexedIndirectCommand));
+				}
 			}
 		}
 	}
 
+	void ScopApp::recordReadback(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		// The render pass leaves the image in TRANSFER_SRC_OPTIMAL and its
+		// outgoing dependency orders the colour writes before this copy.
+		VkBufferImageCopy region{};
+		region.bufferOffset = 0U;
+		region.bufferRowLength = 0U;
+		region.bufferImageHeight = 0U;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0U;
+		region.imageSubresource.baseArrayLayer = 0U;
+		region.imageSubresource.layerCount = 1U;
+		region.imageOffset = {0, 0, 0};
+		region.imageExtent = {swapChainExtent_.width, swapChainExtent_.height, 1U};
+		vkCmdCopyImageToBuffer(commandBuffer, swapChainImages_[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+							   readbackBuffers_[imageIndex], 1U, &region);
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = readbackBuffers_[imageIndex];
+		barrier.offset = 0U;
+		barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0U,
+							 0U, nullptr, 1U, &barrier, 0U, nullptr);
+	}
+
+	void ScopApp::writeReadback(std::size_t slot)
+	{
+		if (readbackFrames_.empty() || !readbackFrames_[slot].has_value())
+		{
+			return;
+		}
+		SCOP_PROFILE_FUNCTION();
+		const std::size_t frame = readbackFrames_[slot].value();
+		readbackFrames_[slot].reset();
+
+		const std::size_t pixelCount = static_cast<std::size_t>(swapChainExtent_.width) * swapChainExtent_.height;
+		const std::string header = "P6\n" + std::to_string(swapChainExtent_.width) + " " +
+								   std::to_string(swapChainExtent_.height) + "\n255\n";
+		std::vector<std::uint8_t> ppm(header.begin(), header.end());
+		ppm.resize(header.size() + pixelCount * 3U);
+
+		const std::uint8_t *rgba = static_cast<const std::uint8_t *>(readbackAllocations_[slot].mapped);
+		std::uint8_t *rgb = ppm.data() + header.size();
+		for (std::size_t i = 0; i < pixelCount; ++i)
+		{
+			rgb[i * 3U + 0U] = rgba[i * 4U + 0U];
+			rgb[i * 3U + 1U] = rgba[i * 4U + 1U];
+			rgb[i * 3U + 2U] = rgba[i * 4U + 2U];
+		}
+
+		std::ostringstream name;
+		name << options_.dumpFramesDir << "/frame_" << std::setw(4) << std::setfill('0') << frame << ".ppm";
+		writeBinaryFile(name.str(), ppm.data(), ppm.size());
+	}
+
 	void ScopApp::createSyncObjects()
 	{
-		imageAvailableSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-		renderFinishedSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-		inFlightFences_.resize(MAX_FRAMES_IN_FLIGHT);
+		imageAvailableSemaphores_.resize(framesInFlight_);
+		renderFinishedSemaphores_.resize(framesInFlight_);
+		inFlightFences_.resize(framesInFlight_);
 		imagesInFlight_.assign(swapChainImages_.size(), VK_NULL_HANDLE);
 
 		VkSemaphoreCreateInfo semaphoreInfo{};
@@ -1700,7 +3122,7 @@ namespace scop
 		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		for (std::size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		for (std::size_t i = 0; i < framesInFlight_; ++i)
 		{
 			if (vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &imageAvailableSemaphores_[i]) != VK_SUCCESS ||
 				vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &renderFinishedSemaphores_[i]) != VK_SUCCESS ||
@@ -1713,6 +3135,7 @@ namespace scop
 
 	void ScopApp::recreateSwapChain()
 	{
+		SCOP_PROFILE_FUNCTION();
 		int width = 0;
 		int height = 0;
 		glfwGetFramebufferSize(window_, &width, &height);
@@ -1723,78 +3146,74 @@ namespace scop
 			glfwWaitEvents();
 		}
 
-		vkDeviceWaitIdle(device_);
+		// Only work that may still reference the swapchain images has to
+		// finish; the upload queue and the rest of the device keep going.
+		vkWaitForFences(device_, static_cast<uint32_t>(inFlightFences_.size()), inFlightFences_.data(), VK_TRUE, UINT64_MAX);
+		latency_.dropPendingPresents();
 
+		const VkFormat previousFormat = swapChainImageFormat_;
 		cleanupSwapChain();
 		createSwapChain();
 		createImageViews();
-		createRenderPass();
-		createGraphicsPipeline();
+		updateProjection();
+		if (swapChainImageFormat_ != previousFormat)
+		{
+			cleanupPipeline();
+			createRenderPass();
+			createGraphicsPipeline();
+		}
 		createDepthResources();
 		createFramebuffers();
-		createUniformBuffers();
-		createDescriptorPool();
-		createDescriptorSets();
-		createCommandBuffers();
 		imagesInFlight_.assign(swapChainImages_.size(), VK_NULL_HANDLE);
 	}
 
-	void ScopApp::updateUniformBuffer(uint32_t imageIndex, float dt)
+	MeshPushConstants ScopApp::updateFrameData(std::size_t frameIndex, float dt)
 	{
-		const float blendSpeed = 2.5f;
-
-		if (textureBlend_ < targetTextureBlend_)
-		{
-			textureBlend_ += blendSpeed * dt;
-			if (textureBlend_ > targetTextureBlend_)
-				textureBlend_ = targetTextureBlend_;
-		}
-		else if (textureBlend_ > targetTextureBlend_)
-		{
-			textureBlend_ -= blendSpeed * dt;
-			if (textureBlend_ < targetTextureBlend_)
-				textureBlend_ = targetTextureBlend_;
-		}
-
-		if (!rotationPaused_)
+		if (!simulation_.threaded())
 		{
-			rotationAngle_ += rotationSpeed_ * dt;
+			simulation_.advance(dt);
 		}
+		const SimulationFrame simulated = simulation_.sample(Simulation::Clock::now());
+		frameState_ = simulated.state;
+		frameSettled_ = simulated.settled;
 
-		UniformBufferObject ubo{};
-
-		Mat4 model = Mat4::translation(translation_) * Mat4::rotationY(rotationAngle_);
-		Mat4 view = Mat4::translation(Vec3(0.0f, 0.0f, -3.0f));
-		Mat4 proj = Mat4::perspective(45.0f, static_cast<float>(swapChainExtent_.width) / static_cast<float>(swapChainExtent_.height), 0.1f, 100.0f);
-
-		ubo.model = model;
-		ubo.view = view;
-		ubo.proj = proj;
-		ubo.proj(1, 1) *= -1.0f;
-
-		ubo.params[0] = textureBlend_;
-		ubo.params[1] = hasRealTexture_ ? 1.0f : 0.0f;
-		ubo.params[2] = hasMaterial_ ? 1.0f : 0.0f;
-		ubo.params[3] = 0.0f;
+		const Mat4 model = Mat4::translation(frameState_.translation) * Mat4::rotationY(frameState_.rotationAngle);
+		MeshPushConstants pushConstants;
+		pushConstants.mvp = viewProjection_ * model;
+		pushConstants.normalMatrix = normalMatrix(model);
 
-		ubo.kd[0] = materialKd_.x;
-		ubo.kd[1] = materialKd_.y;
-		ubo.kd[2] = materialKd_.z;
-		ubo.kd[3] = 1.0f;
+		updateInstances(frameIndex, frustumPlanes(pushConstants.mvp));
+		updateDrawArguments(frameIndex);
 
-		ubo.ksNs[0] = materialKs_.x;
-		ubo.ksNs[1] = materialKs_.y;
-		ubo.ksNs[2] = materialKs_.z;
-		ubo.ksNs[3] = materialNs_;
-
-		std::memcpy(uniformBuffersMapped_[imageIndex], &ubo, sizeof(ubo));
+		FrameUniforms frame{};
+		frame.params[0] = frameState_.textureBlend;
+		std::memcpy(static_cast<std::uint8_t *>(frameUniformAllocation_.mapped) + frameUniformStride_ * frameIndex,
+					&frame, sizeof(frame));
+		return pushConstants;
 	}
 
-	void ScopApp::processEvents(bool &running, float dt)
+	void ScopApp::updateProjection()
 	{
-		const float moveSpeed = 1.8f * dt;
+		// A single model keeps the original framing; a field of instances or
+		// a row of models is viewed from above and behind so everything fits.
+		Mat4 view = Mat4::translation(Vec3(0.0f, 0.0f, -3.0f));
+		float farPlane = 100.0f;
+		if (fieldExtent_ > kInstanceSpacing)
+		{
+			const float distance = 3.0f + fieldExtent_ * 0.9f;
+			view = Mat4::lookAt(Vec3(0.0f, distance * 0.6f, distance), Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f));
+			farPlane = std::max(farPlane, distance * 2.0f + fieldExtent_);
+		}
+		Mat4 proj = Mat4::perspective(45.0f, static_cast<float>(swapChainExtent_.width) / static_cast<float>(swapChainExtent_.height), 0.1f, farPlane);
+		proj(1, 1) *= -1.0f;
+		viewProjection_ = proj * view;
+	}
 
+	void ScopApp::processEvents(bool &running)
+	{
+		SCOP_PROFILE_FUNCTION();
 		glfwPollEvents();
+		const LatencyTracker::Clock::time_point polledAt = LatencyTracker::Clock::now();
 
 		if (glfwWindowShouldClose(window_))
 		{
@@ -1805,79 +3224,90 @@ namespace scop
 		const bool tNow = (glfwGetKey(window_, GLFW_KEY_T) == GLFW_PRESS);
 		const bool spaceNow = (glfwGetKey(window_, GLFW_KEY_SPACE) == GLFW_PRESS);
 		const bool rNow = (glfwGetKey(window_, GLFW_KEY_R) == GLFW_PRESS);
+		const bool f5Now = (glfwGetKey(window_, GLFW_KEY_F5) == GLFW_PRESS);
 
 		if (escNow && !prevEscape_)
 		{
 			running = false;
 		}
-		if (tNow && !prevT_)
-		{
-			if (hasRealTexture_ || hasMaterial_)
-			{
-				textureEnabled_ = !textureEnabled_;
-				targetTextureBlend_ = textureEnabled_ ? 1.0f : 0.0f;
-			}
-			else
-			{
-				textureEnabled_ = false;
-				textureBlend_ = 0.0f;
-				targetTextureBlend_ = 0.0f;
-			}
-		}
-		if (spaceNow && !prevSpace_)
-		{
-			rotationPaused_ = !rotationPaused_;
-		}
-		if (rNow && !prevR_)
+		if (f5Now && !prevF5_)
 		{
-			translation_ = Vec3(0.0f, 0.0f, 0.0f);
-			rotationAngle_ = 0.0f;
-			targetTextureBlend_ = textureEnabled_ && !textureData_.empty() ? 1.0f : 0.0f;
+			reloadRequested_ = true;
+			redrawRequested_ = true;
 		}
 
+		// Only the key state is read here; the simulation applies it on
+		// its next tick.
+		SimulationInput input{};
+		input.togglePresses = (tNow && !prevT_) ? 1U : 0U;
+		input.pausePresses = (spaceNow && !prevSpace_) ? 1U : 0U;
+		input.resetPresses = (rNow && !prevR_) ? 1U : 0U;
+		input.left = glfwGetKey(window_, GLFW_KEY_LEFT) == GLFW_PRESS;
+		input.right = glfwGetKey(window_, GLFW_KEY_RIGHT) == GLFW_PRESS;
+		input.up = glfwGetKey(window_, GLFW_KEY_UP) == GLFW_PRESS;
+		input.down = glfwGetKey(window_, GLFW_KEY_DOWN) == GLFW_PRESS;
+		input.forward = glfwGetKey(window_, GLFW_KEY_PAGE_UP) == GLFW_PRESS || glfwGetKey(window_, GLFW_KEY_Q) == GLFW_PRESS;
+		input.backward = glfwGetKey(window_, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS || glfwGetKey(window_, GLFW_KEY_E) == GLFW_PRESS;
+		simulation_.submitInput(input);
+
 		prevEscape_ = escNow;
 		prevT_ = tNow;
 		prevSpace_ = spaceNow;
 		prevR_ = rNow;
+		prevF5_ = f5Now;
 
-		if (glfwGetKey(window_, GLFW_KEY_LEFT) == GLFW_PRESS)
-		{
-			translation_.x -= moveSpeed;
-		}
-		if (glfwGetKey(window_, GLFW_KEY_RIGHT) == GLFW_PRESS)
+		if (input.active())
 		{
-			translation_.x += moveSpeed;
+			latency_.markInput(polledAt);
+			redrawRequested_ = true;
 		}
-		if (glfwGetKey(window_, GLFW_KEY_UP) == GLFW_PRESS)
-		{
-			translation_.y += moveSpeed;
-		}
-		if (glfwGetKey(window_, GLFW_KEY_DOWN) == GLFW_PRESS)
-		{
-			translation_.y -= moveSpeed;
-		}
-		if (glfwGetKey(window_, GLFW_KEY_PAGE_UP) == GLFW_PRESS || glfwGetKey(window_, GLFW_KEY_Q) == GLFW_PRESS)
+	}
+
+	void ScopApp::pollPresentCompletion()
+	{
+		if (!presentWaitSupported_)
 		{
-			translation_.z += moveSpeed;
+			return;
 		}
-		if (glfwGetKey(window_, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS || glfwGetKey(window_, GLFW_KEY_E) == GLFW_PRESS)
+		for (uint64_t presentId = latency_.oldestPendingPresent(); presentId != 0U; presentId = latency_.oldestPendingPresent())
 		{
-			translation_.z -= moveSpeed;
+			const VkResult result = waitForPresent_(device_, swapChain_, presentId, 0U);
+			if (result == VK_TIMEOUT)
+			{
+				break;
+			}
+			if (result != VK_SUCCESS)
+			{
+				latency_.dropPendingPresents();
+				break;
+			}
+			latency_.presentsCompleted(presentId, LatencyTracker::Clock::now());
 		}
 	}
 
-	void ScopApp::drawFrame()
+	void ScopApp::drawFrame(bool &running)
 	{
-		static auto previousFrameTime = std::chrono::high_resolution_clock::now();
+		SCOP_PROFILE_FUNCTION();
 		const auto now = std::chrono::high_resolution_clock::now();
-		const float dt = std::chrono::duration<float>(now - previousFrameTime).count();
-		previousFrameTime = now;
+		const float dt = benchmark_ ? Benchmark::kFixedDt : std::chrono::duration<float>(now - previousDrawTime_).count();
+		previousDrawTime_ = now;
 
-		vkWaitForFences(device_, 1U, &inFlightFences_[currentFrame_], VK_TRUE, UINT64_MAX);
+		{
+			SCOP_PROFILE_ZONE("Wait frame fence");
+			vkWaitForFences(device_, 1U, &inFlightFences_[currentFrame_], VK_TRUE, UINT64_MAX);
+		}
+		fenceWaitMs_ = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - now).count();
+		uploader_.collect();
+		collectGpuTiming(currentFrame_);
+		pollPresentCompletion();
 
 		uint32_t imageIndex = 0U;
-		VkResult result = vkAcquireNextImageKHR(device_, swapChain_, UINT64_MAX,
-												imageAvailableSemaphores_[currentFrame_], VK_NULL_HANDLE, &imageIndex);
+		VkResult result = VK_SUCCESS;
+		{
+			SCOP_PROFILE_ZONE("Acquire image");
+			result = vkAcquireNextImageKHR(device_, swapChain_, UINT64_MAX,
+										   imageAvailableSemaphores_[currentFrame_], VK_NULL_HANDLE, &imageIndex);
+		}
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
@@ -1891,11 +3321,28 @@ namespace scop
 
 		if (imagesInFlight_[imageIndex] != VK_NULL_HANDLE)
 		{
+			SCOP_PROFILE_ZONE("Wait image fence");
+			const auto waitBegin = std::chrono::high_resolution_clock::now();
 			vkWaitForFences(device_, 1U, &imagesInFlight_[imageIndex], VK_TRUE, UINT64_MAX);
+			fenceWaitMs_ += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - waitBegin).count();
 		}
 		imagesInFlight_[imageIndex] = inFlightFences_[currentFrame_];
 
-		updateUniformBuffer(imageIndex, dt);
+		if (options_.lateLatch)
+		{
+			processEvents(running);
+		}
+		const std::optional<LatencyTracker::Clock::time_point> input = latency_.consumeInput();
+
+		MeshPushConstants pushConstants{};
+		{
+			SCOP_PROFILE_ZONE("Update frame data");
+			pushConstants = updateFrameData(currentFrame_, dt);
+		}
+		{
+			SCOP_PROFILE_ZONE("Record commands");
+			recordCommandBuffer(commandBuffers_[currentFrame_], imageIndex, pushConstants);
+		}
 
 		VkSubmitInfo submitInfo{};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -1907,17 +3354,22 @@ namespace scop
 		submitInfo.pWaitDstStageMask = waitStages;
 
 		submitInfo.commandBufferCount = 1U;
-		submitInfo.pCommandBuffers = &commandBuffers_[imageIndex];
+		submitInfo.pCommandBuffers = &commandBuffers_[currentFrame_];
 
 		const VkSemaphore signalSemaphores[] = {renderFinishedSemaphores_[currentFrame_]};
 		submitInfo.signalSemaphoreCount = 1U;
 		submitInfo.pSignalSemaphores = signalSemaphores;
 
-		vkResetFences(device_, 1U, &inFlightFences_[currentFrame_]);
-		if (vkQueueSubmit(graphicsQueue_, 1U, &submitInfo, inFlightFences_[currentFrame_]) != VK_SUCCESS)
 		{
-			throw std::runtime_error("Failed to submit draw command buffer");
+			SCOP_PROFILE_ZONE("Submit");
+			vkResetFences(device_, 1U, &inFlightFences_[currentFrame_]);
+			if (vkQueueSubmit(graphicsQueue_, 1U, &submitInfo, inFlightFences_[currentFrame_]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to submit draw command buffer");
+			}
 		}
+		const uint64_t presentId = presentWaitSupported_ ? ++lastPresentId_ : 0U;
+		latency_.frameSubmitted(input, presentId, LatencyTracker::Clock::now());
 
 		VkPresentInfoKHR presentInfo{};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1929,7 +3381,19 @@ namespace scop
 		presentInfo.pSwapchains = swapChains;
 		presentInfo.pImageIndices = &imageIndex;
 
-		result = vkQueuePresentKHR(presentQueue_, &presentInfo);
+		VkPresentIdKHR presentIdInfo{};
+		if (presentWaitSupported_)
+		{
+			presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+			presentIdInfo.swapchainCount = 1U;
+			presentIdInfo.pPresentIds = &presentId;
+			presentInfo.pNext = &presentIdInfo;
+		}
+
+		{
+			SCOP_PROFILE_ZONE("Present");
+			result = vkQueuePresentKHR(presentQueue_, &presentInfo);
+		}
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized_)
 		{
 			framebufferResized_ = false;
@@ -1940,7 +3404,7 @@ namespace scop
 			throw std::runtime_error("Failed to present swap chain image");
 		}
 
-		currentFrame_ = (currentFrame_ + 1U) % MAX_FRAMES_IN_FLIGHT;
+		currentFrame_ = (currentFrame_ + 1U) % framesInFlight_;
 	}
 
 } // namespace scop
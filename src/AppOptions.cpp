@@ -0,0 +1,417 @@
+#include "AppOptions.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <stdexcept>
+
+namespace scop
+{
+	namespace
+	{
+
+		std::string requireValue(int argc, char **argv, int &i)
+		{
+			const std::string flag = argv[i];
+			if (i + 1 >= argc)
+			{
+				throw std::runtime_error("Missing value for " + flag);
+			}
+			++i;
+			return argv[i];
+		}
+
+		VkPresentModeKHR parsePresentMode(const std::string &value)
+		{
+			if (value == "immediate")
+				return VK_PRESENT_MODE_IMMEDIATE_KHR;
+			if (value == "mailbox")
+				return VK_PRESENT_MODE_MAILBOX_KHR;
+			if (value == "fifo")
+				return VK_PRESENT_MODE_FIFO_KHR;
+			if (value == "fifo-relaxed")
+				return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+			throw std::runtime_error("Unknown present mode: " + value + " (expected immediate, mailbox, fifo or fifo-relaxed)");
+		}
+
+		CullMode parseCullMode(const std::string &value)
+		{
+			if (value == "gpu")
+				return CullMode::Gpu;
+			if (value == "cpu")
+				return CullMode::Cpu;
+			if (value == "off")
+				return CullMode::Off;
+			throw std::runtime_error("Unknown culling mode: " + value + " (expected gpu, cpu or off)");
+		}
+
+		ShadingMode parseShadingMode(const std::string &value)
+		{
+			if (value == "auto")
+				return ShadingMode::Auto;
+			if (value == "plain")
+				return ShadingMode::Plain;
+			if (value == "material")
+				return ShadingMode::Material;
+			if (value == "textured")
+				return ShadingMode::Textured;
+			throw std::runtime_error("Unknown shading mode: " + value + " (expected auto, plain, material or textured)");
+		}
+
+		ResidencyPolicy parseResidencyPolicy(const std::string &value)
+		{
+			if (value == "release")
+				return ResidencyPolicy::Release;
+			if (value == "keep")
+				return ResidencyPolicy::Keep;
+			throw std::runtime_error("Unknown residency policy: " + value + " (expected release or keep)");
+		}
+
+		RenderBackend parseRenderBackend(const std::string &value)
+		{
+			if (value == "vulkan")
+				return RenderBackend::Vulkan;
+			if (value == "software")
+				return RenderBackend::Software;
+			throw std::runtime_error("Unknown backend: " + value + " (expected vulkan or software)");
+		}
+
+		bool hasObjExtension(const std::string &path)
+		{
+			if (path.size() < 4U)
+				return false;
+			std::string extension = path.substr(path.size() - 4U);
+			std::transform(extension.begin(), extension.end(), extension.begin(),
+						   [](unsigned char c)
+						   { return static_cast<char>(std::tolower(c)); });
+			return extension == ".obj";
+		}
+
+		long parseInteger(const std::string &flag, const std::string &value, long minValue, long maxValue)
+		{
+			std::size_t used = 0;
+			long parsed = 0;
+			try
+			{
+				parsed = std::stol(value, &used);
+			}
+			catch (const std::exception &)
+			{
+				used = 0;
+			}
+			if (used != value.size() || value.empty() || parsed < minValue || parsed > maxValue)
+			{
+				throw std::runtime_error("Invalid value for " + flag + ": " + value + " (expected " +
+										 std::to_string(minValue) + ".." + std::to_string(maxValue) + ")");
+			}
+			return parsed;
+		}
+
+	} // namespace
+
+	AppOptions::AppOptions()
+		: backend(RenderBackend::Vulkan),
+		  rasterThreads(0U),
+		  framesInFlight(2U),
+		  targetFps(0.0),
+		  lateLatch(false),
+		  idle(true),
+		  hostBudgetMiB(0U),
+		  gpuBudgetMiB(0U),
+		  residency(ResidencyPolicy::Release),
+		  headlessFrames(0U),
+		  width(0U),
+		  height(0U),
+		  instances(1U),
+		  culling(CullMode::Auto),
+		  recordThreads(0U),
+		  shading(ShadingMode::Auto),
+		  bench(false),
+		  benchFrames(600U),
+		  benchWarmup(60U),
+		  benchThreshold(10.0) {}
+
+	AppOptions AppOptions::parse(int argc, char **argv)
+	{
+		AppOptions options;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--backend")
+			{
+				options.backend = parseRenderBackend(requireValue(argc, argv, i));
+			}
+			else if (arg == "--raster-threads")
+			{
+				options.rasterThreads = static_cast<std::size_t>(parseInteger(arg, requireValue(argc, argv, i), 0, 64));
+			}
+			else if (arg == "--present-mode")
+			{
+				options.presentMode = parsePresentMode(requireValue(argc, argv, i));
+			}
+			else if (arg == "--frames-in-flight")
+			{
+				options.framesInFlight = static_cast<std::size_t>(parseInteger(arg, requireValue(argc, argv, i), 1, 4));
+			}
+			else if (arg == "--fps")
+			{
+				options.targetFps = static_cast<double>(parseInteger(arg, requireValue(argc, argv, i), 0, 1000));
+			}
+			else if (arg == "--late-latch")
+			{
+				options.lateLatch = true;
+			}
+			else if (arg == "--no-idle")
+			{
+				options.idle = false;
+			}
+			else if (arg == "--gpu-csv")
+			{
+				options.gpuCsvPath = requireValue(argc, argv, i);
+			}
+			else if (arg == "--trace")
+			{
+				options.tracePath = requireValue(argc, argv, i);
+			}
+			else if (arg == "--host-budget")
+			{
+				options.hostBudgetMiB = static_cast<std::size_t>(parseInteger(arg, requireValue(argc, argv, i), 0, 1048576));
+			}
+			else if (arg == "--gpu-budget")
+			{
+				options.gpuBudgetMiB = static_cast<std::size_t>(parseInteger(arg, requireValue(argc, argv, i), 0, 1048576));
+			}
+			else if (arg == "--residency")
+			{
+				options.residency = parseResidencyPolicy(requireValue(argc, argv, i));
+			}
+			else if (arg == "--headless")
+			{
+				options.headlessFrames = static_cast<std::size_t>(parseInteger(arg, requireValue(argc, argv, i), 1, 1000000));
+			}
+			else if (arg == "--size")
+			{
+				const std::string value = requireValue(argc, argv, i);
+				const std::size_t x = value.find('x');
+				if (x == std::string::npos)
+				{
+					throw std::runtime_error("Invalid value for --size: " + value + " (expected WIDTHxHEIGHT)");
+				}
+				options.width = static_cast<uint32_t>(parseInteger(arg, value.substr(0, x), 16, 16384));
+				options.height = static_cast<uint32_t>(parseInteger(arg, value.substr(x + 1U), 16, 16384));
+			}
+			else if (arg == "--dump-frames")
+			{
+				options.dumpFramesDir = requireValue(argc, argv, i);
+			}
+			else if (arg == "--scene")
+			{
+				options.scenePath = requireValue(argc, argv, i);
+			}
+			else if (arg == "--instances")
+			{
+				options.instances = static_cast<std::size_t>(parseInteger(arg, requireValue(argc, argv, i), 1, 1000000));
+			}
+			else if (arg == "--culling")
+			{
+				options.culling = parseCullMode(requireValue(argc, argv, i));
+			}
+			else if (arg == "--record-threads")
+			{
+				options.recordThreads = static_cast<std::size_t>(parseInteger(arg, requireValue(argc, argv, i), 0, 64));
+			}
+			else if (arg == "--shading")
+			{
+				options.shading = parseShadingMode(requireValue(argc, argv, i));
+			}
+			else if (arg == "--bench")
+			{
+				options.bench = true;
+			}
+			else if (arg == "--bench-frames")
+			{
+				options.benchFrames = static_cast<std::size_t>(parseInteger(arg, requireValue(argc, argv, i), 1, 1000000));
+			}
+			else if (arg == "--bench-warmup")
+			{
+				options.benchWarmup = static_cast<std::size_t>(parseInteger(arg, requireValue(argc, argv, i), 0, 1000000));
+			}
+			else if (arg == "--bench-json")
+			{
+				options.benchJsonPath = requireValue(argc, argv, i);
+			}
+			else if (arg == "--bench-baseline")
+			{
+				options.benchBaselinePath = requireValue(argc, argv, i);
+			}
+			else if (arg == "--bench-threshold")
+			{
+				options.benchThreshold = static_cast<double>(parseInteger(arg, requireValue(argc, argv, i), 0, 1000));
+			}
+			else if (arg.size() > 1 && arg[0] == '-')
+			{
+				throw std::runtime_error("Unknown option: " + arg);
+			}
+			else if ((options.modelPaths.empty() && options.scenePath.empty()) || hasObjExtension(arg))
+			{
+				options.modelPaths.push_back(arg);
+			}
+			else if (options.texturePath.empty())
+			{
+				options.texturePath = arg;
+			}
+			else
+			{
+				throw std::runtime_error("Unexpected argument: " + arg);
+			}
+		}
+		if (!options.scenePath.empty())
+		{
+			// A texture given before --scene was taken for the first model.
+			if (options.texturePath.empty() && options.modelPaths.size() == 1U && !hasObjExtension(options.modelPaths.front()))
+			{
+				options.texturePath = options.modelPaths.front();
+				options.modelPaths.clear();
+			}
+			if (!options.modelPaths.empty())
+			{
+				throw std::runtime_error("--scene cannot be combined with model arguments");
+			}
+			if (options.instances > 1U)
+			{
+				throw std::runtime_error("--scene cannot be combined with --instances");
+			}
+		}
+		else if (options.modelPaths.empty())
+		{
+			options.modelPaths.push_back("assets/demo_cube.obj");
+		}
+		if (!options.dumpFramesDir.empty() && options.headlessFrames == 0U)
+		{
+			throw std::runtime_error("--dump-frames requires --headless");
+		}
+		if (options.backend == RenderBackend::Software)
+		{
+			// The software backend draws the positional models once each.
+			if (!options.scenePath.empty())
+			{
+				throw std::runtime_error("--backend software cannot be combined with --scene");
+			}
+			if (options.instances > 1U)
+			{
+				throw std::runtime_error("--backend software cannot be combined with --instances");
+			}
+			if (options.bench)
+			{
+				throw std::runtime_error("--backend software cannot be combined with --bench");
+			}
+		}
+		if (options.bench && options.headlessFrames > 0U)
+		{
+			options.headlessFrames = options.benchWarmup + options.benchFrames;
+		}
+		return options;
+	}
+
+	void AppOptions::printUsage(const char *program)
+	{
+		std::cerr << "Usage: " << program << " [model.obj ...] [texture.ppm] [options]\n"
+				  << "  --backend NAME          renderer: vulkan or software (CPU, no Vulkan driver needed; default vulkan)\n"
+				  << "  --raster-threads N      software backend threads rasterizing tiles (0 = all, default)\n"
+				  << "  --present-mode MODE     immediate, mailbox, fifo or fifo-relaxed\n"
+				  << "  --frames-in-flight N    frames the CPU may record ahead of the GPU (1-4, default 2)\n"
+				  << "  --fps N                 cap the frame rate (0 = uncapped, default)\n"
+				  << "  --late-latch            sample input right before the frame data is written\n"
+				  << "  --no-idle               keep redrawing while the scene is static\n"
+				  << "  --gpu-csv FILE          write per-frame GPU time and pipeline statistics as CSV\n"
+				  << "  --trace FILE            record CPU profiler zones and write them as Chrome trace JSON\n"
+				  << "  --host-budget MIB       fail when tagged host allocations exceed MIB (0 = no limit, default)\n"
+				  << "  --gpu-budget MIB        fail when device memory blocks exceed MIB (0 = no limit, default)\n"
+				  << "  --residency POLICY      CPU mesh and texture copies after upload: release or keep (default release)\n"
+				  << "  --headless N            render N frames offscreen (no window or swapchain) and exit\n"
+				  << "  --size WxH              window or offscreen size (default 1920x1080)\n"
+				  << "  --dump-frames DIR       with --headless, write every frame to DIR as PPM\n"
+				  << "  --scene FILE            place models from a scene file instead of the model arguments\n"
+				  << "  --instances N           draw N copies of the model with one instanced call (default 1)\n"
+				  << "  --culling MODE          frustum culling: gpu, cpu or off (default gpu when supported)\n"
+				  << "  --record-threads N      threads recording secondary command buffers (0 = all, 1 = inline)\n"
+				  << "  --shading MODE          fragment shader variant: auto, plain, material or textured (default auto)\n"
+				  << "  --bench                 replay a fixed pose script and report frame timings as JSON\n"
+				  << "  --bench-frames N        measured frames (default 600)\n"
+				  << "  --bench-warmup N        unmeasured warm-up frames (default 60)\n"
+				  << "  --bench-json FILE       write the report to FILE instead of stdout\n"
+				  << "  --bench-baseline FILE   fail when the run regresses against a previous report\n"
+				  << "  --bench-threshold PCT   allowed regression in percent (default 10)\n";
+	}
+
+	const char *presentModeName(VkPresentModeKHR mode)
+	{
+		switch (mode)
+		{
+		case VK_PRESENT_MODE_IMMEDIATE_KHR:
+			return "immediate";
+		case VK_PRESENT_MODE_MAILBOX_KHR:
+			return "mailbox";
+		case VK_PRESENT_MODE_FIFO_KHR:
+			return "fifo";
+		case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+			return "fifo-relaxed";
+		default:
+			return "other";
+		}
+	}
+
+	const char *cullModeName(CullMode mode)
+	{
+		switch (mode)
+		{
+		case CullMode::Gpu:
+			return "gpu";
+		case CullMode::Cpu:
+			return "cpu";
+		case CullMode::Off:
+			return "off";
+		default:
+			return "auto";
+		}
+	}
+
+	const char *shadingModeName(ShadingMode mode)
+	{
+		switch (mode)
+		{
+		case ShadingMode::Plain:
+			return "plain";
+		case ShadingMode::Material:
+			return "material";
+		case ShadingMode::Textured:
+			return "textured";
+		default:
+			return "auto";
+		}
+	}
+
+	const char *residencyPolicyName(ResidencyPolicy policy)
+	{
+		switch (policy)
+		{
+		case ResidencyPolicy::Keep:
+			return "keep";
+		default:
+			return "release";
+		}
+	}
+
+	const char *renderBackendName(RenderBackend backend)
+	{
+		switch (backend)
+		{
+		case RenderBackend::Software:
+			return "software";
+		default:
+			return "vulkan";
+		}
+	}
+
+} // namespace scop
@@ -0,0 +1,231 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+namespace scop
+{
+	namespace
+	{
+
+		double mean(const std::vector<double> &samples)
+		{
+			if (samples.empty())
+			{
+				return 0.0;
+			}
+			return std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+		}
+
+		double percentile(std::vector<double> samples, double fraction)
+		{
+			if (samples.empty())
+			{
+				return 0.0;
+			}
+			const std::size_t index = std::min(samples.size() - 1U,
+											   static_cast<std::size_t>(fraction * static_cast<double>(samples.size())));
+			std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+			return samples[index];
+		}
+
+		std::string escapeJson(const std::string &text)
+		{
+			std::string escaped;
+			for (const char c : text)
+			{
+				if (c == '"' || c == '\\')
+				{
+					escaped.push_back('\\');
+				}
+				escaped.push_back(c);
+			}
+			return escaped;
+		}
+
+		// The report is a flat object, so a key lookup is enough to read a
+		// baseline back without a JSON library.
+		std::optional<double> findNumber(const std::string &json, const std::string &key)
+		{
+			const std::string quoted = "\"" + key + "\"";
+			std::size_t pos = json.find(quoted);
+			if (pos == std::string::npos)
+			{
+				return std::nullopt;
+			}
+			pos = json.find(':', pos + quoted.size());
+			if (pos == std::string::npos)
+			{
+				return std::nullopt;
+			}
+			const char *begin = json.c_str() + pos + 1U;
+			char *end = nullptr;
+			const double value = std::strtod(begin, &end);
+			if (end == begin)
+			{
+				return std::nullopt;
+			}
+			return value;
+		}
+
+	} // namespace
+
+	Benchmark::Benchmark(std::size_t warmupFrames, std::size_t measuredFrames)
+		: warmupFrames_(warmupFrames),
+		  measuredFrames_(measuredFrames),
+		  frameIndex_(0U),
+		  lastFrame_(Clock::now())
+	{
+		frameMs_.reserve(measuredFrames_);
+		cpuMs_.reserve(measuredFrames_);
+		fenceWaitMs_.reserve(measuredFrames_);
+		gpuMs_.reserve(measuredFrames_);
+	}
+
+	BenchmarkPose Benchmark::pose(std::size_t frame)
+	{
+		// One full turn every ~7.4 s while the model drifts on a slow
+		// Lissajous path and dollies toward and away from the camera.
+		const float t = static_cast<float>(frame) * kFixedDt;
+		BenchmarkPose result;
+		result.rotation = 0.85f * t;
+		result.translation = Vec3(0.35f * std::sin(0.7f * t), 0.20f * std::sin(1.3f * t), -0.6f + 0.6f * std::cos(0.5f * t));
+		return result;
+	}
+
+	void Benchmark::addFrame(double cpuMs, double fenceWaitMs)
+	{
+		const Clock::time_point now = Clock::now();
+		if (measuring() && !done())
+		{
+			if (frameMs_.empty())
+			{
+				measureBegin_ = lastFrame_;
+			}
+			frameMs_.push_back(std::chrono::duration<double, std::milli>(now - lastFrame_).count());
+			cpuMs_.push_back(cpuMs);
+			fenceWaitMs_.push_back(fenceWaitMs);
+			measureEnd_ = now;
+		}
+		lastFrame_ = now;
+		++frameIndex_;
+	}
+
+	void Benchmark::addGpuSample(double gpuMs)
+	{
+		if (measuring() && gpuMs_.size() < measuredFrames_)
+		{
+			gpuMs_.push_back(gpuMs);
+		}
+	}
+
+	BenchmarkResult Benchmark::result() const
+	{
+		BenchmarkResult result{};
+		result.frames = frameMs_.size();
+		result.seconds = frameMs_.empty() ? 0.0 : std::chrono::duration<double>(measureEnd_ - measureBegin_).count();
+		result.fps = result.seconds > 0.0 ? static_cast<double>(result.frames) / result.seconds : 0.0;
+		result.frameMeanMs = mean(frameMs_);
+		result.frameP50Ms = percentile(frameMs_, 0.50);
+		result.frameP99Ms = percentile(frameMs_, 0.99);
+		result.frameMaxMs = frameMs_.empty() ? 0.0 : *std::max_element(frameMs_.begin(), frameMs_.end());
+		result.cpuMeanMs = mean(cpuMs_);
+		result.cpuP99Ms = percentile(cpuMs_, 0.99);
+		result.fenceWaitMeanMs = mean(fenceWaitMs_);
+		result.fenceWaitP99Ms = percentile(fenceWaitMs_, 0.99);
+		result.gpuSamples = gpuMs_.size();
+		result.gpuMeanMs = mean(gpuMs_);
+		result.gpuP50Ms = percentile(gpuMs_, 0.50);
+		result.gpuP99Ms = percentile(gpuMs_, 0.99);
+		return result;
+	}
+
+	void Benchmark::writeJson(std::ostream &out, const BenchmarkResult &result,
+							  const std::vector<std::pair<std::string, std::string>> &info)
+	{
+		out << "{\n";
+		for (const std::pair<std::string, std::string> &entry : info)
+		{
+			out << "  \"" << escapeJson(entry.first) << "\": \"" << escapeJson(entry.second) << "\",\n";
+		}
+		out << std::fixed << std::setprecision(4)
+			<< "  \"frames\": " << result.frames << ",\n"
+			<< "  \"seconds\": " << result.seconds << ",\n"
+			<< "  \"fps\": " << result.fps << ",\n"
+			<< "  \"frame_ms_mean\": " << result.frameMeanMs << ",\n"
+			<< "  \"frame_ms_p50\": " << result.frameP50Ms << ",\n"
+			<< "  \"frame_ms_p99\": " << result.frameP99Ms << ",\n"
+			<< "  \"frame_ms_max\": " << result.frameMaxMs << ",\n"
+			<< "  \"cpu_ms_mean\": " << result.cpuMeanMs << ",\n"
+			<< "  \"cpu_ms_p99\": " << result.cpuP99Ms << ",\n"
+			<< "  \"fence_wait_ms_mean\": " << result.fenceWaitMeanMs << ",\n"
+			<< "  \"fence_wait_ms_p99\": " << result.fenceWaitP99Ms << ",\n"
+			<< "  \"gpu_samples\": " << result.gpuSamples << ",\n"
+			<< "  \"gpu_ms_mean\": " << result.gpuMeanMs << ",\n"
+			<< "  \"gpu_ms_p50\": " << result.gpuP50Ms << ",\n"
+			<< "  \"gpu_ms_p99\": " << result.gpuP99Ms << "\n"
+			<< "}\n";
+		out << std::defaultfloat;
+	}
+
+	std::vector<std::string> Benchmark::compareWithBaseline(const BenchmarkResult &result, const std::string &baselinePath,
+															double thresholdPercent)
+	{
+		std::ifstream file(baselinePath.c_str());
+		if (!file)
+		{
+			throw std::runtime_error("Failed to open benchmark baseline: " + baselinePath);
+		}
+		std::ostringstream contents;
+		contents << file.rdbuf();
+		const std::string json = contents.str();
+
+		struct Metric
+		{
+			const char *key;
+			double current;
+			bool higherIsBetter;
+		};
+		std::vector<Metric> metrics = {
+			{"fps", result.fps, true},
+			{"frame_ms_p50", result.frameP50Ms, false},
+			{"frame_ms_p99", result.frameP99Ms, false},
+			{"cpu_ms_mean", result.cpuMeanMs, false},
+		};
+		const std::optional<double> baselineGpuSamples = findNumber(json, "gpu_samples");
+		if (result.gpuSamples > 0U && baselineGpuSamples.value_or(0.0) > 0.0)
+		{
+			metrics.push_back({"gpu_ms_p50", result.gpuP50Ms, false});
+			metrics.push_back({"gpu_ms_p99", result.gpuP99Ms, false});
+		}
+
+		const double tolerance = thresholdPercent / 100.0;
+		std::vector<std::string> regressions;
+		for (const Metric &metric : metrics)
+		{
+			const std::optional<double> baseline = findNumber(json, metric.key);
+			if (!baseline.has_value() || baseline.value() <= 0.0)
+			{
+				continue;
+			}
+			const double change = (metric.current - baseline.value()) / baseline.value();
+			const bool regressed = metric.higherIsBetter ? (change < -tolerance) : (change > tolerance);
+			if (regressed)
+			{
+				std::ostringstream line;
+				line << std::fixed << std::setprecision(3) << metric.key << ": " << metric.current
+					 << " vs baseline " << baseline.value() << " (" << std::showpos << change * 100.0 << "%)";
+				regressions.push_back(line.str());
+			}
+		}
+		return regressions;
+	}
+
+} // namespace scop
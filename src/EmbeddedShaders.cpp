@@ -0,0 +1,38 @@
+#include "EmbeddedShaders.hpp"
+
+namespace scop
+{
+	namespace
+	{
+
+		// Generated from the .spv files by the Makefile (build/gen/*.spv.inc).
+		const uint32_t kMeshVertex[] = {
+#include "mesh.vert.spv.inc"
+		};
+
+		const uint32_t kMeshFragment[] = {
+#include "mesh.frag.spv.inc"
+		};
+
+		const uint32_t kCullCompute[] = {
+#include "cull.comp.spv.inc"
+		};
+
+	} // namespace
+
+	ShaderCode EmbeddedShaders::meshVertex()
+	{
+		return {kMeshVertex, sizeof(kMeshVertex)};
+	}
+
+	ShaderCode EmbeddedShaders::meshFragment()
+	{
+		return {kMeshFragment, sizeof(kMeshFragment)};
+	}
+
+	ShaderCode EmbeddedShaders::cullCompute()
+	{
+		return {kCullCompute, sizeof(kCullCompute)};
+	}
+
+} // namespace scop
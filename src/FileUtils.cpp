@@ -1,5 +1,6 @@
 #include "FileUtils.hpp"
 
+#include <cstdio>
 #include <fstream>
 #include <stdexcept>
 
@@ -29,4 +30,26 @@ namespace scop
 		return buffer;
 	}
 
+	void writeBinaryFile(const std::string &path, const void *data, std::size_t size)
+	{
+		const std::string tmpPath = path + ".tmp";
+		{
+			std::ofstream file(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				throw std::runtime_error("Failed to open file for writing: " + tmpPath);
+			}
+			file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+			if (!file)
+			{
+				throw std::runtime_error("Failed to write file: " + tmpPath);
+			}
+		}
+		if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+		{
+			std::remove(tmpPath.c_str());
+			throw std::runtime_error("Failed to replace file: " + path);
+		}
+	}
+
 } // namespace scop
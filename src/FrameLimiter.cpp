@@ -0,0 +1,57 @@
+#include "FrameLimiter.hpp"
+
+#include <thread>
+
+namespace scop
+{
+	namespace
+	{
+
+		constexpr std::chrono::microseconds kSpinMargin(1500);
+
+	} // namespace
+
+	FrameLimiter::FrameLimiter(double targetFps)
+		: enabled_(targetFps > 0.0),
+		  period_(enabled_ ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps))
+						   : Clock::duration::zero()),
+		  started_(false) {}
+
+	void FrameLimiter::wait()
+	{
+		if (!enabled_)
+		{
+			return;
+		}
+
+		Clock::time_point now = Clock::now();
+		if (!started_)
+		{
+			deadline_ = now + period_;
+			started_ = true;
+			return;
+		}
+
+		if (now < deadline_)
+		{
+			if (deadline_ - now > kSpinMargin)
+			{
+				std::this_thread::sleep_until(deadline_ - kSpinMargin);
+			}
+			while (Clock::now() < deadline_)
+			{
+			}
+			now = deadline_;
+		}
+
+		// Advance on a fixed grid so the cadence stays even; if a frame ran
+		// more than a whole period late, restart the grid instead of
+		// rushing several frames to catch up.
+		deadline_ += period_;
+		if (now > deadline_)
+		{
+			deadline_ = now + period_;
+		}
+	}
+
+} // namespace scop
@@ -0,0 +1,91 @@
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+namespace scop
+{
+
+	FrameStats::Accumulator::Accumulator()
+		: count(0U),
+		  mean(0.0),
+		  m2(0.0),
+		  minValue(std::numeric_limits<double>::max()),
+		  maxValue(0.0) {}
+
+	void FrameStats::Accumulator::add(double value)
+	{
+		++count;
+		const double delta = value - mean;
+		mean += delta / static_cast<double>(count);
+		m2 += delta * (value - mean);
+		minValue = std::min(minValue, value);
+		maxValue = std::max(maxValue, value);
+	}
+
+	double FrameStats::Accumulator::stddev() const
+	{
+		return (count > 1U) ? std::sqrt(m2 / static_cast<double>(count - 1U)) : 0.0;
+	}
+
+	FrameStats::FrameStats(double reportIntervalSeconds)
+		: reportIntervalMs_(reportIntervalSeconds * 1000.0),
+		  windowElapsedMs_(0.0) {}
+
+	void FrameStats::addFrame(double frameMs)
+	{
+		window_.add(frameMs);
+		total_.add(frameMs);
+		windowSamples_.push_back(frameMs);
+		windowElapsedMs_ += frameMs;
+	}
+
+	bool FrameStats::reportDue() const
+	{
+		return windowElapsedMs_ >= reportIntervalMs_ && window_.count > 0U;
+	}
+
+	double FrameStats::percentile(std::vector<double> &samples, double fraction)
+	{
+		if (samples.empty())
+		{
+			return 0.0;
+		}
+		const std::size_t index = std::min(samples.size() - 1U,
+										   static_cast<std::size_t>(fraction * static_cast<double>(samples.size())));
+		std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+		return samples[index];
+	}
+
+	void FrameStats::report(std::ostream &out)
+	{
+		const double p50 = percentile(windowSamples_, 0.50);
+		const double p99 = percentile(windowSamples_, 0.99);
+		const double fps = (window_.mean > 0.0) ? 1000.0 / window_.mean : 0.0;
+
+		out << std::fixed << std::setprecision(2)
+			<< "Frame time: mean " << window_.mean << " ms, stddev " << window_.stddev()
+			<< " ms, p50 " << p50 << " ms, p99 " << p99 << " ms, max " << window_.maxValue
+			<< " ms (" << std::setprecision(1) << fps << " fps, " << window_.count << " frames)"
+			<< std::defaultfloat << std::endl;
+
+		window_ = Accumulator();
+		windowSamples_.clear();
+		windowElapsedMs_ = 0.0;
+	}
+
+	void FrameStats::printSummary(std::ostream &out) const
+	{
+		if (total_.count == 0U)
+		{
+			return;
+		}
+		out << std::fixed << std::setprecision(2)
+			<< "Frame time over " << total_.count << " frames: mean " << total_.mean
+			<< " ms, stddev " << total_.stddev() << " ms, min " << total_.minValue
+			<< " ms, max " << total_.maxValue << " ms" << std::defaultfloat << std::endl;
+	}
+
+} // namespace scop
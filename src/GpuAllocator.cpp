@@ -0,0 +1,463 @@
+#include "GpuAllocator.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+namespace scop
+{
+	namespace
+	{
+
+		constexpr VkDeviceSize kMiB = 1024U * 1024U;
+		constexpr VkDeviceSize kMaxBlockSize = 64U * kMiB;
+		constexpr VkDeviceSize kMinBlockSize = 1U * kMiB;
+
+		VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+		{
+			return (value + alignment - 1U) & ~(alignment - 1U);
+		}
+
+		uint32_t orderFor(VkDeviceSize size, VkDeviceSize minNode)
+		{
+			uint32_t order = 0U;
+			VkDeviceSize nodeSize = minNode;
+			while (nodeSize < size)
+			{
+				nodeSize <<= 1U;
+				++order;
+			}
+			return order;
+		}
+
+		double toMiB(VkDeviceSize bytes)
+		{
+			return static_cast<double>(bytes) / static_cast<double>(kMiB);
+		}
+
+	} // namespace
+
+	GpuAllocator::GpuAllocator()
+		: physicalDevice_(VK_NULL_HANDLE),
+		  device_(VK_NULL_HANDLE),
+		  memoryProperties_{},
+		  bufferImageGranularity_(1U),
+		  memoryBudget_(false),
+		  budget_(0U) {}
+
+	GpuAllocator::~GpuAllocator()
+	{
+		shutdown();
+	}
+
+	void GpuAllocator::init(VkPhysicalDevice physicalDevice, VkDevice device, bool memoryBudget)
+	{
+		physicalDevice_ = physicalDevice;
+		device_ = device;
+		memoryBudget_ = memoryBudget;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties_);
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		bufferImageGranularity_ = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1U);
+
+		heapUsed_.assign(memoryProperties_.memoryHeapCount, 0U);
+		heapPeakUsed_.assign(memoryProperties_.memoryHeapCount, 0U);
+		heapReserved_.assign(memoryProperties_.memoryHeapCount, 0U);
+		heapPeakReserved_.assign(memoryProperties_.memoryHeapCount, 0U);
+	}
+
+	void GpuAllocator::setBudget(VkDeviceSize bytes)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		budget_ = bytes;
+	}
+
+	void GpuAllocator::shutdown()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (device_ == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		for (std::unique_ptr<Block> &block : blocks_)
+		{
+			destroyBlock(block.get());
+		}
+		blocks_.clear();
+		device_ = VK_NULL_HANDLE;
+	}
+
+	uint32_t GpuAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0U; i < memoryProperties_.memoryTypeCount; ++i)
+		{
+			if ((typeFilter & (1U << i)) && (memoryProperties_.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return i;
+			}
+		}
+		throw std::runtime_error("Failed to find suitable memory type");
+	}
+
+	VkDeviceSize GpuAllocator::blockSizeForType(uint32_t memoryTypeIndex) const
+	{
+		const uint32_t heapIndex = memoryProperties_.memoryTypes[memoryTypeIndex].heapIndex;
+		const VkDeviceSize heapSize = memoryProperties_.memoryHeaps[heapIndex].size;
+
+		VkDeviceSize size = kMaxBlockSize;
+		while (size > kMinBlockSize && size > heapSize / 8U)
+		{
+			size >>= 1U;
+		}
+		return size;
+	}
+
+	GpuAllocator::Block *GpuAllocator::createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, GpuMemoryPool pool,
+												   GpuResourceKind kind, bool dedicated)
+	{
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		const uint32_t heapIndex = memoryProperties_.memoryTypes[memoryTypeIndex].heapIndex;
+		if (budget_ != 0U)
+		{
+			VkDeviceSize reserved = 0U;
+			for (VkDeviceSize heapBytes : heapReserved_)
+			{
+				reserved += heapBytes;
+			}
+			if (reserved + size > budget_)
+			{
+				throw std::runtime_error("GPU memory budget of " + std::to_string(budget_) + " bytes exceeded: block of " +
+										 std::to_string(size) + " bytes with " + std::to_string(reserved) + " reserved");
+			}
+		}
+
+		std::unique_ptr<Block> block(new Block());
+		if (vkAllocateMemory(device_, &allocInfo, nullptr, &block->memory) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate device memory block of " + std::to_string(size) + " bytes");
+		}
+
+		block->size = size;
+		block->mapped = nullptr;
+		block->memoryTypeIndex = memoryTypeIndex;
+		block->pool = pool;
+		block->kind = kind;
+		block->dedicated = dedicated;
+		block->liveCount = 0U;
+		block->usedBytes = 0U;
+		block->linearHead = 0U;
+		block->maxOrder = 0U;
+
+		if (memoryProperties_.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			if (vkMapMemory(device_, block->memory, 0U, VK_WHOLE_SIZE, 0U, &block->mapped) != VK_SUCCESS)
+			{
+				vkFreeMemory(device_, block->memory, nullptr);
+				throw std::runtime_error("Failed to map device memory block");
+			}
+		}
+
+		if (pool == GpuMemoryPool::Static && !dedicated)
+		{
+			block->maxOrder = orderFor(size, MIN_BUDDY_NODE);
+			block->freeLists.resize(block->maxOrder + 1U);
+			block->freeLists[block->maxOrder].insert(0U);
+		}
+
+		// Counted only once the block is fully set up, so a failed map
+		// leaves the budget as it was.
+		heapReserved_[heapIndex] += size;
+		heapPeakReserved_[heapIndex] = std::max(heapPeakReserved_[heapIndex], heapReserved_[heapIndex]);
+		blocks_.push_back(std::move(block));
+		return blocks_.back().get();
+	}
+
+	void GpuAllocator::destroyBlock(Block *block)
+	{
+		if (block->mapped != nullptr)
+		{
+			vkUnmapMemory(device_, block->memory);
+			block->mapped = nullptr;
+		}
+		vkFreeMemory(device_, block->memory, nullptr);
+		block->memory = VK_NULL_HANDLE;
+		heapReserved_[memoryProperties_.memoryTypes[block->memoryTypeIndex].heapIndex] -= block->size;
+	}
+
+	bool GpuAllocator::allocateLinear(Block &block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset)
+	{
+		const VkDeviceSize start = alignUp(block.linearHead, alignment);
+		if (start + size > block.size)
+		{
+			return false;
+		}
+		offset = start;
+		block.linearHead = start + size;
+		return true;
+	}
+
+	bool GpuAllocator::allocateBuddy(Block &block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset)
+	{
+		const uint32_t order = orderFor(std::max(std::max(size, alignment), MIN_BUDDY_NODE), MIN_BUDDY_NODE);
+		if (order > block.maxOrder)
+		{
+			return false;
+		}
+
+		uint32_t current = order;
+		while (current <= block.maxOrder && block.freeLists[current].empty())
+		{
+			++current;
+		}
+		if (current > block.maxOrder)
+		{
+			return false;
+		}
+
+		const VkDeviceSize node = *block.freeLists[current].begin();
+		block.freeLists[current].erase(block.freeLists[current].begin());
+		while (current > order)
+		{
+			--current;
+			block.freeLists[current].insert(node + (MIN_BUDDY_NODE << current));
+		}
+
+		block.allocatedOrders[node] = order;
+		offset = node;
+		return true;
+	}
+
+	void GpuAllocator::freeBuddy(Block &block, VkDeviceSize offset)
+	{
+		const auto found = block.allocatedOrders.find(offset);
+		if (found == block.allocatedOrders.end())
+		{
+			throw std::runtime_error("GpuAllocator: freeing an offset that was never allocated");
+		}
+
+		uint32_t order = found->second;
+		block.allocatedOrders.erase(found);
+
+		VkDeviceSize node = offset;
+		while (order < block.maxOrder)
+		{
+			const VkDeviceSize buddy = node ^ (MIN_BUDDY_NODE << order);
+			const auto buddyIt = block.freeLists[order].find(buddy);
+			if (buddyIt == block.freeLists[order].end())
+			{
+				break;
+			}
+			block.freeLists[order].erase(buddyIt);
+			node = std::min(node, buddy);
+			++order;
+		}
+		block.freeLists[order].insert(node);
+	}
+
+	GpuAllocation GpuAllocator::allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties,
+										 GpuMemoryPool pool, GpuResourceKind kind)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		const uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+		const VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1U);
+		const VkDeviceSize blockSize = blockSizeForType(memoryTypeIndex);
+		if (bufferImageGranularity_ <= 1U)
+		{
+			kind = GpuResourceKind::Linear;
+		}
+
+		Block *target = nullptr;
+		VkDeviceSize offset = 0U;
+
+		if (requirements.size > blockSize / 2U)
+		{
+			target = createBlock(memoryTypeIndex, requirements.size, pool, kind, true);
+		}
+		else
+		{
+			for (std::unique_ptr<Block> &block : blocks_)
+			{
+				if (block->dedicated || block->memoryTypeIndex != memoryTypeIndex || block->pool != pool || block->kind != kind)
+				{
+					continue;
+				}
+				const bool fits = (pool == GpuMemoryPool::Staging)
+									  ? allocateLinear(*block, requirements.size, alignment, offset)
+									  : allocateBuddy(*block, requirements.size, alignment, offset);
+				if (fits)
+				{
+					target = block.get();
+					break;
+				}
+			}
+
+			if (target == nullptr)
+			{
+				target = createBlock(memoryTypeIndex, blockSize, pool, kind, false);
+				const bool fits = (pool == GpuMemoryPool::Staging)
+									  ? allocateLinear(*target, requirements.size, alignment, offset)
+									  : allocateBuddy(*target, requirements.size, alignment, offset);
+				if (!fits)
+				{
+					throw std::runtime_error("GpuAllocator: allocation does not fit in a fresh block");
+				}
+			}
+		}
+
+		++target->liveCount;
+		target->usedBytes += requirements.size;
+
+		const uint32_t heapIndex = memoryProperties_.memoryTypes[memoryTypeIndex].heapIndex;
+		heapUsed_[heapIndex] += requirements.size;
+		heapPeakUsed_[heapIndex] = std::max(heapPeakUsed_[heapIndex], heapUsed_[heapIndex]);
+
+		GpuAllocation allocation;
+		allocation.memory = target->memory;
+		allocation.offset = offset;
+		allocation.size = requirements.size;
+		allocation.mapped = (target->mapped != nullptr) ? static_cast<char *>(target->mapped) + offset : nullptr;
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		allocation.block = target;
+		return allocation;
+	}
+
+	void GpuAllocator::free(GpuAllocation &allocation)
+	{
+		if (!allocation.valid())
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		Block *block = static_cast<Block *>(allocation.block);
+
+		if (block->pool == GpuMemoryPool::Static && !block->dedicated)
+		{
+			freeBuddy(*block, allocation.offset);
+		}
+		--block->liveCount;
+		block->usedBytes -= allocation.size;
+		if (block->liveCount == 0U)
+		{
+			block->linearHead = 0U;
+		}
+
+		const uint32_t heapIndex = memoryProperties_.memoryTypes[allocation.memoryTypeIndex].heapIndex;
+		heapUsed_[heapIndex] -= allocation.size;
+		allocation = GpuAllocation();
+
+		if (block->liveCount != 0U)
+		{
+			return;
+		}
+
+		// Keep one empty page per pool around for reuse, release the rest.
+		bool release = block->dedicated;
+		if (!release)
+		{
+			for (const std::unique_ptr<Block> &other : blocks_)
+			{
+				if (other.get() != block && !other->dedicated && other->liveCount == 0U &&
+					other->memoryTypeIndex == block->memoryTypeIndex && other->pool == block->pool && other->kind == block->kind)
+				{
+					release = true;
+					break;
+				}
+			}
+		}
+
+		if (release)
+		{
+			destroyBlock(block);
+			blocks_.erase(std::remove_if(blocks_.begin(), blocks_.end(),
+										 [block](const std::unique_ptr<Block> &candidate)
+										 { return candidate.get() == block; }),
+						  blocks_.end());
+		}
+	}
+
+	std::vector<GpuHeapStats> GpuAllocator::heapStats() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		if (memoryBudget_)
+		{
+			VkPhysicalDeviceMemoryProperties2 properties{};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			properties.pNext = &budget;
+			vkGetPhysicalDeviceMemoryProperties2(physicalDevice_, &properties);
+		}
+
+		std::vector<GpuHeapStats> stats(memoryProperties_.memoryHeapCount);
+		for (uint32_t i = 0U; i < memoryProperties_.memoryHeapCount; ++i)
+		{
+			stats[i].heapSize = memoryProperties_.memoryHeaps[i].size;
+			stats[i].reservedBytes = 0U;
+			stats[i].peakReservedBytes = heapPeakReserved_[i];
+			stats[i].usedBytes = heapUsed_[i];
+			stats[i].peakUsedBytes = heapPeakUsed_[i];
+			stats[i].budgetBytes = budget.heapBudget[i];
+			stats[i].driverUsageBytes = budget.heapUsage[i];
+			stats[i].blockCount = 0U;
+			stats[i].allocationCount = 0U;
+			stats[i].deviceLocal = (memoryProperties_.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0U;
+		}
+
+		for (const std::unique_ptr<Block> &block : blocks_)
+		{
+			GpuHeapStats &heap = stats[memoryProperties_.memoryTypes[block->memoryTypeIndex].heapIndex];
+			heap.reservedBytes += block->size;
+			heap.blockCount += 1U;
+			heap.allocationCount += block->liveCount;
+		}
+		return stats;
+	}
+
+	uint32_t GpuAllocator::deviceMemoryObjectCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return static_cast<uint32_t>(blocks_.size());
+	}
+
+	void GpuAllocator::printStats(std::ostream &out) const
+	{
+		const std::vector<GpuHeapStats> stats = heapStats();
+
+		out << "GPU memory (" << deviceMemoryObjectCount() << " vkDeviceMemory objects):\n";
+		const std::ios::fmtflags flags = out.flags();
+		out << std::fixed << std::setprecision(2);
+		for (std::size_t i = 0; i < stats.size(); ++i)
+		{
+			const GpuHeapStats &heap = stats[i];
+			if (heap.blockCount == 0U && heap.peakUsedBytes == 0U)
+			{
+				continue;
+			}
+			out << "  heap " << i << (heap.deviceLocal ? " (device-local" : " (host")
+				<< ", " << toMiB(heap.heapSize) << " MiB): "
+				<< heap.allocationCount << " allocations in " << heap.blockCount << " blocks, used "
+				<< toMiB(heap.usedBytes) << " / reserved " << toMiB(heap.reservedBytes)
+				<< " MiB, peak " << toMiB(heap.peakUsedBytes) << " / " << toMiB(heap.peakReservedBytes) << " MiB";
+			if (memoryBudget_)
+			{
+				out << ", driver budget " << toMiB(heap.driverUsageBytes) << " / " << toMiB(heap.budgetBytes) << " MiB";
+			}
+			out << '\n';
+		}
+		if (budget_ != 0U)
+		{
+			out << "  budget " << toMiB(budget_) << " MiB\n";
+		}
+		out.flags(flags);
+	}
+
+} // namespace scop
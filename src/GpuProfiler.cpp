@@ -0,0 +1,260 @@
+#include "GpuProfiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace scop
+{
+	namespace
+	{
+
+		// Bit order of the statistics in the query result follows the flag
+		// bits, lowest first: vertex invocations, clipping primitives,
+		// fragment invocations.
+		constexpr VkQueryPipelineStatisticFlags kStatistics =
+			VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+		double percentileOf(std::vector<double> samples, double fraction)
+		{
+			if (samples.empty())
+			{
+				return 0.0;
+			}
+			const std::size_t index = std::min(samples.size() - 1U,
+											   static_cast<std::size_t>(fraction * static_cast<double>(samples.size())));
+			std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+			return samples[index];
+		}
+
+	} // namespace
+
+	GpuProfiler::GpuProfiler()
+		: device_(VK_NULL_HANDLE),
+		  timestampPool_(VK_NULL_HANDLE),
+		  statisticsPool_(VK_NULL_HANDLE),
+		  timestampPeriodNs_(1.0),
+		  timestampMask_(~0ULL),
+		  nextSample_(0U),
+		  latestMs_(0.0),
+		  frameIndex_(0U),
+		  lastStatistics_{0U, 0U, 0U} {}
+
+	GpuProfiler::~GpuProfiler()
+	{
+		shutdown();
+	}
+
+	void GpuProfiler::init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily,
+						   std::size_t frameSlots, bool pipelineStatistics, const std::string &csvPath)
+	{
+		device_ = device;
+
+		uint32_t queueFamilyCount = 0U;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		const uint32_t validBits = (queueFamily < queueFamilyCount) ? queueFamilies[queueFamily].timestampValidBits : 0U;
+		if (validBits == 0U || properties.limits.timestampPeriod <= 0.0f)
+		{
+			std::cout << "GPU timestamps are not supported on this queue, GPU profiling disabled" << std::endl;
+			return;
+		}
+		timestampPeriodNs_ = static_cast<double>(properties.limits.timestampPeriod);
+		timestampMask_ = (validBits >= 64U) ? ~0ULL : ((1ULL << validBits) - 1ULL);
+
+		VkQueryPoolCreateInfo timestampInfo{};
+		timestampInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		timestampInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		timestampInfo.queryCount = static_cast<uint32_t>(frameSlots * 2U);
+		if (vkCreateQueryPool(device_, &timestampInfo, nullptr, &timestampPool_) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create timestamp query pool");
+		}
+
+		if (pipelineStatistics)
+		{
+			VkQueryPoolCreateInfo statisticsInfo{};
+			statisticsInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			statisticsInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+			statisticsInfo.queryCount = static_cast<uint32_t>(frameSlots);
+			statisticsInfo.pipelineStatistics = kStatistics;
+			if (vkCreateQueryPool(device_, &statisticsInfo, nullptr, &statisticsPool_) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create pipeline statistics query pool");
+			}
+		}
+
+		slotRecorded_.assign(frameSlots, false);
+		slotStatistics_.assign(frameSlots, false);
+		samplesMs_.reserve(kWindow);
+
+		if (!csvPath.empty())
+		{
+			csv_.open(csvPath.c_str(), std::ios::trunc);
+			if (!csv_)
+			{
+				throw std::runtime_error("Failed to open GPU profile CSV: " + csvPath);
+			}
+			csv_ << "frame,gpu_ms,vertex_invocations,clipping_primitives,fragment_invocations\n";
+		}
+	}
+
+	void GpuProfiler::shutdown()
+	{
+		if (device_ == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		if (timestampPool_ != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(device_, timestampPool_, nullptr);
+			timestampPool_ = VK_NULL_HANDLE;
+		}
+		if (statisticsPool_ != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(device_, statisticsPool_, nullptr);
+			statisticsPool_ = VK_NULL_HANDLE;
+		}
+		if (csv_.is_open())
+		{
+			csv_.close();
+		}
+		device_ = VK_NULL_HANDLE;
+	}
+
+	VkQueryPipelineStatisticFlags GpuProfiler::pipelineStatisticFlags() const
+	{
+		return hasPipelineStatistics() ? kStatistics : 0U;
+	}
+
+	void GpuProfiler::begin(VkCommandBuffer commandBuffer, std::size_t slot, bool statistics)
+	{
+		if (!enabled())
+		{
+			return;
+		}
+		const uint32_t first = static_cast<uint32_t>(slot * 2U);
+		vkCmdResetQueryPool(commandBuffer, timestampPool_, first, 2U);
+		slotStatistics_[slot] = statistics && hasPipelineStatistics();
+		if (slotStatistics_[slot])
+		{
+			vkCmdResetQueryPool(commandBuffer, statisticsPool_, static_cast<uint32_t>(slot), 1U);
+			vkCmdBeginQuery(commandBuffer, statisticsPool_, static_cast<uint32_t>(slot), 0);
+		}
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool_, first);
+	}
+
+	void GpuProfiler::end(VkCommandBuffer commandBuffer, std::size_t slot)
+	{
+		if (!enabled())
+		{
+			return;
+		}
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool_, static_cast<uint32_t>(slot * 2U + 1U));
+		if (slotStatistics_[slot])
+		{
+			vkCmdEndQuery(commandBuffer, statisticsPool_, static_cast<uint32_t>(slot));
+		}
+		slotRecorded_[slot] = true;
+	}
+
+	bool GpuProfiler::collect(std::size_t slot)
+	{
+		if (!enabled() || !slotRecorded_[slot])
+		{
+			return false;
+		}
+		slotRecorded_[slot] = false;
+
+		uint64_t timestamps[2] = {0U, 0U};
+		if (vkGetQueryPoolResults(device_, timestampPool_, static_cast<uint32_t>(slot * 2U), 2U, sizeof(timestamps),
+								  timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+		{
+			return false;
+		}
+		const uint64_t ticks = (timestamps[1] - timestamps[0]) & timestampMask_;
+		const double gpuMs = static_cast<double>(ticks) * timestampPeriodNs_ / 1.0e6;
+		latestMs_ = gpuMs;
+
+		const bool statistics = slotStatistics_[slot];
+		if (statistics)
+		{
+			uint64_t statistics[StatisticCount] = {0U, 0U, 0U};
+			if (vkGetQueryPoolResults(device_, statisticsPool_, static_cast<uint32_t>(slot), 1U, sizeof(statistics),
+									  statistics, sizeof(statistics), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+			{
+				std::copy(statistics, statistics + StatisticCount, lastStatistics_);
+			}
+		}
+
+		if (samplesMs_.size() < kWindow)
+		{
+			samplesMs_.push_back(gpuMs);
+		}
+		else
+		{
+			samplesMs_[nextSample_] = gpuMs;
+		}
+		nextSample_ = (nextSample_ + 1U) % kWindow;
+
+		if (csv_.is_open())
+		{
+			csv_ << frameIndex_ << ',' << gpuMs;
+			for (std::size_t i = 0; i < StatisticCount; ++i)
+			{
+				csv_ << ',';
+				if (statistics)
+				{
+					csv_ << lastStatistics_[i];
+				}
+			}
+			csv_ << '\n';
+		}
+		++frameIndex_;
+		return true;
+	}
+
+	GpuProfiler::Percentiles GpuProfiler::percentiles() const
+	{
+		Percentiles result{};
+		result.p50 = percentileOf(samplesMs_, 0.50);
+		result.p95 = percentileOf(samplesMs_, 0.95);
+		result.p99 = percentileOf(samplesMs_, 0.99);
+		return result;
+	}
+
+	std::string GpuProfiler::titleSummary() const
+	{
+		const Percentiles p = percentiles();
+		std::ostringstream title;
+		title << std::fixed << std::setprecision(2)
+			  << "GPU " << p.p50 << " ms (p95 " << p.p95 << ", p99 " << p.p99 << ")";
+		return title.str();
+	}
+
+	void GpuProfiler::report(std::ostream &out) const
+	{
+		if (!hasSamples())
+		{
+			return;
+		}
+		out << "GPU render pass: " << titleSummary();
+		if (hasPipelineStatistics())
+		{
+			out << ", VS invocations " << lastStatistics_[VertexInvocations]
+				<< ", clipping primitives " << lastStatistics_[ClippingPrimitives]
+				<< ", FS invocations " << lastStatistics_[FragmentInvocations];
+		}
+		out << std::endl;
+	}
+
+} // namespace scop
@@ -0,0 +1,84 @@
+#include "IdleMonitor.hpp"
+
+#include <ctime>
+
+namespace scop
+{
+	namespace
+	{
+
+		double percent(double part, double whole)
+		{
+			return (whole > 0.0) ? 100.0 * part / whole : 0.0;
+		}
+
+	} // namespace
+
+	IdleMonitor::Period::Period()
+		: wallMs(0.0),
+		  cpuMs(0.0),
+		  gpuMs(0.0),
+		  iterations(0U) {}
+
+	IdleMonitor::IdleMonitor()
+		: lastCpuMs_(0.0),
+		  idle_(false),
+		  started_(false) {}
+
+	double IdleMonitor::cpuNowMs()
+	{
+		// Process CPU time, all threads included.
+		return static_cast<double>(std::clock()) * 1000.0 / static_cast<double>(CLOCKS_PER_SEC);
+	}
+
+	void IdleMonitor::sample(bool idle)
+	{
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		const double cpuMs = cpuNowMs();
+		if (started_)
+		{
+			const double wallMs = std::chrono::duration<double, std::milli>(now - lastWall_).count();
+			for (Period *period : {&window_[idle_], &total_[idle_]})
+			{
+				period->wallMs += wallMs;
+				period->cpuMs += cpuMs - lastCpuMs_;
+				++period->iterations;
+			}
+		}
+		lastWall_ = now;
+		lastCpuMs_ = cpuMs;
+		idle_ = idle;
+		started_ = true;
+	}
+
+	void IdleMonitor::addGpuMs(double ms)
+	{
+		window_[0].gpuMs += ms;
+		total_[0].gpuMs += ms;
+	}
+
+	void IdleMonitor::print(std::ostream &out, const Period (&periods)[2])
+	{
+		const Period &active = periods[0];
+		const Period &idle = periods[1];
+		out << percent(idle.wallMs, active.wallMs + idle.wallMs) << "% of the time idle ("
+			<< active.iterations << " frames, " << idle.iterations << " wake-ups); CPU "
+			<< percent(active.cpuMs, active.wallMs) << "% rendering / " << percent(idle.cpuMs, idle.wallMs)
+			<< "% idle, GPU " << percent(active.gpuMs, active.wallMs) << "% rendering" << std::endl;
+	}
+
+	void IdleMonitor::report(std::ostream &out)
+	{
+		out << "Idle: ";
+		print(out, window_);
+		window_[0] = Period();
+		window_[1] = Period();
+	}
+
+	void IdleMonitor::printSummary(std::ostream &out) const
+	{
+		out << "Idle summary: ";
+		print(out, total_);
+	}
+
+} // namespace scop
@@ -0,0 +1,113 @@
+#include "LatencyTracker.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+
+namespace scop
+{
+	namespace
+	{
+
+		// Input frames waiting on a present are capped so a driver that never
+		// reports completion cannot grow the queue forever.
+		constexpr std::size_t kMaxPendingPresents = 64U;
+
+		double elapsedMs(LatencyTracker::Clock::time_point from, LatencyTracker::Clock::time_point to)
+		{
+			return std::chrono::duration<double, std::milli>(to - from).count();
+		}
+
+	} // namespace
+
+	LatencyTracker::LatencyTracker() {}
+
+	void LatencyTracker::markInput(Clock::time_point when)
+	{
+		if (!pendingInput_.has_value())
+		{
+			pendingInput_ = when;
+		}
+	}
+
+	std::optional<LatencyTracker::Clock::time_point> LatencyTracker::consumeInput()
+	{
+		std::optional<Clock::time_point> input = pendingInput_;
+		pendingInput_.reset();
+		return input;
+	}
+
+	void LatencyTracker::frameSubmitted(std::optional<Clock::time_point> input, uint64_t presentId, Clock::time_point when)
+	{
+		if (!input.has_value())
+		{
+			return;
+		}
+		inputToSubmitMs_.push_back(elapsedMs(input.value(), when));
+		if (presentId != 0U)
+		{
+			if (pendingPresents_.size() >= kMaxPendingPresents)
+			{
+				pendingPresents_.pop_front();
+			}
+			pendingPresents_.push_back({presentId, input.value()});
+		}
+	}
+
+	uint64_t LatencyTracker::oldestPendingPresent() const
+	{
+		return pendingPresents_.empty() ? 0U : pendingPresents_.front().presentId;
+	}
+
+	void LatencyTracker::presentsCompleted(uint64_t presentId, Clock::time_point when)
+	{
+		while (!pendingPresents_.empty() && pendingPresents_.front().presentId <= presentId)
+		{
+			inputToPresentMs_.push_back(elapsedMs(pendingPresents_.front().input, when));
+			pendingPresents_.pop_front();
+		}
+	}
+
+	void LatencyTracker::dropPendingPresents()
+	{
+		pendingPresents_.clear();
+	}
+
+	void LatencyTracker::printSeries(std::ostream &out, const char *label, std::vector<double> &samples)
+	{
+		const double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+		std::sort(samples.begin(), samples.end());
+		const double p50 = samples[samples.size() / 2U];
+		const double p99 = samples[std::min(samples.size() - 1U, samples.size() * 99U / 100U)];
+		out << label << " mean " << mean << " ms, p50 " << p50 << " ms, p99 " << p99 << " ms (" << samples.size() << ")";
+	}
+
+	void LatencyTracker::report(std::ostream &out, bool presentTimingAvailable)
+	{
+		if (inputToSubmitMs_.empty())
+		{
+			return;
+		}
+
+		out << std::fixed << std::setprecision(2) << "Latency: ";
+		printSeries(out, "input->submit", inputToSubmitMs_);
+		out << "; ";
+		if (!presentTimingAvailable)
+		{
+			out << "input->present n/a (VK_KHR_present_wait unavailable)";
+		}
+		else if (inputToPresentMs_.empty())
+		{
+			out << "input->present pending";
+		}
+		else
+		{
+			printSeries(out, "input->present", inputToPresentMs_);
+		}
+		out << std::defaultfloat << std::endl;
+
+		inputToSubmitMs_.clear();
+		inputToPresentMs_.clear();
+	}
+
+} // namespace scop
@@ -0,0 +1,471 @@
+#include "MathBatch.hpp"
+
+#include <atomic>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCOP_BATCH_X86 1
+#endif
+
+namespace scop
+{
+
+	void Vec3Array::resize(std::size_t count)
+	{
+		x_.resize(count);
+		y_.resize(count);
+		z_.resize(count);
+	}
+
+	void Vec3Array::set(std::size_t index, const Vec3 &value)
+	{
+		x_[index] = value.x;
+		y_[index] = value.y;
+		z_[index] = value.z;
+	}
+
+	Vec3 Vec3Array::get(std::size_t index) const
+	{
+		return Vec3(x_[index], y_[index], z_[index]);
+	}
+
+	Vec3Streams Vec3Array::streams(std::size_t first)
+	{
+		return Vec3Streams{x_.data() + first, y_.data() + first, z_.data() + first};
+	}
+
+	ConstVec3Streams Vec3Array::streams(std::size_t first) const
+	{
+		return ConstVec3Streams{x_.data() + first, y_.data() + first, z_.data() + first};
+	}
+
+	namespace MathBatch
+	{
+		namespace
+		{
+
+			// Every kernel works on [begin, end); the vector versions hand
+			// the tail that does not fill a register to the scalar one.
+			struct Kernels
+			{
+				Isa isa;
+				void (*transformPoints)(const Mat4 &, ConstVec3Streams, Vec3Streams, std::size_t, std::size_t);
+				void (*transformAabbs)(const Mat4 &, ConstVec3Streams, ConstVec3Streams, Vec3Streams, Vec3Streams,
+									   std::size_t, std::size_t);
+				std::size_t (*spheresInFrustum)(const Frustum &, ConstVec3Streams, const float *, std::uint8_t *,
+												std::size_t, std::size_t);
+				void (*normalize)(Vec3Streams, std::size_t, std::size_t);
+			};
+
+			// The scalar kernels evaluate in the same order as Math.hpp, and
+			// the vector ones use the same operations lane by lane (no FMA),
+			// so every path gives bit-identical results.
+
+			void transformPointsScalar(const Mat4 &m, ConstVec3Streams in, Vec3Streams out, std::size_t begin, std::size_t end)
+			{
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					const float x = in.x[i];
+					const float y = in.y[i];
+					const float z = in.z[i];
+					out.x[i] = m(0, 0) * x + m(0, 1) * y + m(0, 2) * z + m(0, 3);
+					out.y[i] = m(1, 0) * x + m(1, 1) * y + m(1, 2) * z + m(1, 3);
+					out.z[i] = m(2, 0) * x + m(2, 1) * y + m(2, 2) * z + m(2, 3);
+				}
+			}
+
+			void transformAabbsScalar(const Mat4 &m, ConstVec3Streams centers, ConstVec3Streams extents,
+									  Vec3Streams outMin, Vec3Streams outMax, std::size_t begin, std::size_t end)
+			{
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					const float x = centers.x[i];
+					const float y = centers.y[i];
+					const float z = centers.z[i];
+					const float ex = extents.x[i];
+					const float ey = extents.y[i];
+					const float ez = extents.z[i];
+					const float cx = m(0, 0) * x + m(0, 1) * y + m(0, 2) * z + m(0, 3);
+					const float cy = m(1, 0) * x + m(1, 1) * y + m(1, 2) * z + m(1, 3);
+					const float cz = m(2, 0) * x + m(2, 1) * y + m(2, 2) * z + m(2, 3);
+					const float wx = std::fabs(m(0, 0)) * ex + std::fabs(m(0, 1)) * ey + std::fabs(m(0, 2)) * ez;
+					const float wy = std::fabs(m(1, 0)) * ex + std::fabs(m(1, 1)) * ey + std::fabs(m(1, 2)) * ez;
+					const float wz = std::fabs(m(2, 0)) * ex + std::fabs(m(2, 1)) * ey + std::fabs(m(2, 2)) * ez;
+					outMin.x[i] = cx - wx;
+					outMin.y[i] = cy - wy;
+					outMin.z[i] = cz - wz;
+					outMax.x[i] = cx + wx;
+					outMax.y[i] = cy + wy;
+					outMax.z[i] = cz + wz;
+				}
+			}
+
+			std::size_t spheresInFrustumScalar(const Frustum &frustum, ConstVec3Streams centers, const float *radii,
+											   std::uint8_t *inside, std::size_t begin, std::size_t end)
+			{
+				std::size_t count = 0U;
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					bool visible = true;
+					for (const Vec4 &plane : frustum)
+					{
+						if (plane.x * centers.x[i] + plane.y * centers.y[i] + plane.z * centers.z[i] + plane.w < -radii[i])
+						{
+							visible = false;
+							break;
+						}
+					}
+					inside[i] = visible ? 1U : 0U;
+					count += visible ? 1U : 0U;
+				}
+				return count;
+			}
+
+			void normalizeScalar(Vec3Streams v, std::size_t begin, std::size_t end)
+			{
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					const float len = std::sqrt(v.x[i] * v.x[i] + v.y[i] * v.y[i] + v.z[i] * v.z[i]);
+					if (len <= 1e-8f)
+					{
+						v.x[i] = 0.0f;
+						v.y[i] = 0.0f;
+						v.z[i] = 0.0f;
+						continue;
+					}
+					v.x[i] /= len;
+					v.y[i] /= len;
+					v.z[i] /= len;
+				}
+			}
+
+			constexpr Kernels kScalar = {Isa::Scalar, transformPointsScalar, transformAabbsScalar,
+										 spheresInFrustumScalar, normalizeScalar};
+
+#if defined(SCOP_BATCH_X86)
+
+#define SCOP_SSE4 __attribute__((target("sse4.1")))
+
+			SCOP_SSE4 void transformPointsSse4(const Mat4 &m, ConstVec3Streams in, Vec3Streams out, std::size_t begin, std::size_t end)
+			{
+				std::size_t i = begin;
+				for (; i + 4U <= end; i += 4U)
+				{
+					const __m128 x = _mm_loadu_ps(in.x + i);
+					const __m128 y = _mm_loadu_ps(in.y + i);
+					const __m128 z = _mm_loadu_ps(in.z + i);
+					for (std::size_t row = 0; row < 3; ++row)
+					{
+						__m128 sum = _mm_mul_ps(_mm_set1_ps(m(row, 0)), x);
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(m(row, 1)), y));
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(m(row, 2)), z));
+						sum = _mm_add_ps(sum, _mm_set1_ps(m(row, 3)));
+						float *target = (row == 0) ? out.x : (row == 1) ? out.y : out.z;
+						_mm_storeu_ps(target + i, sum);
+					}
+				}
+				transformPointsScalar(m, in, out, i, end);
+			}
+
+			SCOP_SSE4 void transformAabbsSse4(const Mat4 &m, ConstVec3Streams centers, ConstVec3Streams extents,
+											  Vec3Streams outMin, Vec3Streams outMax, std::size_t begin, std::size_t end)
+			{
+				std::size_t i = begin;
+				for (; i + 4U <= end; i += 4U)
+				{
+					const __m128 x = _mm_loadu_ps(centers.x + i);
+					const __m128 y = _mm_loadu_ps(centers.y + i);
+					const __m128 z = _mm_loadu_ps(centers.z + i);
+					const __m128 ex = _mm_loadu_ps(extents.x + i);
+					const __m128 ey = _mm_loadu_ps(extents.y + i);
+					const __m128 ez = _mm_loadu_ps(extents.z + i);
+					for (std::size_t row = 0; row < 3; ++row)
+					{
+						__m128 c = _mm_mul_ps(_mm_set1_ps(m(row, 0)), x);
+						c = _mm_add_ps(c, _mm_mul_ps(_mm_set1_ps(m(row, 1)), y));
+						c = _mm_add_ps(c, _mm_mul_ps(_mm_set1_ps(m(row, 2)), z));
+						c = _mm_add_ps(c, _mm_set1_ps(m(row, 3)));
+						__m128 w = _mm_mul_ps(_mm_set1_ps(std::fabs(m(row, 0))), ex);
+						w = _mm_add_ps(w, _mm_mul_ps(_mm_set1_ps(std::fabs(m(row, 1))), ey));
+						w = _mm_add_ps(w, _mm_mul_ps(_mm_set1_ps(std::fabs(m(row, 2))), ez));
+						float *low = (row == 0) ? outMin.x : (row == 1) ? outMin.y : outMin.z;
+						float *high = (row == 0) ? outMax.x : (row == 1) ? outMax.y : outMax.z;
+						_mm_storeu_ps(low + i, _mm_sub_ps(c, w));
+						_mm_storeu_ps(high + i, _mm_add_ps(c, w));
+					}
+				}
+				transformAabbsScalar(m, centers, extents, outMin, outMax, i, end);
+			}
+
+			SCOP_SSE4 std::size_t spheresInFrustumSse4(const Frustum &frustum, ConstVec3Streams centers, const float *radii,
+													   std::uint8_t *inside, std::size_t begin, std::size_t end)
+			{
+				std::size_t count = 0U;
+				std::size_t i = begin;
+				for (; i + 4U <= end; i += 4U)
+				{
+					const __m128 x = _mm_loadu_ps(centers.x + i);
+					const __m128 y = _mm_loadu_ps(centers.y + i);
+					const __m128 z = _mm_loadu_ps(centers.z + i);
+					const __m128 limit = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radii + i));
+					__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+					for (const Vec4 &plane : frustum)
+					{
+						__m128 d = _mm_mul_ps(_mm_set1_ps(plane.x), x);
+						d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.y), y));
+						d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.z), z));
+						d = _mm_add_ps(d, _mm_set1_ps(plane.w));
+						visible = _mm_and_ps(visible, _mm_cmpge_ps(d, limit));
+					}
+					const int mask = _mm_movemask_ps(visible);
+					for (std::size_t lane = 0; lane < 4U; ++lane)
+					{
+						inside[i + lane] = static_cast<std::uint8_t>((mask >> lane) & 1);
+					}
+					count += static_cast<std::size_t>(__builtin_popcount(static_cast<unsigned int>(mask)));
+				}
+				return count + spheresInFrustumScalar(frustum, centers, radii, inside, i, end);
+			}
+
+			SCOP_SSE4 void normalizeSse4(Vec3Streams v, std::size_t begin, std::size_t end)
+			{
+				std::size_t i = begin;
+				const __m128 epsilon = _mm_set1_ps(1e-8f);
+				for (; i + 4U <= end; i += 4U)
+				{
+					const __m128 x = _mm_loadu_ps(v.x + i);
+					const __m128 y = _mm_loadu_ps(v.y + i);
+					const __m128 z = _mm_loadu_ps(v.z + i);
+					const __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+					const __m128 tiny = _mm_cmple_ps(len, epsilon);
+					const __m128 zero = _mm_setzero_ps();
+					_mm_storeu_ps(v.x + i, _mm_blendv_ps(_mm_div_ps(x, len), zero, tiny));
+					_mm_storeu_ps(v.y + i, _mm_blendv_ps(_mm_div_ps(y, len), zero, tiny));
+					_mm_storeu_ps(v.z + i, _mm_blendv_ps(_mm_div_ps(z, len), zero, tiny));
+				}
+				normalizeScalar(v, i, end);
+			}
+
+#define SCOP_AVX2 __attribute__((target("avx2")))
+
+			SCOP_AVX2 void transformPointsAvx2(const Mat4 &m, ConstVec3Streams in, Vec3Streams out, std::size_t begin, std::size_t end)
+			{
+				std::size_t i = begin;
+				for (; i + 8U <= end; i += 8U)
+				{
+					const __m256 x = _mm256_loadu_ps(in.x + i);
+					const __m256 y = _mm256_loadu_ps(in.y + i);
+					const __m256 z = _mm256_loadu_ps(in.z + i);
+					for (std::size_t row = 0; row < 3; ++row)
+					{
+						__m256 sum = _mm256_mul_ps(_mm256_set1_ps(m(row, 0)), x);
+						sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(m(row, 1)), y));
+						sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(m(row, 2)), z));
+						sum = _mm256_add_ps(sum, _mm256_set1_ps(m(row, 3)));
+						float *target = (row == 0) ? out.x : (row == 1) ? out.y : out.z;
+						_mm256_storeu_ps(target + i, sum);
+					}
+				}
+				transformPointsScalar(m, in, out, i, end);
+			}
+
+			SCOP_AVX2 void transformAabbsAvx2(const Mat4 &m, ConstVec3Streams centers, ConstVec3Streams extents,
+											  Vec3Streams outMin, Vec3Streams outMax, std::size_t begin, std::size_t end)
+			{
+				std::size_t i = begin;
+				for (; i + 8U <= end; i += 8U)
+				{
+					const __m256 x = _mm256_loadu_ps(centers.x + i);
+					const __m256 y = _mm256_loadu_ps(centers.y + i);
+					const __m256 z = _mm256_loadu_ps(centers.z + i);
+					const __m256 ex = _mm256_loadu_ps(extents.x + i);
+					const __m256 ey = _mm256_loadu_ps(extents.y + i);
+					const __m256 ez = _mm256_loadu_ps(extents.z + i);
+					for (std::size_t row = 0; row < 3; ++row)
+					{
+						__m256 c = _mm256_mul_ps(_mm256_set1_ps(m(row, 0)), x);
+						c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_set1_ps(m(row, 1)), y));
+						c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_set1_ps(m(row, 2)), z));
+						c = _mm256_add_ps(c, _mm256_set1_ps(m(row, 3)));
+						__m256 w = _mm256_mul_ps(_mm256_set1_ps(std::fabs(m(row, 0))), ex);
+						w = _mm256_add_ps(w, _mm256_mul_ps(_mm256_set1_ps(std::fabs(m(row, 1))), ey));
+						w = _mm256_add_ps(w, _mm256_mul_ps(_mm256_set1_ps(std::fabs(m(row, 2))), ez));
+						float *low = (row == 0) ? outMin.x : (row == 1) ? outMin.y : outMin.z;
+						float *high = (row == 0) ? outMax.x : (row == 1) ? outMax.y : outMax.z;
+						_mm256_storeu_ps(low + i, _mm256_sub_ps(c, w));
+						_mm256_storeu_ps(high + i, _mm256_add_ps(c, w));
+					}
+				}
+				transformAabbsScalar(m, centers, extents, outMin, outMax, i, end);
+			}
+
+			SCOP_AVX2 std::size_t spheresInFrustumAvx2(const Frustum &frustum, ConstVec3Streams centers, const float *radii,
+													   std::uint8_t *inside, std::size_t begin, std::size_t end)
+			{
+				std::size_t count = 0U;
+				std::size_t i = begin;
+				for (; i + 8U <= end; i += 8U)
+				{
+					const __m256 x = _mm256_loadu_ps(centers.x + i);
+					const __m256 y = _mm256_loadu_ps(centers.y + i);
+					const __m256 z = _mm256_loadu_ps(centers.z + i);
+					const __m256 limit = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radii + i));
+					__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+					for (const Vec4 &plane : frustum)
+					{
+						__m256 d = _mm256_mul_ps(_mm256_set1_ps(plane.x), x);
+						d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.y), y));
+						d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.z), z));
+						d = _mm256_add_ps(d, _mm256_set1_ps(plane.w));
+						visible = _mm256_and_ps(visible, _mm256_cmp_ps(d, limit, _CMP_GE_OQ));
+					}
+					const int mask = _mm256_movemask_ps(visible);
+					for (std::size_t lane = 0; lane < 8U; ++lane)
+					{
+						inside[i + lane] = static_cast<std::uint8_t>((mask >> lane) & 1);
+					}
+					count += static_cast<std::size_t>(__builtin_popcount(static_cast<unsigned int>(mask)));
+				}
+				return count + spheresInFrustumScalar(frustum, centers, radii, inside, i, end);
+			}
+
+			SCOP_AVX2 void normalizeAvx2(Vec3Streams v, std::size_t begin, std::size_t end)
+			{
+				std::size_t i = begin;
+				const __m256 epsilon = _mm256_set1_ps(1e-8f);
+				for (; i + 8U <= end; i += 8U)
+				{
+					const __m256 x = _mm256_loadu_ps(v.x + i);
+					const __m256 y = _mm256_loadu_ps(v.y + i);
+					const __m256 z = _mm256_loadu_ps(v.z + i);
+					const __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)),
+																   _mm256_mul_ps(z, z)));
+					const __m256 tiny = _mm256_cmp_ps(len, epsilon, _CMP_LE_OQ);
+					const __m256 zero = _mm256_setzero_ps();
+					_mm256_storeu_ps(v.x + i, _mm256_blendv_ps(_mm256_div_ps(x, len), zero, tiny));
+					_mm256_storeu_ps(v.y + i, _mm256_blendv_ps(_mm256_div_ps(y, len), zero, tiny));
+					_mm256_storeu_ps(v.z + i, _mm256_blendv_ps(_mm256_div_ps(z, len), zero, tiny));
+				}
+				normalizeScalar(v, i, end);
+			}
+
+			constexpr Kernels kSse4 = {Isa::Sse4, transformPointsSse4, transformAabbsSse4,
+									   spheresInFrustumSse4, normalizeSse4};
+			constexpr Kernels kAvx2 = {Isa::Avx2, transformPointsAvx2, transformAabbsAvx2,
+									   spheresInFrustumAvx2, normalizeAvx2};
+
+#endif
+
+			bool supported(Isa isa)
+			{
+				switch (isa)
+				{
+#if defined(SCOP_BATCH_X86)
+				case Isa::Avx2:
+					return __builtin_cpu_supports("avx2");
+				case Isa::Sse4:
+					return __builtin_cpu_supports("sse4.1");
+#endif
+				case Isa::Scalar:
+					return true;
+				default:
+					return false;
+				}
+			}
+
+			const Kernels &kernelsFor(Isa isa)
+			{
+				switch (isa)
+				{
+#if defined(SCOP_BATCH_X86)
+				case Isa::Avx2:
+					return kAvx2;
+				case Isa::Sse4:
+					return kSse4;
+#endif
+				default:
+					return kScalar;
+				}
+			}
+
+			std::atomic<const Kernels *> &activeKernels()
+			{
+				static std::atomic<const Kernels *> active(&kernelsFor(bestIsa()));
+				return active;
+			}
+
+			const Kernels &kernels()
+			{
+				return *activeKernels().load(std::memory_order_relaxed);
+			}
+
+		} // namespace
+
+		Isa bestIsa()
+		{
+			if (supported(Isa::Avx2))
+			{
+				return Isa::Avx2;
+			}
+			if (supported(Isa::Sse4))
+			{
+				return Isa::Sse4;
+			}
+			return Isa::Scalar;
+		}
+
+		Isa isa()
+		{
+			return kernels().isa;
+		}
+
+		Isa setIsa(Isa requested)
+		{
+			Isa chosen = requested;
+			while (chosen != Isa::Scalar && !supported(chosen))
+			{
+				chosen = static_cast<Isa>(static_cast<int>(chosen) - 1);
+			}
+			activeKernels().store(&kernelsFor(chosen), std::memory_order_relaxed);
+			return chosen;
+		}
+
+		const char *isaName(Isa isa)
+		{
+			switch (isa)
+			{
+			case Isa::Avx2:
+				return "avx2";
+			case Isa::Sse4:
+				return "sse4.1";
+			default:
+				return "scalar";
+			}
+		}
+
+		void transformPoints(const Mat4 &transform, ConstVec3Streams in, Vec3Streams out, std::size_t count)
+		{
+			kernels().transformPoints(transform, in, out, 0U, count);
+		}
+
+		void transformAabbs(const Mat4 &transform, ConstVec3Streams centers, ConstVec3Streams extents,
+							Vec3Streams outMin, Vec3Streams outMax, std::size_t count)
+		{
+			kernels().transformAabbs(transform, centers, extents, outMin, outMax, 0U, count);
+		}
+
+		std::size_t spheresInFrustum(const Frustum &frustum, ConstVec3Streams centers, const float *radii,
+									 std::size_t count, std::uint8_t *inside)
+		{
+			return kernels().spheresInFrustum(frustum, centers, radii, inside, 0U, count);
+		}
+
+		void normalize(Vec3Streams vectors, std::size_t count)
+		{
+			kernels().normalize(vectors, 0U, count);
+		}
+
+	} // namespace MathBatch
+
+} // namespace scop
@@ -0,0 +1,103 @@
+#include "MemoryTracker.hpp"
+
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+namespace scop
+{
+
+	std::array<std::atomic<std::size_t>, kMemoryTagCount> MemoryTracker::current_{};
+	std::array<std::atomic<std::size_t>, kMemoryTagCount> MemoryTracker::peak_{};
+	std::atomic<std::size_t> MemoryTracker::total_(0U);
+	std::atomic<std::size_t> MemoryTracker::totalPeak_(0U);
+	std::atomic<std::size_t> MemoryTracker::budget_(0U);
+
+	namespace
+	{
+
+		constexpr double kMiB = 1024.0 * 1024.0;
+
+		void raisePeak(std::atomic<std::size_t> &peak, std::size_t value)
+		{
+			std::size_t previous = peak.load(std::memory_order_relaxed);
+			while (previous < value && !peak.compare_exchange_weak(previous, value, std::memory_order_relaxed))
+			{
+			}
+		}
+
+	} // namespace
+
+	const char *memoryTagName(MemoryTag tag)
+	{
+		switch (tag)
+		{
+		case MemoryTag::Loader:
+			return "loader";
+		case MemoryTag::Texture:
+			return "texture";
+		case MemoryTag::Renderer:
+			return "renderer";
+		}
+		return "unknown";
+	}
+
+	void MemoryTracker::setHostBudget(std::size_t bytes)
+	{
+		budget_.store(bytes, std::memory_order_relaxed);
+	}
+
+	void MemoryTracker::allocated(MemoryTag tag, std::size_t bytes)
+	{
+		const std::size_t total = total_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		const std::size_t budget = budget_.load(std::memory_order_relaxed);
+		if (budget != 0U && total > budget)
+		{
+			total_.fetch_sub(bytes, std::memory_order_relaxed);
+			throw std::runtime_error("Host memory budget of " + std::to_string(budget) + " bytes exceeded: " +
+									 memoryTagName(tag) + " requested " + std::to_string(bytes) + " bytes with " +
+									 std::to_string(total - bytes) + " in use");
+		}
+		raisePeak(totalPeak_, total);
+		const std::size_t index = static_cast<std::size_t>(tag);
+		raisePeak(peak_[index], current_[index].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+	}
+
+	void MemoryTracker::released(MemoryTag tag, std::size_t bytes)
+	{
+		current_[static_cast<std::size_t>(tag)].fetch_sub(bytes, std::memory_order_relaxed);
+		total_.fetch_sub(bytes, std::memory_order_relaxed);
+	}
+
+	std::size_t MemoryTracker::current(MemoryTag tag)
+	{
+		return current_[static_cast<std::size_t>(tag)].load(std::memory_order_relaxed);
+	}
+
+	std::size_t MemoryTracker::peak(MemoryTag tag)
+	{
+		return peak_[static_cast<std::size_t>(tag)].load(std::memory_order_relaxed);
+	}
+
+	void MemoryTracker::printStats(std::ostream &out)
+	{
+		const std::ios::fmtflags flags = out.flags();
+		out << std::fixed << std::setprecision(2) << "Host memory:";
+		for (std::size_t i = 0; i < kMemoryTagCount; ++i)
+		{
+			const MemoryTag tag = static_cast<MemoryTag>(i);
+			out << (i == 0 ? " " : ", ") << memoryTagName(tag) << ' '
+				<< static_cast<double>(current(tag)) / kMiB << " MiB (peak "
+				<< static_cast<double>(peak(tag)) / kMiB << ')';
+		}
+		out << "; total " << static_cast<double>(totalCurrent()) / kMiB << " MiB, peak "
+			<< static_cast<double>(totalPeak()) / kMiB << " MiB";
+		if (hostBudget() != 0U)
+		{
+			out << ", budget " << static_cast<double>(hostBudget()) / kMiB << " MiB";
+		}
+		out << '\n';
+		out.flags(flags);
+	}
+
+} // namespace scop
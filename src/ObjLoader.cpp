@@ -1,5 +1,7 @@
 #include "ObjLoader.hpp"
 
+#include "Profiler.hpp"
+
 #include <algorithm>
 #include <cctype>
 #include <cmath>
@@ -16,34 +18,30 @@ namespace scop
 	namespace
 	{
 
-		struct IndexTriplet
-		{
-			int v;
-			int vt;
-			int vn;
-		};
+		using detail::computeFaceNormal;
+		using detail::Face;
+		using detail::generateBoxUV;
+		using detail::IndexTriplet;
+		using detail::parseFaceToken;
+		using detail::Triangle;
+		using detail::triangulateFace;
 
-		struct Face
+		struct Group
 		{
-			std::vector<IndexTriplet> vertices;
+			std::string name;
+			std::size_t firstFace;
 		};
 
 		struct RawObj
 		{
-			std::vector<Vec3> positions;
-			std::vector<Vec2> texcoords;
-			std::vector<Vec3> normals;
-			std::vector<Face> faces;
+			TrackedVector<Vec3, MemoryTag::Loader> positions;
+			TrackedVector<Vec2, MemoryTag::Loader> texcoords;
+			TrackedVector<Vec3, MemoryTag::Loader> normals;
+			TrackedVector<Face, MemoryTag::Loader> faces;
+			std::vector<Group> groups;
 			Bounds bounds;
 		};
 
-		struct Triangle
-		{
-			int a;
-			int b;
-			int c;
-		};
-
 		float hash01(std::size_t seed)
 		{
 			seed = (seed ^ 61U) ^ (seed >> 16U);
@@ -88,6 +86,65 @@ namespace scop
 			throw std::runtime_error("OBJ index 0 is invalid");
 		}
 
+		Vec2 projectPoint(const Vec3 &point, const Vec3 &normal)
+		{
+			const float ax = std::fabs(normal.x);
+			const float ay = std::fabs(normal.y);
+			const float az = std::fabs(normal.z);
+
+			if (ax >= ay && ax >= az)
+			{
+				return Vec2(point.y, point.z);
+			}
+			if (ay >= az)
+			{
+				return Vec2(point.x, point.z);
+			}
+			return Vec2(point.x, point.y);
+		}
+
+		float signedArea(const std::vector<Vec2> &polygon)
+		{
+			float area = 0.0f;
+			for (std::size_t i = 0; i < polygon.size(); ++i)
+			{
+				const Vec2 &a = polygon[i];
+				const Vec2 &b = polygon[(i + 1U) % polygon.size()];
+				area += a.x * b.y - b.x * a.y;
+			}
+			return area * 0.5f;
+		}
+
+		float cross2D(const Vec2 &a, const Vec2 &b, const Vec2 &c)
+		{
+			return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		}
+
+		bool pointInTriangle(const Vec2 &p, const Vec2 &a, const Vec2 &b, const Vec2 &c)
+		{
+			const float c1 = cross2D(a, b, p);
+			const float c2 = cross2D(b, c, p);
+			const float c3 = cross2D(c, a, p);
+			const bool hasNeg = (c1 < 0.0f) || (c2 < 0.0f) || (c3 < 0.0f);
+			const bool hasPos = (c1 > 0.0f) || (c2 > 0.0f) || (c3 > 0.0f);
+			return !(hasNeg && hasPos);
+		}
+
+		float normalizedAxis(float value, float minValue, float maxValue)
+		{
+			const float extent = maxValue - minValue;
+			if (extent <= 1e-6f)
+			{
+				return 0.5f;
+			}
+			return (value - minValue) / extent;
+		}
+
+	} // namespace
+
+	namespace detail
+	{
+
 		IndexTriplet parseFaceToken(const std::string &token, int positionCount, int texcoordCount, int normalCount)
 		{
 			IndexTriplet out = {-1, -1, -1};
@@ -120,7 +177,7 @@ namespace scop
 			return out;
 		}
 
-		Vec3 computeFaceNormal(const Face &face, const std::vector<Vec3> &positions)
+		Vec3 computeFaceNormal(const Face &face, const TrackedVector<Vec3, MemoryTag::Loader> &positions)
 		{
 			Vec3 normal(0.0f, 0.0f, 0.0f);
 			const std::size_t count = face.vertices.size();
@@ -147,51 +204,7 @@ namespace scop
 			return normal;
 		}
 
-		Vec2 projectPoint(const Vec3 &point, const Vec3 &normal)
-		{
-			const float ax = std::fabs(normal.x);
-			const float ay = std::fabs(normal.y);
-			const float az = std::fabs(normal.z);
-
-			if (ax >= ay && ax >= az)
-			{
-				return Vec2(point.y, point.z);
-			}
-			if (ay >= az)
-			{
-				return Vec2(point.x, point.z);
-			}
-			return Vec2(point.x, point.y);
-		}
-
-		float signedArea(const std::vector<Vec2> &polygon)
-		{
-			float area = 0.0f;
-			for (std::size_t i = 0; i < polygon.size(); ++i)
-			{
-				const Vec2 &a = polygon[i];
-				const Vec2 &b = polygon[(i + 1U) % polygon.size()];
-				area += a.x * b.y - b.x * a.y;
-			}
-			return area * 0.5f;
-		}
-
-		float cross2D(const Vec2 &a, const Vec2 &b, const Vec2 &c)
-		{
-			return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
-		}
-
-		bool pointInTriangle(const Vec2 &p, const Vec2 &a, const Vec2 &b, const Vec2 &c)
-		{
-			const float c1 = cross2D(a, b, p);
-			const float c2 = cross2D(b, c, p);
-			const float c3 = cross2D(c, a, p);
-			const bool hasNeg = (c1 < 0.0f) || (c2 < 0.0f) || (c3 < 0.0f);
-			const bool hasPos = (c1 > 0.0f) || (c2 > 0.0f) || (c3 > 0.0f);
-			return !(hasNeg && hasPos);
-		}
-
-		std::vector<Triangle> triangulateFace(const Face &face, const std::vector<Vec3> &positions)
+		std::vector<Triangle> triangulateFace(const Face &face, const TrackedVector<Vec3, MemoryTag::Loader> &positions)
 		{
 			std::vector<Triangle> out;
 			if (face.vertices.size() < 3U)
@@ -288,16 +301,6 @@ namespace scop
 			return out;
 		}
 
-		float normalizedAxis(float value, float minValue, float maxValue)
-		{
-			const float extent = maxValue - minValue;
-			if (extent <= 1e-6f)
-			{
-				return 0.5f;
-			}
-			return (value - minValue) / extent;
-		}
-
 		Vec2 generateBoxUV(const Vec3 &position, const Vec3 &normal, const Bounds &bounds)
 		{
 			const float ax = std::fabs(normal.x);
@@ -324,8 +327,14 @@ namespace scop
 			return uv;
 		}
 
+	} // namespace detail
+
+	namespace
+	{
+
 		RawObj parseObj(const std::string &path)
 		{
+			SCOP_PROFILE_ZONE("ObjLoader::parse");
 			std::ifstream file(path.c_str());
 			if (!file)
 			{
@@ -333,6 +342,7 @@ namespace scop
 			}
 
 			RawObj raw;
+			raw.groups.push_back({std::string(), 0U});
 			raw.bounds.min = Vec3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
 			raw.bounds.max = Vec3(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
 
@@ -391,6 +401,25 @@ namespace scop
 						raw.faces.push_back(face);
 					}
 				}
+				else if (type == "o" || type == "g")
+				{
+					std::string name;
+					std::getline(stream >> std::ws, name);
+					while (!name.empty() && std::isspace(static_cast<unsigned char>(name.back())))
+					{
+						name.pop_back();
+					}
+					// A group that has not received faces yet is renamed
+					// rather than left behind empty.
+					if (raw.groups.back().firstFace == raw.faces.size())
+					{
+						raw.groups.back().name = name;
+					}
+					else
+					{
+						raw.groups.push_back({name, raw.faces.size()});
+					}
+				}
 			}
 
 			if (raw.positions.empty() || raw.faces.empty())
@@ -400,69 +429,225 @@ namespace scop
 			return raw;
 		}
 
-	} // namespace
-
-	MeshData ObjLoader::loadFromFile(const std::string &path)
-	{
-		const RawObj raw = parseObj(path);
-
-		MeshData mesh;
-		mesh.bounds = raw.bounds;
-		mesh.hasSourceTexcoords = !raw.texcoords.empty();
-		mesh.usedGeneratedTexcoords = false;
-
-		for (std::size_t faceIndex = 0; faceIndex < raw.faces.size(); ++faceIndex)
+		MeshData buildMesh(const RawObj &raw, std::size_t firstFace, std::size_t endFace, const std::string &name)
 		{
-			const Face &face = raw.faces[faceIndex];
-			const Vec3 faceNormal = computeFaceNormal(face, raw.positions);
-			const Vec3 faceColor = chooseFaceColor(faceNormal, faceIndex);
-			const std::vector<Triangle> triangles = triangulateFace(face, raw.positions);
-
-			for (const Triangle &tri : triangles)
-			{
-				const IndexTriplet triplets[3] = {
-					face.vertices[static_cast<std::size_t>(tri.a)],
-					face.vertices[static_cast<std::size_t>(tri.b)],
-					face.vertices[static_cast<std::size_t>(tri.c)]};
-
-				const Vec3 triPositions[3] = {
-					raw.positions[triplets[0].v],
-					raw.positions[triplets[1].v],
-					raw.positions[triplets[2].v]};
-				Vec3 triNormal = normalize(cross(triPositions[1] - triPositions[0], triPositions[2] - triPositions[0]));
-				if (length(triNormal) <= 1e-6f)
-				{
-					triNormal = faceNormal;
-				}
+			MeshData mesh;
+			mesh.name = name;
+			mesh.hasSourceTexcoords = !raw.texcoords.empty();
+			mesh.usedGeneratedTexcoords = false;
+			mesh.bounds.min = Vec3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+			mesh.bounds.max = Vec3(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+
+			for (std::size_t faceIndex = firstFace; faceIndex < endFace; ++faceIndex)
+			{
+				const Face &face = raw.faces[faceIndex];
+				const Vec3 faceNormal = computeFaceNormal(face, raw.positions);
+				const Vec3 faceColor = chooseFaceColor(faceNormal, faceIndex);
+				const std::vector<Triangle> triangles = triangulateFace(face, raw.positions);
 
-				for (int corner = 0; corner < 3; ++corner)
+				for (const Triangle &tri : triangles)
 				{
-					Vertex vertex;
-					vertex.position = triPositions[corner];
-					vertex.color = faceColor;
-					vertex.normal = triNormal;
-
-					if (triplets[corner].vt >= 0)
+					const IndexTriplet triplets[3] = {
+						face.vertices[static_cast<std::size_t>(tri.a)],
+						face.vertices[static_cast<std::size_t>(tri.b)],
+						face.vertices[static_cast<std::size_t>(tri.c)]};
+
+					const Vec3 triPositions[3] = {
+						raw.positions[triplets[0].v],
+						raw.positions[triplets[1].v],
+						raw.positions[triplets[2].v]};
+					Vec3 triNormal = normalize(cross(triPositions[1] - triPositions[0], triPositions[2] - triPositions[0]));
+					if (length(triNormal) <= 1e-6f)
 					{
-						vertex.uv = raw.texcoords[triplets[corner].vt];
+						triNormal = faceNormal;
 					}
-					else
+
+					for (int corner = 0; corner < 3; ++corner)
 					{
-						vertex.uv = generateBoxUV(vertex.position, triNormal, raw.bounds);
-						mesh.usedGeneratedTexcoords = true;
-					}
+						Vertex vertex;
+						vertex.position = triPositions[corner];
+						vertex.color = faceColor;
+						vertex.normal = triNormal;
+
+						// Generated UVs use the whole file's bounds so the
+						// groups of one model stay seamless.
+						if (triplets[corner].vt >= 0)
+						{
+							vertex.uv = raw.texcoords[triplets[corner].vt];
+						}
+						else
+						{
+							vertex.uv = generateBoxUV(vertex.position, triNormal, raw.bounds);
+							mesh.usedGeneratedTexcoords = true;
+						}
 
-					mesh.indices.push_back(static_cast<uint32_t>(mesh.vertices.size()));
-					mesh.vertices.push_back(vertex);
+						mesh.bounds.min = minVec(mesh.bounds.min, vertex.position);
+						mesh.bounds.max = maxVec(mesh.bounds.max, vertex.position);
+						mesh.indices.push_back(static_cast<uint32_t>(mesh.vertices.size()));
+						mesh.vertices.push_back(vertex);
+					}
 				}
 			}
+			return mesh;
+		}
+
+		std::string trim(const std::string &value)
+		{
+			std::size_t start = 0;
+			while (start < value.size() && std::isspace(static_cast<unsigned char>(value[start])))
+				++start;
+
+			std::size_t end = value.size();
+			while (end > start && std::isspace(static_cast<unsigned char>(value[end - 1])))
+				--end;
+
+			return value.substr(start, end - start);
+		}
+
+		std::string directoryOf(const std::string &path)
+		{
+			const std::size_t slash = path.find_last_of("/\\");
+			if (slash == std::string::npos)
+				return ".";
+			if (slash == 0)
+				return "/";
+			return path.substr(0, slash);
+		}
+
+		std::string joinPath(const std::string &baseDir, const std::string &path)
+		{
+			if (path.empty())
+				return path;
+			if (!path.empty() && (path[0] == '/' || path[0] == '\\'))
+				return path;
+			if (baseDir.empty() || baseDir == ".")
+				return path;
+			if (baseDir.back() == '/' || baseDir.back() == '\\')
+				return baseDir + path;
+			return baseDir + "/" + path;
+		}
+
+		std::string findMtllibInObj(const std::string &objPath)
+		{
+			std::ifstream file(objPath.c_str());
+			if (!file)
+				return "";
+
+			std::string line;
+			while (std::getline(file, line))
+			{
+				const std::string s = trim(line);
+				if (s.empty() || s[0] == '#')
+					continue;
+				if (s.rfind("mtllib ", 0) == 0)
+					return trim(s.substr(7));
+			}
+			return "";
 		}
 
+	} // namespace
+
+	ObjMaterial::ObjMaterial()
+		: valid(false),
+		  kd(0.64f, 0.64f, 0.64f),
+		  ks(0.50f, 0.50f, 0.50f),
+		  ns(96.078431f) {}
+
+	MeshData ObjLoader::loadFromFile(const std::string &path)
+	{
+		SCOP_PROFILE_FUNCTION();
+		const RawObj raw = parseObj(path);
+		SCOP_PROFILE_ZONE("ObjLoader::triangulate");
+
+		MeshData mesh = buildMesh(raw, 0U, raw.faces.size(), std::string());
 		if (mesh.vertices.empty() || mesh.indices.empty())
 		{
 			throw std::runtime_error("OBJ parsing produced an empty mesh: " + path);
 		}
+		mesh.bounds = raw.bounds;
 		return mesh;
 	}
 
+	std::vector<MeshData> ObjLoader::loadGroupsFromFile(const std::string &path)
+	{
+		SCOP_PROFILE_FUNCTION();
+		const RawObj raw = parseObj(path);
+		SCOP_PROFILE_ZONE("ObjLoader::triangulate");
+
+		std::vector<MeshData> meshes;
+		for (std::size_t group = 0; group < raw.groups.size(); ++group)
+		{
+			const std::size_t firstFace = raw.groups[group].firstFace;
+			const std::size_t endFace = (group + 1U < raw.groups.size()) ? raw.groups[group + 1U].firstFace : raw.faces.size();
+			MeshData mesh = buildMesh(raw, firstFace, endFace, raw.groups[group].name);
+			if (!mesh.indices.empty())
+			{
+				meshes.push_back(std::move(mesh));
+			}
+		}
+
+		if (meshes.empty())
+		{
+			throw std::runtime_error("OBJ parsing produced an empty mesh: " + path);
+		}
+		return meshes;
+	}
+
+	ObjMaterial ObjLoader::loadMaterial(const std::string &objPath)
+	{
+		SCOP_PROFILE_FUNCTION();
+		ObjMaterial material;
+
+		const std::string mtllib = findMtllibInObj(objPath);
+		if (mtllib.empty())
+			return material;
+
+		const std::string mtlPath = joinPath(directoryOf(objPath), mtllib);
+		std::ifstream file(mtlPath.c_str());
+		if (!file)
+			return material;
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			const std::string s = trim(line);
+			if (s.empty() || s[0] == '#')
+				continue;
+
+			std::istringstream iss(s);
+			std::string key;
+			iss >> key;
+
+			if (key == "Kd")
+			{
+				float r, g, b;
+				if (iss >> r >> g >> b)
+				{
+					material.kd = Vec3(r, g, b);
+					material.valid = true;
+				}
+			}
+			else if (key == "Ks")
+			{
+				float r, g, b;
+				if (iss >> r >> g >> b)
+				{
+					material.ks = Vec3(r, g, b);
+					material.valid = true;
+				}
+			}
+			else if (key == "Ns")
+			{
+				float ns;
+				if (iss >> ns)
+				{
+					material.ns = ns;
+					material.valid = true;
+				}
+			}
+		}
+
+		return material;
+	}
+
 } // namespace scop
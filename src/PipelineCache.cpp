@@ -0,0 +1,155 @@
+#include "PipelineCache.hpp"
+
+#include "FileUtils.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace scop
+{
+	namespace
+	{
+
+		// Layout of the header every driver writes at the start of
+		// vkGetPipelineCacheData (VK_PIPELINE_CACHE_HEADER_VERSION_ONE).
+		constexpr std::size_t kHeaderSize = 16U + VK_UUID_SIZE;
+
+		std::string cacheDirectory()
+		{
+			const char *xdg = std::getenv("XDG_CACHE_HOME");
+			if (xdg != nullptr && xdg[0] != '\0')
+			{
+				return std::string(xdg) + "/scop";
+			}
+			const char *home = std::getenv("HOME");
+			if (home != nullptr && home[0] != '\0')
+			{
+				return std::string(home) + "/.cache/scop";
+			}
+			return ".";
+		}
+
+		uint32_t readU32(const std::uint8_t *bytes)
+		{
+			uint32_t value = 0U;
+			std::memcpy(&value, bytes, sizeof(value));
+			return value;
+		}
+
+		bool headerMatches(const std::vector<std::uint8_t> &data, const VkPhysicalDeviceProperties &properties)
+		{
+			if (data.size() < kHeaderSize)
+			{
+				return false;
+			}
+			const uint32_t headerLength = readU32(data.data());
+			const uint32_t headerVersion = readU32(data.data() + 4U);
+			const uint32_t vendorID = readU32(data.data() + 8U);
+			const uint32_t deviceID = readU32(data.data() + 12U);
+
+			return headerLength >= kHeaderSize && headerLength <= data.size() &&
+				   headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+				   vendorID == properties.vendorID &&
+				   deviceID == properties.deviceID &&
+				   std::memcmp(data.data() + 16U, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		}
+
+	} // namespace
+
+	PipelineCache::PipelineCache()
+		: device_(VK_NULL_HANDLE),
+		  cache_(VK_NULL_HANDLE),
+		  warm_(false),
+		  loadedBytes_(0U) {}
+
+	PipelineCache::~PipelineCache()
+	{
+		destroy();
+	}
+
+	void PipelineCache::init(VkPhysicalDevice physicalDevice, VkDevice device)
+	{
+		device_ = device;
+		path_ = cacheDirectory() + "/pipeline_cache.bin";
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		std::vector<std::uint8_t> data;
+		try
+		{
+			data = readBinaryFile(path_);
+		}
+		catch (const std::exception &)
+		{
+			data.clear();
+		}
+		if (!data.empty() && !headerMatches(data, properties))
+		{
+			std::cout << "Pipeline cache at " << path_ << " belongs to another device or driver, ignoring it" << std::endl;
+			data.clear();
+		}
+
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = data.size();
+		cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+		if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &cache_) != VK_SUCCESS)
+		{
+			cacheInfo.initialDataSize = 0U;
+			cacheInfo.pInitialData = nullptr;
+			data.clear();
+			if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &cache_) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create pipeline cache");
+			}
+		}
+		warm_ = !data.empty();
+		loadedBytes_ = data.size();
+	}
+
+	void PipelineCache::save() const
+	{
+		if (cache_ == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		std::size_t size = 0U;
+		if (vkGetPipelineCacheData(device_, cache_, &size, nullptr) != VK_SUCCESS || size == 0U)
+		{
+			return;
+		}
+		std::vector<std::uint8_t> data(size);
+		if (vkGetPipelineCacheData(device_, cache_, &size, data.data()) != VK_SUCCESS)
+		{
+			return;
+		}
+
+		try
+		{
+			std::filesystem::create_directories(std::filesystem::path(path_).parent_path());
+			writeBinaryFile(path_, data.data(), size);
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << "Warning: could not save pipeline cache: " << e.what() << '\n';
+		}
+	}
+
+	void PipelineCache::destroy()
+	{
+		if (cache_ != VK_NULL_HANDLE)
+		{
+			vkDestroyPipelineCache(device_, cache_, nullptr);
+			cache_ = VK_NULL_HANDLE;
+		}
+	}
+
+} // namespace scop
@@ -0,0 +1,149 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace scop
+{
+	namespace
+	{
+
+		struct ZoneEvent
+		{
+			const char *name;
+			int64_t beginNs;
+			int64_t endNs;
+		};
+
+		// Single producer (the owning thread), read by the trace writer. When the
+		// ring wraps the oldest zones are overwritten so a long session keeps its
+		// most recent history.
+		struct ThreadRing
+		{
+			static constexpr std::size_t kCapacity = 1U << 16;
+
+			explicit ThreadRing(uint32_t id)
+				: threadId(id),
+				  head(0U),
+				  events(kCapacity) {}
+
+			uint32_t threadId;
+			std::string threadName;
+			std::atomic<uint64_t> head;
+			std::vector<ZoneEvent> events;
+		};
+
+		struct Registry
+		{
+			std::mutex mutex;
+			std::vector<std::unique_ptr<ThreadRing>> rings;
+			Profiler::Clock::time_point origin = Profiler::Clock::now();
+		};
+
+		Registry &registry()
+		{
+			static Registry instance;
+			return instance;
+		}
+
+		ThreadRing &threadRing()
+		{
+			thread_local ThreadRing *ring = nullptr;
+			if (ring == nullptr)
+			{
+				Registry &reg = registry();
+				std::lock_guard<std::mutex> lock(reg.mutex);
+				reg.rings.push_back(std::make_unique<ThreadRing>(static_cast<uint32_t>(reg.rings.size() + 1U)));
+				ring = reg.rings.back().get();
+			}
+			return *ring;
+		}
+
+		void writeEscaped(std::ostream &out, const std::string &text)
+		{
+			for (const char c : text)
+			{
+				if (c == '"' || c == '\\')
+				{
+					out << '\\';
+				}
+				out << c;
+			}
+		}
+
+	} // namespace
+
+	std::atomic<bool> Profiler::enabled_(false);
+
+	void Profiler::enable()
+	{
+		registry();
+		enabled_.store(true, std::memory_order_relaxed);
+	}
+
+	void Profiler::record(const char *name, Clock::time_point begin, Clock::time_point end)
+	{
+		ThreadRing &ring = threadRing();
+		const Clock::time_point origin = registry().origin;
+		const uint64_t slot = ring.head.load(std::memory_order_relaxed);
+		ZoneEvent &event = ring.events[slot % ThreadRing::kCapacity];
+		event.name = name;
+		event.beginNs = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - origin).count();
+		event.endNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - origin).count();
+		ring.head.store(slot + 1U, std::memory_order_release);
+	}
+
+	void Profiler::setThreadName(const std::string &name)
+	{
+		ThreadRing &ring = threadRing();
+		std::lock_guard<std::mutex> lock(registry().mutex);
+		ring.threadName = name;
+	}
+
+	void Profiler::writeChromeTrace(const std::string &path)
+	{
+		std::ofstream out(path.c_str(), std::ios::trunc);
+		if (!out)
+		{
+			throw std::runtime_error("Failed to open trace file: " + path);
+		}
+
+		Registry &reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		for (const std::unique_ptr<ThreadRing> &ring : reg.rings)
+		{
+			const std::string threadName = ring->threadName.empty() ? "thread " + std::to_string(ring->threadId) : ring->threadName;
+			out << (first ? "" : ",\n")
+				<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadId
+				<< ",\"args\":{\"name\":\"";
+			writeEscaped(out, threadName);
+			out << "\"}}";
+			first = false;
+
+			const uint64_t head = ring->head.load(std::memory_order_acquire);
+			const uint64_t begin = head > ThreadRing::kCapacity ? head - ThreadRing::kCapacity : 0U;
+			for (uint64_t i = begin; i < head; ++i)
+			{
+				const ZoneEvent &event = ring->events[i % ThreadRing::kCapacity];
+				out << ",\n{\"name\":\"";
+				writeEscaped(out, event.name);
+				out << "\",\"cat\":\"scop\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadId
+					<< ",\"ts\":" << static_cast<double>(event.beginNs) / 1000.0
+					<< ",\"dur\":" << static_cast<double>(std::max<int64_t>(event.endNs - event.beginNs, 0)) / 1000.0 << "}";
+			}
+		}
+		out << "\n]}\n";
+		if (!out)
+		{
+			throw std::runtime_error("Failed to write trace file: " + path);
+		}
+	}
+
+} // namespace scop
@@ -0,0 +1,121 @@
+#include "SceneGeometry.hpp"
+
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace scop
+{
+	namespace
+	{
+
+		Bounds emptyBounds()
+		{
+			Bounds bounds;
+			bounds.min = Vec3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+			bounds.max = Vec3(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+			return bounds;
+		}
+
+	} // namespace
+
+	SceneGeometry::SceneGeometry()
+		: bounds_(emptyBounds()),
+		  vertexCount_(0U),
+		  indexCount_(0U),
+		  resident_(true) {}
+
+	uint32_t SceneGeometry::addModel(const std::vector<MeshData> &meshes, const Vec3 &offset)
+	{
+		SCOP_PROFILE_FUNCTION();
+		if (!resident_)
+		{
+			throw std::runtime_error("Scene geometry was released; clear it before adding models");
+		}
+		Bounds modelBounds = emptyBounds();
+		for (const MeshData &mesh : meshes)
+		{
+			for (const Vertex &vertex : mesh.vertices)
+			{
+				modelBounds.min = minVec(modelBounds.min, vertex.position);
+				modelBounds.max = maxVec(modelBounds.max, vertex.position);
+			}
+		}
+		if (modelBounds.min.x > modelBounds.max.x)
+		{
+			throw std::runtime_error("Scene model has no vertices");
+		}
+
+		const Vec3 center = (modelBounds.min + modelBounds.max) * 0.5f;
+		const Vec3 extent = modelBounds.max - modelBounds.min;
+		const float maxExtent = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-4f));
+		const float scale = 1.6f / maxExtent;
+
+		SceneModel model;
+		model.firstSubmesh = static_cast<uint32_t>(submeshes_.size());
+		model.submeshCount = 0U;
+		model.bounds = emptyBounds();
+
+		for (const MeshData &mesh : meshes)
+		{
+			if (mesh.indices.empty())
+			{
+				continue;
+			}
+
+			Submesh submesh;
+			submesh.name = mesh.name;
+			submesh.firstIndex = static_cast<uint32_t>(indices_.size());
+			submesh.indexCount = static_cast<uint32_t>(mesh.indices.size());
+			submesh.vertexOffset = static_cast<int32_t>(vertices_.size());
+			submesh.model = static_cast<uint32_t>(models_.size());
+			submesh.bounds = emptyBounds();
+
+			vertices_.reserve(vertices_.size() + mesh.vertices.size());
+			for (const Vertex &source : mesh.vertices)
+			{
+				Vertex vertex = source;
+				vertex.position = (source.position - center) * scale + offset;
+				submesh.bounds.min = minVec(submesh.bounds.min, vertex.position);
+				submesh.bounds.max = maxVec(submesh.bounds.max, vertex.position);
+				vertices_.push_back(vertex);
+			}
+			indices_.insert(indices_.end(), mesh.indices.begin(), mesh.indices.end());
+
+			model.bounds.min = minVec(model.bounds.min, submesh.bounds.min);
+			model.bounds.max = maxVec(model.bounds.max, submesh.bounds.max);
+			submeshes_.push_back(submesh);
+			++model.submeshCount;
+		}
+		bounds_.min = minVec(bounds_.min, model.bounds.min);
+		bounds_.max = maxVec(bounds_.max, model.bounds.max);
+		models_.push_back(model);
+		vertexCount_ = vertices_.size();
+		indexCount_ = indices_.size();
+		return static_cast<uint32_t>(models_.size() - 1U);
+	}
+
+	void SceneGeometry::clear()
+	{
+		vertices_.clear();
+		indices_.clear();
+		submeshes_.clear();
+		models_.clear();
+		bounds_ = emptyBounds();
+		vertexCount_ = 0U;
+		indexCount_ = 0U;
+		resident_ = true;
+	}
+
+	void SceneGeometry::releaseGeometry()
+	{
+		// Swapping with empty vectors returns the capacity, which clear()
+		// would keep.
+		TrackedVector<Vertex, MemoryTag::Renderer>().swap(vertices_);
+		TrackedVector<uint32_t, MemoryTag::Renderer>().swap(indices_);
+		resident_ = false;
+	}
+
+} // namespace scop
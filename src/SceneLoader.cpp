@@ -0,0 +1,192 @@
+#include "SceneLoader.hpp"
+
+#include "ObjLoader.hpp"
+#include "Profiler.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace scop
+{
+	namespace
+	{
+
+		constexpr float kDegreesToRadians = 3.14159265358979323846f / 180.0f;
+
+		// Interns normalized paths so every distinct file gets one index.
+		class PathTable
+		{
+		public:
+			explicit PathTable(std::vector<std::string> &paths)
+				: paths_(paths) {}
+
+			uint32_t intern(const std::filesystem::path &path)
+			{
+				const std::string key = path.lexically_normal().string();
+				const auto found = indices_.find(key);
+				if (found != indices_.end())
+				{
+					return found->second;
+				}
+				const uint32_t index = static_cast<uint32_t>(paths_.size());
+				paths_.push_back(key);
+				indices_.emplace(key, index);
+				return index;
+			}
+
+		private:
+			std::vector<std::string> &paths_;
+			std::unordered_map<std::string, uint32_t> indices_;
+		};
+
+		bool parseFloat(const std::string &token, float &value)
+		{
+			char *end = nullptr;
+			value = std::strtof(token.c_str(), &end);
+			return !token.empty() && end == token.c_str() + token.size() && std::isfinite(value);
+		}
+
+		std::string location(const std::string &path, std::size_t line)
+		{
+			return path + ":" + std::to_string(line);
+		}
+
+	} // namespace
+
+	SceneDescription SceneLoader::parse(const std::string &path)
+	{
+		SCOP_PROFILE_FUNCTION();
+		const auto begin = std::chrono::steady_clock::now();
+		std::ifstream file(path.c_str());
+		if (!file)
+		{
+			throw std::runtime_error("Failed to open scene file: " + path);
+		}
+
+		SceneDescription scene;
+		scene.assetReferences = 0U;
+		PathTable models(scene.modelPaths);
+		PathTable textures(scene.texturePaths);
+		const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+
+		std::string line;
+		std::size_t lineNumber = 0U;
+		while (std::getline(file, line))
+		{
+			++lineNumber;
+			const std::size_t comment = line.find('#');
+			if (comment != std::string::npos)
+			{
+				line.erase(comment);
+			}
+
+			std::istringstream stream(line);
+			std::vector<std::string> tokens;
+			std::string token;
+			while (stream >> token)
+			{
+				tokens.push_back(token);
+			}
+			if (tokens.empty())
+			{
+				continue;
+			}
+			if (tokens.size() < 4U || tokens.size() > 6U)
+			{
+				throw std::runtime_error(location(path, lineNumber) + ": expected <model.obj> <x> <y> <z> [yaw] [texture.ppm]");
+			}
+
+			ScenePlacement placement;
+			float coordinates[3];
+			for (std::size_t axis = 0U; axis < 3U; ++axis)
+			{
+				if (!parseFloat(tokens[axis + 1U], coordinates[axis]))
+				{
+					throw std::runtime_error(location(path, lineNumber) + ": invalid coordinate '" + tokens[axis + 1U] + "'");
+				}
+			}
+			placement.position = Vec3(coordinates[0], coordinates[1], coordinates[2]);
+			placement.yaw = 0.0f;
+			placement.texture = kNoTexture;
+
+			std::size_t next = 4U;
+			float yawDegrees = 0.0f;
+			if (next < tokens.size() && parseFloat(tokens[next], yawDegrees))
+			{
+				placement.yaw = yawDegrees * kDegreesToRadians;
+				++next;
+			}
+			if (next < tokens.size())
+			{
+				placement.texture = textures.intern(directory / tokens[next]);
+				++scene.assetReferences;
+				++next;
+			}
+			if (next != tokens.size())
+			{
+				throw std::runtime_error(location(path, lineNumber) + ": unexpected '" + tokens[next] + "'");
+			}
+
+			placement.model = models.intern(directory / tokens[0]);
+			++scene.assetReferences;
+			scene.placements.push_back(placement);
+		}
+
+		if (scene.placements.empty())
+		{
+			throw std::runtime_error("Scene file places no models: " + path);
+		}
+		scene.parseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		return scene;
+	}
+
+	SceneAssets SceneLoader::loadAssets(const SceneDescription &scene, ThreadPool &pool)
+	{
+		SCOP_PROFILE_FUNCTION();
+		const auto begin = std::chrono::steady_clock::now();
+		SceneAssets assets;
+		assets.models.resize(scene.modelPaths.size());
+		assets.textures.resize(scene.texturePaths.size());
+
+		// One job per distinct file; every job writes only its own slot.
+		const std::size_t modelCount = scene.modelPaths.size();
+		pool.parallelFor(modelCount + scene.texturePaths.size(), 1U,
+						 [&scene, &assets, modelCount](std::size_t first, std::size_t end)
+						 {
+							 for (std::size_t job = first; job < end; ++job)
+							 {
+								 if (job < modelCount)
+								 {
+									 assets.models[job] = ObjLoader::loadGroupsFromFile(scene.modelPaths[job]);
+								 }
+								 else
+								 {
+									 assets.textures[job - modelCount] = TextureLoader::loadPPM(scene.texturePaths[job - modelCount]);
+								 }
+							 }
+						 });
+
+		assets.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		return assets;
+	}
+
+	void SceneLoader::printStats(std::ostream &out, const SceneDescription &scene, const SceneAssets &assets, std::size_t threads)
+	{
+		const std::size_t unique = scene.modelPaths.size() + scene.texturePaths.size();
+		const double hitRate = (scene.assetReferences > 0U)
+								   ? 100.0 * static_cast<double>(scene.assetReferences - unique) / static_cast<double>(scene.assetReferences)
+								   : 0.0;
+		out << "Scene file: " << scene.placements.size() << " placements parsed in " << scene.parseMs << " ms; "
+			<< scene.assetReferences << " asset references -> " << scene.modelPaths.size() << " model(s) + "
+			<< scene.texturePaths.size() << " texture(s), " << hitRate << "% cache hits; loaded in "
+			<< assets.loadMs << " ms on " << threads << " thread(s)" << std::endl;
+	}
+
+} // namespace scop
@@ -0,0 +1,278 @@
+#include "Simulation.hpp"
+
+#include <algorithm>
+
+namespace scop
+{
+	namespace
+	{
+
+		constexpr float kMoveSpeed = 1.8f;
+		constexpr float kBlendSpeed = 2.5f;
+		// Further behind than this, the tick clock restarts instead of
+		// running a burst of catch-up ticks.
+		constexpr int kMaxLagSteps = 4;
+
+		float lerp(float a, float b, float t)
+		{
+			return a + (b - a) * t;
+		}
+
+		// The fields sample() interpolates.
+		bool drawsSame(const SimulationState &a, const SimulationState &b)
+		{
+			return a.translation.x == b.translation.x && a.translation.y == b.translation.y &&
+				   a.translation.z == b.translation.z && a.rotationAngle == b.rotationAngle &&
+				   a.textureBlend == b.textureBlend && a.instanceTime == b.instanceTime;
+		}
+
+		Simulation::Clock::duration stepDuration()
+		{
+			return std::chrono::duration_cast<Simulation::Clock::duration>(
+				std::chrono::duration<float>(Simulation::kStepSeconds));
+		}
+
+	} // namespace
+
+	bool SimulationInput::active() const
+	{
+		return left || right || up || down || forward || backward ||
+			   togglePresses > 0U || pausePresses > 0U || resetPresses > 0U;
+	}
+
+	Simulation::Simulation()
+		: state_{},
+		  settings_{},
+		  pendingInput_{},
+		  inputSerial_(0U),
+		  consumedSerial_(0U),
+		  readerSerial_(0U),
+		  stopping_(false) {}
+
+	Simulation::~Simulation()
+	{
+		stop();
+	}
+
+	void Simulation::reset(const SimulationState &state, const SimulationSettings &settings)
+	{
+		stop();
+		state_ = state;
+		settings_ = settings;
+		pendingInput_ = SimulationInput{};
+		inputSerial_ = 0U;
+		consumedSerial_ = 0U;
+		readerSerial_ = 0U;
+		publish(state_, Clock::now());
+	}
+
+	void Simulation::start()
+	{
+		if (thread_.joinable())
+		{
+			return;
+		}
+		stopping_ = false;
+		thread_ = std::thread(&Simulation::run, this);
+	}
+
+	void Simulation::stop()
+	{
+		if (!thread_.joinable())
+		{
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(inputMutex_);
+			stopping_ = true;
+		}
+		wake_.notify_one();
+		thread_.join();
+	}
+
+	void Simulation::submitInput(const SimulationInput &input)
+	{
+		const bool active = input.active();
+		{
+			std::lock_guard<std::mutex> lock(inputMutex_);
+			pendingInput_.left = input.left;
+			pendingInput_.right = input.right;
+			pendingInput_.up = input.up;
+			pendingInput_.down = input.down;
+			pendingInput_.forward = input.forward;
+			pendingInput_.backward = input.backward;
+			pendingInput_.togglePresses += input.togglePresses;
+			pendingInput_.pausePresses += input.pausePresses;
+			pendingInput_.resetPresses += input.resetPresses;
+			if (active)
+			{
+				++inputSerial_;
+				readerSerial_ = inputSerial_;
+			}
+		}
+		if (active)
+		{
+			wake_.notify_one();
+		}
+	}
+
+	void Simulation::advance(float dt)
+	{
+		SimulationInput input;
+		{
+			std::lock_guard<std::mutex> lock(inputMutex_);
+			input = takeInput();
+		}
+		tick(state_, settings_, input, dt);
+		publish(state_, Clock::now());
+	}
+
+	void Simulation::setPose(const Vec3 &translation, float rotationAngle)
+	{
+		state_.translation = translation;
+		state_.rotationAngle = rotationAngle;
+		state_.rotationPaused = true;
+		publish(state_, Clock::now());
+	}
+
+	SimulationFrame Simulation::sample(Clock::time_point now)
+	{
+		const Snapshot &snapshot = snapshots_.read();
+		const float elapsed = std::chrono::duration<float>(now - snapshot.time).count();
+		const float t = std::clamp(elapsed / kStepSeconds, 0.0f, 1.0f);
+
+		SimulationFrame frame;
+		frame.state = snapshot.current;
+		frame.state.translation = snapshot.previous.translation + (snapshot.current.translation - snapshot.previous.translation) * t;
+		frame.state.rotationAngle = lerp(snapshot.previous.rotationAngle, snapshot.current.rotationAngle, t);
+		frame.state.textureBlend = lerp(snapshot.previous.textureBlend, snapshot.current.textureBlend, t);
+		frame.state.instanceTime = lerp(snapshot.previous.instanceTime, snapshot.current.instanceTime, t);
+		// The tick that comes to rest still blends from the state before it;
+		// only its end point, or a snapshot without a blend, is final.
+		frame.settled = snapshot.atRest && snapshot.inputSerial == readerSerial_ && (snapshot.still || t >= 1.0f);
+		return frame;
+	}
+
+	void Simulation::tick(SimulationState &state, const SimulationSettings &settings, const SimulationInput &input, float dt)
+	{
+		for (uint32_t i = 0U; i < input.togglePresses; ++i)
+		{
+			if (settings.canBlend)
+			{
+				state.textureEnabled = !state.textureEnabled;
+				state.targetTextureBlend = state.textureEnabled ? 1.0f : 0.0f;
+			}
+			else
+			{
+				state.textureEnabled = false;
+				state.textureBlend = 0.0f;
+				state.targetTextureBlend = 0.0f;
+			}
+		}
+		if ((input.pausePresses & 1U) != 0U)
+		{
+			state.rotationPaused = !state.rotationPaused;
+		}
+		if (input.resetPresses > 0U)
+		{
+			state.translation = Vec3(0.0f, 0.0f, 0.0f);
+			state.rotationAngle = 0.0f;
+			state.targetTextureBlend = state.textureEnabled && settings.hasTexture ? 1.0f : 0.0f;
+		}
+
+		const float move = kMoveSpeed * dt;
+		state.translation.x += (input.right ? move : 0.0f) - (input.left ? move : 0.0f);
+		state.translation.y += (input.up ? move : 0.0f) - (input.down ? move : 0.0f);
+		state.translation.z += (input.forward ? move : 0.0f) - (input.backward ? move : 0.0f);
+
+		if (state.textureBlend < state.targetTextureBlend)
+		{
+			state.textureBlend = std::min(state.textureBlend + kBlendSpeed * dt, state.targetTextureBlend);
+		}
+		else if (state.textureBlend > state.targetTextureBlend)
+		{
+			state.textureBlend = std::max(state.textureBlend - kBlendSpeed * dt, state.targetTextureBlend);
+		}
+
+		if (!state.rotationPaused)
+		{
+			state.rotationAngle += settings.rotationSpeed * dt;
+		}
+		if (!state.rotationPaused || !settings.pauseInstances)
+		{
+			state.instanceTime += dt;
+		}
+	}
+
+	bool Simulation::atRest() const
+	{
+		const SimulationInput &input = pendingInput_;
+		return state_.rotationPaused && settings_.pauseInstances &&
+			   state_.textureBlend == state_.targetTextureBlend && !input.active();
+	}
+
+	SimulationInput Simulation::takeInput()
+	{
+		SimulationInput input = pendingInput_;
+		pendingInput_.togglePresses = 0U;
+		pendingInput_.pausePresses = 0U;
+		pendingInput_.resetPresses = 0U;
+		consumedSerial_ = inputSerial_;
+		return input;
+	}
+
+	void Simulation::publish(const SimulationState &previous, Clock::time_point time)
+	{
+		Snapshot &snapshot = snapshots_.back();
+		snapshot.previous = previous;
+		snapshot.current = state_;
+		snapshot.time = time;
+		snapshot.inputSerial = consumedSerial_;
+		snapshot.atRest = atRest();
+		snapshot.still = drawsSame(previous, state_);
+		snapshots_.publish();
+	}
+
+	void Simulation::run()
+	{
+		const Clock::duration step = stepDuration();
+		Clock::time_point next = Clock::now();
+		while (true)
+		{
+			SimulationInput input;
+			{
+				std::unique_lock<std::mutex> lock(inputMutex_);
+				if (!stopping_ && atRest())
+				{
+					// Nothing can change until input arrives: publish the
+					// final state once and sleep instead of ticking.
+					publish(state_, Clock::now());
+					wake_.wait(lock, [this]
+							   { return stopping_ || !atRest(); });
+					next = Clock::now();
+				}
+				if (stopping_)
+				{
+					return;
+				}
+				input = takeInput();
+			}
+
+			const SimulationState previous = state_;
+			tick(state_, settings_, input, kStepSeconds);
+			{
+				std::lock_guard<std::mutex> lock(inputMutex_);
+				publish(previous, next);
+			}
+
+			next += step;
+			const Clock::time_point now = Clock::now();
+			if (now - next > step * kMaxLagSteps)
+			{
+				next = now;
+			}
+			std::this_thread::sleep_until(next);
+		}
+	}
+
+} // namespace scop
@@ -0,0 +1,500 @@
+#include "SoftwareApp.hpp"
+
+#include "FileUtils.hpp"
+#include "FrameLimiter.hpp"
+#include "FrameStats.hpp"
+#include "MemoryTracker.hpp"
+#include "ObjLoader.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace scop
+{
+	namespace
+	{
+		// Match the Vulkan viewer's layout and framing in App.cpp.
+		constexpr float kInstanceSpacing = 2.0f;
+		constexpr float kModelSpacing = 2.0f;
+
+		// GL_RGBA and GL_UNSIGNED_BYTE, without pulling in a GL header.
+		constexpr unsigned int kGlRgba = 0x1908U;
+		constexpr unsigned int kGlUnsignedByte = 0x1401U;
+
+		template <typename Function>
+		Function loadGlFunction(const char *name)
+		{
+			const GLFWglproc proc = glfwGetProcAddress(name);
+			if (proc == nullptr)
+			{
+				throw std::runtime_error(std::string("OpenGL function ") + name + " is not available");
+			}
+			return reinterpret_cast<Function>(proc);
+		}
+
+	} // namespace
+
+	SoftwareApp::SoftwareApp(const AppOptions &options)
+		: options_(options),
+		  window_(nullptr),
+		  gl_{},
+		  rasterizer_(nullptr),
+		  width_(options.width != 0U ? options.width : WIDTH),
+		  height_(options.height != 0U ? options.height : HEIGHT),
+		  hasRealTexture_(false),
+		  hasMaterial_(false),
+		  materialKd_(0.64f, 0.64f, 0.64f),
+		  materialKs_(0.50f, 0.50f, 0.50f),
+		  materialNs_(96.078431f),
+		  frameState_{},
+		  fieldExtent_(0.0f),
+		  prevEscape_(false),
+		  prevT_(false),
+		  prevSpace_(false),
+		  prevR_(false)
+	{
+		// 1 keeps every pass on the calling thread; otherwise the caller is
+		// the last of the raster threads.
+		if (options_.rasterThreads != 1U)
+		{
+			threadPool_.emplace(options_.rasterThreads == 0U ? 0U : options_.rasterThreads - 1U);
+			rasterizer_ = SoftwareRasterizer(&*threadPool_);
+		}
+	}
+
+	SoftwareApp::~SoftwareApp()
+	{
+		try
+		{
+			cleanup();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void SoftwareApp::run(const std::vector<std::string> &modelPaths, const std::string &texturePath)
+	{
+		const auto startupBegin = std::chrono::steady_clock::now();
+		MemoryTracker::setHostBudget(options_.hostBudgetMiB * 1024U * 1024U);
+		if (!headless())
+		{
+			initWindow();
+		}
+		loadAssets(modelPaths, texturePath);
+		// Encoded like the sRGB swapchain and offscreen target of the Vulkan
+		// backend, in the window and in headless frames alike.
+		rasterizer_.resize(width_, height_, true);
+		rasterizer_.setTexture(textureData_);
+		updateProjection();
+		const double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin).count();
+		std::cout << "Startup: " << startupMs << " ms (software backend, "
+				  << (threadPool_ ? threadPool_->workerCount() + 1U : 1U) << " raster thread(s))" << std::endl;
+		MemoryTracker::printStats(std::cout);
+
+		if (headless())
+		{
+			renderHeadless();
+		}
+		else
+		{
+			mainLoop();
+		}
+		cleanup();
+	}
+
+	void SoftwareApp::initWindow()
+	{
+		if (glfwInit() != GLFW_TRUE)
+		{
+			throw std::runtime_error("glfwInit failed");
+		}
+
+		// A legacy context is enough to blit the finished frame.
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+
+		window_ = glfwCreateWindow(
+			static_cast<int>(width_),
+			static_cast<int>(height_),
+			"scop - software OBJ viewer",
+			nullptr,
+			nullptr);
+
+		if (window_ == nullptr)
+		{
+			glfwTerminate();
+			throw std::runtime_error("glfwCreateWindow failed");
+		}
+
+		glfwMakeContextCurrent(window_);
+		glfwSwapInterval(swapInterval());
+
+		gl_.viewport = loadGlFunction<decltype(gl_.viewport)>("glViewport");
+		gl_.rasterPos2f = loadGlFunction<decltype(gl_.rasterPos2f)>("glRasterPos2f");
+		gl_.pixelZoom = loadGlFunction<decltype(gl_.pixelZoom)>("glPixelZoom");
+		gl_.drawPixels = loadGlFunction<decltype(gl_.drawPixels)>("glDrawPixels");
+
+		int width = 0;
+		int height = 0;
+		glfwGetFramebufferSize(window_, &width, &height);
+		width_ = static_cast<uint32_t>(std::max(width, 1));
+		height_ = static_cast<uint32_t>(std::max(height, 1));
+	}
+
+	void SoftwareApp::loadAssets(const std::vector<std::string> &modelPaths, const std::string &texturePath)
+	{
+		SCOP_PROFILE_FUNCTION();
+		for (std::size_t i = 0; i < modelPaths.size(); ++i)
+		{
+			const float offset = kModelSpacing * (static_cast<float>(i) - 0.5f * static_cast<float>(modelPaths.size() - 1U));
+			scene_.addModel(ObjLoader::loadGroupsFromFile(modelPaths[i]), Vec3(offset, 0.0f, 0.0f));
+		}
+		std::cout << "Scene: " << scene_.modelCount() << " model(s), " << scene_.submeshes().size() << " submesh(es), "
+				  << scene_.vertexCount() << " vertices, " << scene_.indexCount() / 3U << " triangles" << std::endl;
+
+		// The rasterizer takes one index list into the whole vertex array.
+		indices_.resize(scene_.indexCount());
+		for (const Submesh &submesh : scene_.submeshes())
+		{
+			for (uint32_t i = 0; i < submesh.indexCount; ++i)
+			{
+				indices_[submesh.firstIndex + i] =
+					static_cast<uint32_t>(static_cast<int64_t>(scene_.indices()[submesh.firstIndex + i]) + submesh.vertexOffset);
+			}
+		}
+
+		const ObjMaterial parsed = ObjLoader::loadMaterial(modelPaths.front());
+		hasMaterial_ = parsed.valid;
+		materialKd_ = parsed.kd;
+		materialKs_ = parsed.ks;
+		materialNs_ = parsed.ns;
+
+		if (texturePath.empty())
+		{
+			textureData_ = TextureLoader::makeFallbackCheckerboard();
+			hasRealTexture_ = false;
+		}
+		else
+		{
+			try
+			{
+				textureData_ = TextureLoader::loadPPM(texturePath);
+				hasRealTexture_ = !textureData_.empty();
+			}
+			catch (const std::exception &e)
+			{
+				std::cerr << "Warning: " << e.what() << "\nUsing fallback checkerboard texture instead.\n";
+				textureData_ = TextureLoader::makeFallbackCheckerboard();
+				hasRealTexture_ = false;
+			}
+		}
+
+		const Bounds &bounds = scene_.bounds();
+		fieldExtent_ = std::max(kInstanceSpacing, std::max(bounds.max.x - bounds.min.x, bounds.max.z - bounds.min.z) + 0.4f);
+
+		frameState_ = SimulationState{};
+		frameState_.translation = Vec3(0.0f, 0.0f, 0.0f);
+		frameState_.textureEnabled = hasRealTexture_;
+		frameState_.textureBlend = hasRealTexture_ ? 1.0f : 0.0f;
+		frameState_.targetTextureBlend = frameState_.textureBlend;
+
+		SimulationSettings settings;
+		settings.rotationSpeed = 0.85f;
+		settings.canBlend = hasRealTexture_ || hasMaterial_;
+		settings.hasTexture = !textureData_.empty();
+		settings.pauseInstances = true;
+		simulation_.reset(frameState_, settings);
+	}
+
+	void SoftwareApp::mainLoop()
+	{
+		bool running = true;
+		FrameLimiter limiter(options_.targetFps);
+		FrameStats stats(5.0);
+
+		std::cout << "Software backend: " << width_ << "x" << height_
+				  << ", frame cap: " << (limiter.enabled() ? std::to_string(static_cast<int>(options_.targetFps)) + " fps" : std::string("off"))
+				  << ", swap interval: " << swapInterval()
+				  << ", raster threads: " << (threadPool_ ? threadPool_->workerCount() + 1U : 1U)
+				  << std::endl;
+
+		simulation_.start();
+		auto previous = std::chrono::high_resolution_clock::now();
+		auto lastTitleUpdate = previous;
+
+		while (running)
+		{
+			SCOP_PROFILE_ZONE("Frame");
+			{
+				SCOP_PROFILE_ZONE("Frame limiter");
+				limiter.wait();
+			}
+
+			auto current = std::chrono::high_resolution_clock::now();
+			const float dt = std::chrono::duration<float>(current - previous).count();
+			previous = current;
+
+			stats.addFrame(static_cast<double>(dt) * 1000.0);
+			if (stats.reportDue())
+			{
+				stats.report(std::cout);
+				std::cout << "Raster: " << rasterSummary() << std::endl;
+			}
+			if (current - lastTitleUpdate >= std::chrono::milliseconds(500))
+			{
+				const std::string title = "scop - software OBJ viewer | " + rasterSummary();
+				glfwSetWindowTitle(window_, title.c_str());
+				lastTitleUpdate = current;
+			}
+
+			processEvents(running);
+
+			int width = 0;
+			int height = 0;
+			glfwGetFramebufferSize(window_, &width, &height);
+			while (running && (width == 0 || height == 0))
+			{
+				glfwWaitEvents();
+				glfwGetFramebufferSize(window_, &width, &height);
+				running = glfwWindowShouldClose(window_) == GLFW_FALSE;
+			}
+			if (static_cast<uint32_t>(width) != width_ || static_cast<uint32_t>(height) != height_)
+			{
+				width_ = static_cast<uint32_t>(width);
+				height_ = static_cast<uint32_t>(height);
+				rasterizer_.resize(width_, height_, true);
+				updateProjection();
+			}
+
+			renderFrame(dt);
+			present();
+		}
+
+		simulation_.stop();
+		stats.printSummary(std::cout);
+	}
+
+	void SoftwareApp::renderHeadless()
+	{
+		// Fixed timestep so the rotation, and therefore every dumped frame,
+		// is identical from run to run.
+		const float dt = 1.0f / 60.0f;
+		FrameStats stats(5.0);
+		if (!options_.dumpFramesDir.empty())
+		{
+			std::filesystem::create_directories(options_.dumpFramesDir);
+		}
+
+		std::cout << "Headless: " << options_.headlessFrames << " frames at " << width_ << "x" << height_
+				  << " on the software backend"
+				  << ", frame dump: " << (options_.dumpFramesDir.empty() ? std::string("off") : options_.dumpFramesDir)
+				  << std::endl;
+
+		const auto begin = std::chrono::steady_clock::now();
+		auto previous = begin;
+		std::size_t triangles = 0U;
+		for (std::size_t frame = 0; frame < options_.headlessFrames; ++frame)
+		{
+			SCOP_PROFILE_ZONE("Headless frame");
+			renderFrame(dt);
+			triangles += rasterizer_.stats().triangles;
+			if (!options_.dumpFramesDir.empty())
+			{
+				writeFrame(frame);
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+			stats.addFrame(std::chrono::duration<double, std::milli>(now - previous).count());
+			previous = now;
+			if (stats.reportDue())
+			{
+				stats.report(std::cout);
+				std::cout << "Raster: " << rasterSummary() << std::endl;
+			}
+		}
+
+		const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		std::cout << "Headless: rendered " << options_.headlessFrames << " frames in " << totalMs << " ms ("
+				  << static_cast<double>(options_.headlessFrames) * 1000.0 / totalMs << " fps, "
+				  << static_cast<double>(triangles) / (totalMs * 1000.0) << " Mtri/s)" << std::endl;
+		stats.printSummary(std::cout);
+		std::cout << "Raster: " << rasterSummary() << std::endl;
+	}
+
+	void SoftwareApp::processEvents(bool &running)
+	{
+		SCOP_PROFILE_FUNCTION();
+		glfwPollEvents();
+
+		if (glfwWindowShouldClose(window_))
+		{
+			running = false;
+		}
+
+		const bool escNow = (glfwGetKey(window_, GLFW_KEY_ESCAPE) == GLFW_PRESS);
+		const bool tNow = (glfwGetKey(window_, GLFW_KEY_T) == GLFW_PRESS);
+		const bool spaceNow = (glfwGetKey(window_, GLFW_KEY_SPACE) == GLFW_PRESS);
+		const bool rNow = (glfwGetKey(window_, GLFW_KEY_R) == GLFW_PRESS);
+
+		if (escNow && !prevEscape_)
+		{
+			running = false;
+		}
+
+		SimulationInput input{};
+		input.togglePresses = (tNow && !prevT_) ? 1U : 0U;
+		input.pausePresses = (spaceNow && !prevSpace_) ? 1U : 0U;
+		input.resetPresses = (rNow && !prevR_) ? 1U : 0U;
+		input.left = glfwGetKey(window_, GLFW_KEY_LEFT) == GLFW_PRESS;
+		input.right = glfwGetKey(window_, GLFW_KEY_RIGHT) == GLFW_PRESS;
+		input.up = glfwGetKey(window_, GLFW_KEY_UP) == GLFW_PRESS;
+		input.down = glfwGetKey(window_, GLFW_KEY_DOWN) == GLFW_PRESS;
+		input.forward = glfwGetKey(window_, GLFW_KEY_PAGE_UP) == GLFW_PRESS || glfwGetKey(window_, GLFW_KEY_Q) == GLFW_PRESS;
+		input.backward = glfwGetKey(window_, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS || glfwGetKey(window_, GLFW_KEY_E) == GLFW_PRESS;
+		simulation_.submitInput(input);
+
+		prevEscape_ = escNow;
+		prevT_ = tNow;
+		prevSpace_ = spaceNow;
+		prevR_ = rNow;
+	}
+
+	void SoftwareApp::renderFrame(float dt)
+	{
+		SCOP_PROFILE_FUNCTION();
+		if (!simulation_.threaded())
+		{
+			simulation_.advance(dt);
+		}
+		frameState_ = simulation_.sample(Simulation::Clock::now()).state;
+
+		const Mat4 model = Mat4::translation(frameState_.translation) * Mat4::rotationY(frameState_.rotationAngle);
+		RasterUniforms uniforms;
+		uniforms.mvp = viewProjection_ * model;
+		uniforms.normalMatrix = normalMatrix(model);
+		uniforms.blend = frameState_.textureBlend;
+		uniforms.kd = materialKd_;
+		uniforms.ks = materialKs_;
+		uniforms.ns = materialNs_;
+
+		// The same choice ScopApp makes between its pipeline variants.
+		switch (options_.shading)
+		{
+		case ShadingMode::Plain:
+			uniforms.textured = false;
+			uniforms.material = false;
+			break;
+		case ShadingMode::Material:
+			uniforms.textured = false;
+			uniforms.material = true;
+			break;
+		case ShadingMode::Textured:
+			uniforms.textured = true;
+			uniforms.material = hasMaterial_;
+			break;
+		default:
+			uniforms.textured = hasRealTexture_;
+			uniforms.material = hasMaterial_;
+			break;
+		}
+
+		RasterMesh mesh;
+		mesh.vertices = scene_.vertices().data();
+		mesh.vertexCount = scene_.vertices().size();
+		mesh.indices = indices_.data();
+		mesh.indexCount = indices_.size();
+		rasterizer_.render(mesh, uniforms);
+	}
+
+	void SoftwareApp::present()
+	{
+		SCOP_PROFILE_FUNCTION();
+		// Rows are stored top to bottom; GL draws upwards from the raster
+		// position, so start at the top-left corner and flip the zoom.
+		gl_.viewport(0, 0, static_cast<int>(width_), static_cast<int>(height_));
+		gl_.rasterPos2f(-1.0f, 1.0f);
+		gl_.pixelZoom(1.0f, -1.0f);
+		gl_.drawPixels(static_cast<int>(rasterizer_.width()), static_cast<int>(rasterizer_.height()), kGlRgba, kGlUnsignedByte,
+					   rasterizer_.pixels().data());
+		glfwSwapBuffers(window_);
+	}
+
+	void SoftwareApp::writeFrame(std::size_t frame) const
+	{
+		SCOP_PROFILE_FUNCTION();
+		const std::size_t pixelCount = static_cast<std::size_t>(rasterizer_.width()) * rasterizer_.height();
+		const std::string header = "P6\n" + std::to_string(rasterizer_.width()) + " " +
+								   std::to_string(rasterizer_.height()) + "\n255\n";
+		std::vector<std::uint8_t> ppm(header.begin(), header.end());
+		ppm.resize(header.size() + pixelCount * 3U);
+
+		const std::uint8_t *rgba = rasterizer_.pixels().data();
+		std::uint8_t *rgb = ppm.data() + header.size();
+		for (std::size_t i = 0; i < pixelCount; ++i)
+		{
+			rgb[i * 3U + 0U] = rgba[i * 4U + 0U];
+			rgb[i * 3U + 1U] = rgba[i * 4U + 1U];
+			rgb[i * 3U + 2U] = rgba[i * 4U + 2U];
+		}
+
+		std::ostringstream name;
+		name << options_.dumpFramesDir << "/frame_" << std::setw(4) << std::setfill('0') << frame << ".ppm";
+		writeBinaryFile(name.str(), ppm.data(), ppm.size());
+	}
+
+	void SoftwareApp::updateProjection()
+	{
+		// Same framing as ScopApp::updateProjection.
+		Mat4 view = Mat4::translation(Vec3(0.0f, 0.0f, -3.0f));
+		float farPlane = 100.0f;
+		if (fieldExtent_ > kInstanceSpacing)
+		{
+			const float distance = 3.0f + fieldExtent_ * 0.9f;
+			view = Mat4::lookAt(Vec3(0.0f, distance * 0.6f, distance), Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f));
+			farPlane = std::max(farPlane, distance * 2.0f + fieldExtent_);
+		}
+		Mat4 proj = Mat4::perspective(45.0f, static_cast<float>(width_) / static_cast<float>(height_), 0.1f, farPlane);
+		proj(1, 1) *= -1.0f;
+		viewProjection_ = proj * view;
+	}
+
+	int SoftwareApp::swapInterval() const
+	{
+		// Without a swapchain the FIFO modes map to vsync and the others to
+		// presenting as soon as the frame is done.
+		const bool vsync = options_.presentMode.has_value() &&
+						   (*options_.presentMode == VK_PRESENT_MODE_FIFO_KHR || *options_.presentMode == VK_PRESENT_MODE_FIFO_RELAXED_KHR);
+		return vsync ? 1 : 0;
+	}
+
+	std::string SoftwareApp::rasterSummary() const
+	{
+		const RasterStats &stats = rasterizer_.stats();
+		const double frameMs = stats.vertexMs + stats.binMs + stats.rasterMs;
+		std::ostringstream out;
+		out << std::fixed << std::setprecision(2) << frameMs << " ms (vertex " << stats.vertexMs << ", bin "
+			<< stats.binMs << ", raster " << stats.rasterMs << "), "
+			<< (frameMs > 0.0 ? static_cast<double>(stats.triangles) / (frameMs * 1000.0) : 0.0) << " Mtri/s, "
+			<< stats.setupTriangles << " set up, " << stats.binnedTriangles << " binned";
+		return out.str();
+	}
+
+	void SoftwareApp::cleanup()
+	{
+		simulation_.stop();
+		if (window_ != nullptr)
+		{
+			glfwDestroyWindow(window_);
+			window_ = nullptr;
+			glfwTerminate();
+		}
+	}
+
+} // namespace scop
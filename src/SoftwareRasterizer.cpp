@@ -0,0 +1,696 @@
+#include "SoftwareRasterizer.hpp"
+
+#include "Profiler.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// Coverage and depth run 4 pixels at a time where SSE2 is guaranteed
+// (every x86-64 target); elsewhere the same integer and float operations
+// run one pixel at a time.
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SCOP_RASTER_SSE 1
+#endif
+
+namespace scop
+{
+	namespace
+	{
+
+		constexpr int32_t kSubpixelScale = 16;
+		constexpr int32_t kHalfPixel = kSubpixelScale / 2;
+		constexpr std::size_t kVertexGrain = 4096U;
+		// Clipping turns one triangle into at most six, so a triangle's index
+		// in its chunk fits the low 16 bits of a pixel id.
+		constexpr std::size_t kSetupGrain = 2048U;
+		constexpr std::size_t kMaxChunks = 0xFFFFU;
+		constexpr uint32_t kNoTriangle = 0xFFFFFFFFU;
+		// Clipping keeps screen positions within this many pixels of the
+		// origin: edge steps are then below 2^23 per pixel, and an edge that
+		// crosses a tile stays within 32 bits across it.
+		constexpr float kGuardPixels = 16384.0f;
+		// Clear colour of the Vulkan render pass.
+		constexpr Vec3 kClearColor(0.06f, 0.06f, 0.08f);
+		constexpr std::size_t kEncodeSteps = 4096U;
+
+		struct ClipVertex
+		{
+			Vec4 position;
+			Vec2 uv;
+			Vec3 normal;
+		};
+
+		ClipVertex lerp(const ClipVertex &a, const ClipVertex &b, float t)
+		{
+			ClipVertex result;
+			result.position = Vec4(a.position.x + (b.position.x - a.position.x) * t,
+								   a.position.y + (b.position.y - a.position.y) * t,
+								   a.position.z + (b.position.z - a.position.z) * t,
+								   a.position.w + (b.position.w - a.position.w) * t);
+			result.uv = a.uv + (b.uv - a.uv) * t;
+			result.normal = a.normal + (b.normal - a.normal) * t;
+			return result;
+		}
+
+		// Sutherland-Hodgman against one plane; distance >= 0 is inside.
+		template <typename Distance>
+		std::size_t clipPolygon(const ClipVertex *input, std::size_t count, ClipVertex *output, Distance distance)
+		{
+			std::size_t written = 0U;
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const ClipVertex &current = input[i];
+				const ClipVertex &next = input[(i + 1U) % count];
+				const float currentDistance = distance(current.position);
+				const float nextDistance = distance(next.position);
+				if (currentDistance >= 0.0f)
+				{
+					output[written++] = current;
+				}
+				if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+				{
+					output[written++] = lerp(current, next, currentDistance / (currentDistance - nextDistance));
+				}
+			}
+			return written;
+		}
+
+		int32_t floorDiv(int32_t value, int32_t divisor)
+		{
+			return (value >= 0) ? value / divisor : -((-value + divisor - 1) / divisor);
+		}
+
+		int32_t ceilDiv(int32_t value, int32_t divisor)
+		{
+			return -floorDiv(-value, divisor);
+		}
+
+		float srgbToLinear(float value)
+		{
+			return (value <= 0.04045f) ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+
+		float linearToSrgb(float value)
+		{
+			return (value <= 0.0031308f) ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		}
+
+		const std::array<float, 256> &srgbDecodeTable()
+		{
+			static const std::array<float, 256> table = []()
+			{
+				std::array<float, 256> values{};
+				for (std::size_t i = 0; i < values.size(); ++i)
+				{
+					values[i] = srgbToLinear(static_cast<float>(i) / 255.0f);
+				}
+				return values;
+			}();
+			return table;
+		}
+
+		const std::array<std::uint8_t, kEncodeSteps> &srgbEncodeTable()
+		{
+			static const std::array<std::uint8_t, kEncodeSteps> table = []()
+			{
+				std::array<std::uint8_t, kEncodeSteps> values{};
+				for (std::size_t i = 0; i < values.size(); ++i)
+				{
+					const float encoded = linearToSrgb(static_cast<float>(i) / static_cast<float>(kEncodeSteps - 1U));
+					values[i] = static_cast<std::uint8_t>(std::clamp(encoded, 0.0f, 1.0f) * 255.0f + 0.5f);
+				}
+				return values;
+			}();
+			return table;
+		}
+
+		std::uint8_t encodeChannel(float value, bool srgb)
+		{
+			const float clamped = std::clamp(value, 0.0f, 1.0f);
+			if (srgb)
+			{
+				return srgbEncodeTable()[static_cast<std::size_t>(clamped * static_cast<float>(kEncodeSteps - 1U) + 0.5f)];
+			}
+			return static_cast<std::uint8_t>(clamped * 255.0f + 0.5f);
+		}
+
+		double elapsedMs(std::chrono::steady_clock::time_point begin)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		}
+
+	} // namespace
+
+	SoftwareRasterizer::SoftwareRasterizer(ThreadPool *pool)
+		: pool_(pool),
+		  width_(0U),
+		  height_(0U),
+		  srgbOutput_(false),
+		  tilesX_(0U),
+		  tilesY_(0U),
+		  guardX_(1.0f),
+		  guardY_(1.0f),
+		  chunkCount_(0U),
+		  textureWidth_(0U),
+		  textureHeight_(0U),
+		  stats_{} {}
+
+	void SoftwareRasterizer::resize(uint32_t width, uint32_t height, bool srgbOutput)
+	{
+		if (width == 0U || height == 0U || static_cast<float>(std::max(width, height)) > kGuardPixels)
+		{
+			throw std::runtime_error("Software rasterizer size must be between 1 and " +
+									 std::to_string(static_cast<int>(kGuardPixels)) + " pixels per side");
+		}
+		width_ = width;
+		height_ = height;
+		srgbOutput_ = srgbOutput;
+		tilesX_ = (width + kTileSize - 1U) / kTileSize;
+		tilesY_ = (height + kTileSize - 1U) / kTileSize;
+		// NDC extent whose screen position lands on +-kGuardPixels.
+		guardX_ = 2.0f * kGuardPixels / static_cast<float>(width) - 1.0f;
+		guardY_ = 2.0f * kGuardPixels / static_cast<float>(height) - 1.0f;
+		pixels_.assign(static_cast<std::size_t>(width) * height * 4U, 0U);
+		for (Chunk &chunk : chunks_)
+		{
+			chunk.bins.assign(static_cast<std::size_t>(tilesX_) * tilesY_, {});
+		}
+	}
+
+	void SoftwareRasterizer::setTexture(const TextureImage &texture)
+	{
+		if (texture.empty())
+		{
+			textureWidth_ = 0U;
+			textureHeight_ = 0U;
+			texels_.clear();
+			return;
+		}
+		// Filtering happens on linear values, as with the Vulkan sRGB image.
+		const std::array<float, 256> &decode = srgbDecodeTable();
+		textureWidth_ = texture.width;
+		textureHeight_ = texture.height;
+		texels_.resize(static_cast<std::size_t>(texture.width) * texture.height * 3U);
+		for (std::size_t i = 0; i < static_cast<std::size_t>(texture.width) * texture.height; ++i)
+		{
+			texels_[i * 3U + 0U] = decode[texture.pixels[i * 4U + 0U]];
+			texels_[i * 3U + 1U] = decode[texture.pixels[i * 4U + 1U]];
+			texels_[i * 3U + 2U] = decode[texture.pixels[i * 4U + 2U]];
+		}
+	}
+
+	void SoftwareRasterizer::runParallel(std::size_t count, std::size_t grain,
+										 const std::function<void(std::size_t, std::size_t)> &body)
+	{
+		if (pool_ != nullptr)
+		{
+			pool_->parallelFor(count, grain, body);
+		}
+		else if (count > 0U)
+		{
+			body(0U, count);
+		}
+	}
+
+	void SoftwareRasterizer::render(const RasterMesh &mesh, const RasterUniforms &uniforms)
+	{
+		SCOP_PROFILE_FUNCTION();
+		if (width_ == 0U)
+		{
+			throw std::runtime_error("Software rasterizer rendered before resize");
+		}
+		stats_ = RasterStats{};
+		stats_.triangles = mesh.indexCount / 3U;
+
+		auto begin = std::chrono::steady_clock::now();
+		clipPositions_.resize(mesh.vertexCount);
+		normals_.resize(mesh.vertexCount);
+		runParallel(mesh.vertexCount, kVertexGrain, [this, &mesh, &uniforms](std::size_t first, std::size_t end)
+		{
+			transformVertices(mesh, uniforms, first, end);
+		});
+		stats_.vertexMs = elapsedMs(begin);
+
+		begin = std::chrono::steady_clock::now();
+		chunkCount_ = (stats_.triangles + kSetupGrain - 1U) / kSetupGrain;
+		if (chunkCount_ > kMaxChunks)
+		{
+			throw std::runtime_error("Software rasterizer supports at most " +
+									 std::to_string(kMaxChunks * kSetupGrain) + " triangles per draw");
+		}
+		if (chunks_.size() < chunkCount_)
+		{
+			const std::size_t previous = chunks_.size();
+			chunks_.resize(chunkCount_);
+			for (std::size_t i = previous; i < chunks_.size(); ++i)
+			{
+				chunks_[i].bins.assign(static_cast<std::size_t>(tilesX_) * tilesY_, {});
+			}
+		}
+		runParallel(stats_.triangles, kSetupGrain, [this, &mesh](std::size_t first, std::size_t end)
+		{
+			for (std::size_t chunkBegin = first; chunkBegin < end; chunkBegin += kSetupGrain)
+			{
+				setupChunk(mesh, chunkBegin / kSetupGrain, chunkBegin, std::min(chunkBegin + kSetupGrain, end));
+			}
+		});
+		for (std::size_t i = 0; i < chunkCount_; ++i)
+		{
+			stats_.setupTriangles += chunks_[i].triangles.size();
+			for (const std::vector<uint32_t> &bin : chunks_[i].bins)
+			{
+				stats_.binnedTriangles += bin.size();
+			}
+		}
+		stats_.binMs = elapsedMs(begin);
+
+		begin = std::chrono::steady_clock::now();
+		runParallel(static_cast<std::size_t>(tilesX_) * tilesY_, 1U, [this, &uniforms](std::size_t first, std::size_t end)
+		{
+			for (std::size_t tile = first; tile < end; ++tile)
+			{
+				rasterizeTile(tile, uniforms);
+			}
+		});
+		stats_.rasterMs = elapsedMs(begin);
+	}
+
+	void SoftwareRasterizer::transformVertices(const RasterMesh &mesh, const RasterUniforms &uniforms,
+											   std::size_t begin, std::size_t end)
+	{
+		const Mat4 &n = uniforms.normalMatrix;
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			const Vertex &vertex = mesh.vertices[i];
+			clipPositions_[i] = uniforms.mvp * Vec4(vertex.position.x, vertex.position.y, vertex.position.z, 1.0f);
+			const Vec3 &normal = vertex.normal;
+			normals_[i] = normalize(Vec3(n(0, 0) * normal.x + n(0, 1) * normal.y + n(0, 2) * normal.z,
+										 n(1, 0) * normal.x + n(1, 1) * normal.y + n(1, 2) * normal.z,
+										 n(2, 0) * normal.x + n(2, 1) * normal.y + n(2, 2) * normal.z));
+		}
+	}
+
+	void SoftwareRasterizer::setupChunk(const RasterMesh &mesh, std::size_t chunkIndex, std::size_t begin, std::size_t end)
+	{
+		Chunk &chunk = chunks_[chunkIndex];
+		chunk.triangles.clear();
+		for (std::vector<uint32_t> &bin : chunk.bins)
+		{
+			bin.clear();
+		}
+
+		const float guardX = guardX_;
+		const float guardY = guardY_;
+		const auto outside = [guardX, guardY](const Vec4 &p)
+		{
+			return p.z < 0.0f || p.x > guardX * p.w || p.x < -guardX * p.w || p.y > guardY * p.w || p.y < -guardY * p.w;
+		};
+
+		// Three corners plus one per clip plane.
+		std::array<ClipVertex, 8> polygon;
+		std::array<ClipVertex, 8> scratch;
+		for (std::size_t triangle = begin; triangle < end; ++triangle)
+		{
+			std::size_t count = 3U;
+			bool valid = true;
+			for (std::size_t corner = 0; corner < 3U; ++corner)
+			{
+				const uint32_t index = mesh.indices[triangle * 3U + corner];
+				if (index >= mesh.vertexCount)
+				{
+					valid = false;
+					break;
+				}
+				polygon[corner].position = clipPositions_[index];
+				polygon[corner].uv = mesh.vertices[index].uv;
+				polygon[corner].normal = normals_[index];
+			}
+			if (!valid)
+			{
+				continue;
+			}
+
+			if (outside(polygon[0].position) || outside(polygon[1].position) || outside(polygon[2].position))
+			{
+				// The near plane (depth 0) keeps w positive; the guard band
+				// bounds the fixed-point range.
+				count = clipPolygon(polygon.data(), count, scratch.data(), [](const Vec4 &p) { return p.z; });
+				count = clipPolygon(scratch.data(), count, polygon.data(), [guardX](const Vec4 &p) { return guardX * p.w - p.x; });
+				count = clipPolygon(polygon.data(), count, scratch.data(), [guardX](const Vec4 &p) { return guardX * p.w + p.x; });
+				count = clipPolygon(scratch.data(), count, polygon.data(), [guardY](const Vec4 &p) { return guardY * p.w - p.y; });
+				count = clipPolygon(polygon.data(), count, scratch.data(), [guardY](const Vec4 &p) { return guardY * p.w + p.y; });
+				std::copy(scratch.begin(), scratch.begin() + static_cast<std::ptrdiff_t>(count), polygon.begin());
+			}
+
+			for (std::size_t fan = 1U; fan + 1U < count; ++fan)
+			{
+				const ClipVertex *corners[3] = {&polygon[0], &polygon[fan], &polygon[fan + 1U]};
+				float screenX[3];
+				float screenY[3];
+				float invW[3];
+				int32_t fixedX[3];
+				int32_t fixedY[3];
+				for (std::size_t k = 0; k < 3U; ++k)
+				{
+					const Vec4 &p = corners[k]->position;
+					invW[k] = 1.0f / p.w;
+					fixedX[k] = static_cast<int32_t>(std::lround((p.x * invW[k] * 0.5f + 0.5f) * static_cast<float>(width_) * kSubpixelScale));
+					fixedY[k] = static_cast<int32_t>(std::lround((p.y * invW[k] * 0.5f + 0.5f) * static_cast<float>(height_) * kSubpixelScale));
+					screenX[k] = static_cast<float>(fixedX[k]) / kSubpixelScale;
+					screenY[k] = static_cast<float>(fixedY[k]) / kSubpixelScale;
+				}
+
+				int64_t area = static_cast<int64_t>(fixedX[1] - fixedX[0]) * (fixedY[2] - fixedY[0]) -
+							   static_cast<int64_t>(fixedY[1] - fixedY[0]) * (fixedX[2] - fixedX[0]);
+				if (area == 0)
+				{
+					continue;
+				}
+				// The pipeline culls nothing, so both windings are drawn.
+				std::array<std::size_t, 3> order = {0U, 1U, 2U};
+				if (area < 0)
+				{
+					std::swap(order[1], order[2]);
+				}
+
+				Triangle setup;
+				const int32_t minFixedX = std::min({fixedX[0], fixedX[1], fixedX[2]});
+				const int32_t maxFixedX = std::max({fixedX[0], fixedX[1], fixedX[2]});
+				const int32_t minFixedY = std::min({fixedY[0], fixedY[1], fixedY[2]});
+				const int32_t maxFixedY = std::max({fixedY[0], fixedY[1], fixedY[2]});
+				setup.minX = std::max(ceilDiv(minFixedX - kHalfPixel, kSubpixelScale), 0);
+				setup.maxX = std::min(floorDiv(maxFixedX - kHalfPixel, kSubpixelScale), static_cast<int32_t>(width_) - 1);
+				setup.minY = std::max(ceilDiv(minFixedY - kHalfPixel, kSubpixelScale), 0);
+				setup.maxY = std::min(floorDiv(maxFixedY - kHalfPixel, kSubpixelScale), static_cast<int32_t>(height_) - 1);
+				if (setup.minX > setup.maxX || setup.minY > setup.maxY)
+				{
+					continue;
+				}
+
+				const int32_t originX = setup.minX * kSubpixelScale + kHalfPixel;
+				const int32_t originY = setup.minY * kSubpixelScale + kHalfPixel;
+				for (std::size_t edge = 0; edge < 3U; ++edge)
+				{
+					const std::size_t a = order[edge];
+					const std::size_t b = order[(edge + 1U) % 3U];
+					const int32_t dx = fixedX[b] - fixedX[a];
+					const int32_t dy = fixedY[b] - fixedY[a];
+					int64_t value = static_cast<int64_t>(dx) * (originY - fixedY[a]) - static_cast<int64_t>(dy) * (originX - fixedX[a]);
+					// Top-left rule: pixels exactly on an edge belong to the
+					// triangle only when the edge is a top or a left one.
+					const bool topLeft = dy < 0 || (dy == 0 && dx > 0);
+					if (!topLeft)
+					{
+						value -= 1;
+					}
+					setup.edgeOrigin[edge] = value;
+					setup.edgeDx[edge] = -dy * kSubpixelScale;
+					setup.edgeDy[edge] = dx * kSubpixelScale;
+				}
+
+				// Attributes are affine in screen space once divided by w.
+				const double x0 = screenX[0];
+				const double y0 = screenY[0];
+				const double ax = screenX[1] - x0;
+				const double ay = screenY[1] - y0;
+				const double bx = screenX[2] - x0;
+				const double by = screenY[2] - y0;
+				const double determinant = ax * by - ay * bx;
+				const double planeOriginX = static_cast<double>(setup.minX) + 0.5 - x0;
+				const double planeOriginY = static_cast<double>(setup.minY) + 0.5 - y0;
+				const auto plane = [&](float f0, float f1, float f2)
+				{
+					const double d1 = static_cast<double>(f1) - f0;
+					const double d2 = static_cast<double>(f2) - f0;
+					const double dx = (d1 * by - d2 * ay) / determinant;
+					const double dy = (d2 * ax - d1 * bx) / determinant;
+					return Plane{static_cast<float>(dx), static_cast<float>(dy),
+								 static_cast<float>(f0 + dx * planeOriginX + dy * planeOriginY)};
+				};
+				const auto perspective = [&](auto value)
+				{
+					return plane(value(*corners[0]) * invW[0], value(*corners[1]) * invW[1], value(*corners[2]) * invW[2]);
+				};
+				setup.depth = perspective([](const ClipVertex &v) { return v.position.z; });
+				setup.invW = plane(invW[0], invW[1], invW[2]);
+				setup.uOverW = perspective([](const ClipVertex &v) { return v.uv.x; });
+				setup.vOverW = perspective([](const ClipVertex &v) { return v.uv.y; });
+				setup.normalOverW[0] = perspective([](const ClipVertex &v) { return v.normal.x; });
+				setup.normalOverW[1] = perspective([](const ClipVertex &v) { return v.normal.y; });
+				setup.normalOverW[2] = perspective([](const ClipVertex &v) { return v.normal.z; });
+
+				const uint32_t local = static_cast<uint32_t>(chunk.triangles.size());
+				chunk.triangles.push_back(setup);
+				for (int32_t tileY = setup.minY / static_cast<int32_t>(kTileSize); tileY <= setup.maxY / static_cast<int32_t>(kTileSize); ++tileY)
+				{
+					for (int32_t tileX = setup.minX / static_cast<int32_t>(kTileSize); tileX <= setup.maxX / static_cast<int32_t>(kTileSize); ++tileX)
+					{
+						chunk.bins[static_cast<std::size_t>(tileY) * tilesX_ + static_cast<std::size_t>(tileX)].push_back(local);
+					}
+				}
+			}
+		}
+	}
+
+	void SoftwareRasterizer::rasterizeTile(std::size_t tile, const RasterUniforms &uniforms)
+	{
+		const int32_t tileX0 = static_cast<int32_t>((tile % tilesX_) * kTileSize);
+		const int32_t tileY0 = static_cast<int32_t>((tile / tilesX_) * kTileSize);
+		const int32_t tileX1 = std::min(tileX0 + static_cast<int32_t>(kTileSize), static_cast<int32_t>(width_)) - 1;
+		const int32_t tileY1 = std::min(tileY0 + static_cast<int32_t>(kTileSize), static_cast<int32_t>(height_)) - 1;
+
+		alignas(16) float depth[kTileSize * kTileSize];
+		alignas(16) uint32_t ids[kTileSize * kTileSize];
+		std::fill(std::begin(depth), std::end(depth), 1.0f);
+		std::fill(std::begin(ids), std::end(ids), kNoTriangle);
+
+		for (std::size_t chunkIndex = 0; chunkIndex < chunkCount_; ++chunkIndex)
+		{
+			const Chunk &chunk = chunks_[chunkIndex];
+			for (uint32_t local : chunk.bins[tile])
+			{
+				const Triangle &triangle = chunk.triangles[local];
+				const int32_t x0 = std::max(tileX0, triangle.minX);
+				const int32_t x1 = std::min(tileX1, triangle.maxX);
+				const int32_t y0 = std::max(tileY0, triangle.minY);
+				const int32_t y1 = std::min(tileY1, triangle.maxY);
+
+				// Per edge over this rectangle: skip the triangle when one
+				// edge is negative everywhere, and drop edges that are
+				// non-negative everywhere. The rest change sign inside the
+				// rectangle, which bounds them to 32 bits.
+				int32_t edgeStart[3];
+				int32_t edgeDx[3];
+				int32_t edgeDy[3];
+				bool rejected = false;
+				for (std::size_t edge = 0; edge < 3U && !rejected; ++edge)
+				{
+					const int64_t start = triangle.edgeOrigin[edge] +
+										  static_cast<int64_t>(triangle.edgeDx[edge]) * (x0 - triangle.minX) +
+										  static_cast<int64_t>(triangle.edgeDy[edge]) * (y0 - triangle.minY);
+					const int64_t spanX = static_cast<int64_t>(triangle.edgeDx[edge]) * (x1 - x0);
+					const int64_t spanY = static_cast<int64_t>(triangle.edgeDy[edge]) * (y1 - y0);
+					const int64_t lowest = start + std::min<int64_t>(spanX, 0) + std::min<int64_t>(spanY, 0);
+					const int64_t highest = start + std::max<int64_t>(spanX, 0) + std::max<int64_t>(spanY, 0);
+					if (highest < 0)
+					{
+						rejected = true;
+					}
+					else if (lowest >= 0)
+					{
+						edgeStart[edge] = 0;
+						edgeDx[edge] = 0;
+						edgeDy[edge] = 0;
+					}
+					else
+					{
+						edgeStart[edge] = static_cast<int32_t>(start);
+						edgeDx[edge] = triangle.edgeDx[edge];
+						edgeDy[edge] = triangle.edgeDy[edge];
+					}
+				}
+				if (rejected)
+				{
+					continue;
+				}
+
+				const uint32_t id = static_cast<uint32_t>(chunkIndex << 16U) | local;
+				const Plane &z = triangle.depth;
+#if defined(SCOP_RASTER_SSE)
+				// Groups start on a multiple of 4 from the tile origin, so the
+				// loads stay aligned; lanes outside [x0, x1] are masked.
+				const int32_t groupX0 = tileX0 + ((x0 - tileX0) & ~3);
+				const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+				const __m128i lowLimit = _mm_set1_epi32(x0 - 1);
+				const __m128i highLimit = _mm_set1_epi32(x1 + 1);
+				const __m128i idVector = _mm_set1_epi32(static_cast<int>(id));
+				const __m128 zDx = _mm_set1_ps(z.dx);
+				__m128i edgeSteps[3];
+				__m128i edgeLanes[3];
+				for (std::size_t edge = 0; edge < 3U; ++edge)
+				{
+					edgeSteps[edge] = _mm_set1_epi32(edgeDx[edge] * 4);
+					edgeLanes[edge] = _mm_setr_epi32(0, edgeDx[edge], edgeDx[edge] * 2, edgeDx[edge] * 3);
+				}
+				for (int32_t y = y0; y <= y1; ++y)
+				{
+					const int32_t rowOffset = y - y0;
+					__m128i edges[3];
+					for (std::size_t edge = 0; edge < 3U; ++edge)
+					{
+						const int32_t rowStart = edgeStart[edge] + edgeDy[edge] * rowOffset + edgeDx[edge] * (groupX0 - x0);
+						edges[edge] = _mm_add_epi32(_mm_set1_epi32(rowStart), edgeLanes[edge]);
+					}
+					const __m128 zRow = _mm_set1_ps(z.origin + z.dy * static_cast<float>(y - triangle.minY));
+					float *depthRow = depth + (y - tileY0) * static_cast<int32_t>(kTileSize);
+					uint32_t *idRow = ids + (y - tileY0) * static_cast<int32_t>(kTileSize);
+					for (int32_t x = groupX0; x <= x1; x += 4)
+					{
+						const __m128i xs = _mm_add_epi32(_mm_set1_epi32(x), laneOffsets);
+						const __m128i inRange = _mm_and_si128(_mm_cmpgt_epi32(xs, lowLimit), _mm_cmplt_epi32(xs, highLimit));
+						const __m128i signs = _mm_or_si128(_mm_or_si128(edges[0], edges[1]), edges[2]);
+						const __m128i covered = _mm_and_si128(inRange, _mm_cmpgt_epi32(signs, _mm_set1_epi32(-1)));
+						edges[0] = _mm_add_epi32(edges[0], edgeSteps[0]);
+						edges[1] = _mm_add_epi32(edges[1], edgeSteps[1]);
+						edges[2] = _mm_add_epi32(edges[2], edgeSteps[2]);
+						if (_mm_movemask_epi8(covered) == 0)
+						{
+							continue;
+						}
+
+						const __m128 zs = _mm_add_ps(zRow, _mm_mul_ps(zDx, _mm_cvtepi32_ps(_mm_sub_epi32(xs, _mm_set1_epi32(triangle.minX)))));
+						float *depthGroup = depthRow + (x - tileX0);
+						const __m128 stored = _mm_load_ps(depthGroup);
+						const __m128 pass = _mm_and_ps(_mm_castsi128_ps(covered), _mm_cmplt_ps(zs, stored));
+						if (_mm_movemask_ps(pass) == 0)
+						{
+							continue;
+						}
+						_mm_store_ps(depthGroup, _mm_or_ps(_mm_and_ps(pass, zs), _mm_andnot_ps(pass, stored)));
+						__m128i *idGroup = reinterpret_cast<__m128i *>(idRow + (x - tileX0));
+						const __m128i passMask = _mm_castps_si128(pass);
+						_mm_store_si128(idGroup, _mm_or_si128(_mm_and_si128(passMask, idVector), _mm_andnot_si128(passMask, _mm_load_si128(idGroup))));
+					}
+				}
+#else
+				for (int32_t y = y0; y <= y1; ++y)
+				{
+					const int32_t rowOffset = y - y0;
+					int32_t edges[3];
+					for (std::size_t edge = 0; edge < 3U; ++edge)
+					{
+						edges[edge] = edgeStart[edge] + edgeDy[edge] * rowOffset;
+					}
+					const float zRow = z.origin + z.dy * static_cast<float>(y - triangle.minY);
+					float *depthRow = depth + (y - tileY0) * static_cast<int32_t>(kTileSize);
+					uint32_t *idRow = ids + (y - tileY0) * static_cast<int32_t>(kTileSize);
+					for (int32_t x = x0; x <= x1; ++x)
+					{
+						if ((edges[0] | edges[1] | edges[2]) >= 0)
+						{
+							const float value = zRow + z.dx * static_cast<float>(x - triangle.minX);
+							if (value < depthRow[x - tileX0])
+							{
+								depthRow[x - tileX0] = value;
+								idRow[x - tileX0] = id;
+							}
+						}
+						edges[0] += edgeDx[0];
+						edges[1] += edgeDx[1];
+						edges[2] += edgeDx[2];
+					}
+				}
+#endif
+			}
+		}
+
+		// mesh.frag, once per visible pixel.
+		const Vec3 light = normalize(Vec3(0.45f, 0.85f, 0.35f));
+		const float blend = std::clamp(uniforms.blend, 0.0f, 1.0f);
+		const float shininess = std::max(uniforms.ns, 1.0f);
+		const bool textured = uniforms.textured && !texels_.empty();
+		const std::uint8_t clear[3] = {encodeChannel(kClearColor.x, srgbOutput_), encodeChannel(kClearColor.y, srgbOutput_),
+									   encodeChannel(kClearColor.z, srgbOutput_)};
+		for (int32_t y = tileY0; y <= tileY1; ++y)
+		{
+			const uint32_t *idRow = ids + (y - tileY0) * static_cast<int32_t>(kTileSize);
+			std::uint8_t *out = pixels_.data() + (static_cast<std::size_t>(y) * width_ + static_cast<std::size_t>(tileX0)) * 4U;
+			for (int32_t x = tileX0; x <= tileX1; ++x, out += 4)
+			{
+				const uint32_t id = idRow[x - tileX0];
+				if (id == kNoTriangle)
+				{
+					out[0] = clear[0];
+					out[1] = clear[1];
+					out[2] = clear[2];
+					out[3] = 255U;
+					continue;
+				}
+
+				const Triangle &triangle = chunks_[id >> 16U].triangles[id & 0xFFFFU];
+				const float px = static_cast<float>(x - triangle.minX);
+				const float py = static_cast<float>(y - triangle.minY);
+				const auto at = [px, py](const Plane &plane) { return plane.origin + plane.dx * px + plane.dy * py; };
+				const float w = 1.0f / at(triangle.invW);
+
+				const Vec3 normal = normalize(Vec3(at(triangle.normalOverW[0]), at(triangle.normalOverW[1]), at(triangle.normalOverW[2])) * w);
+				const float lightDot = dot(normal, light);
+				const float diffuse = std::max(lightDot, 0.0f);
+				// reflect(-L, N).z, with V = +Z.
+				const float reflectedZ = 2.0f * lightDot * normal.z - light.z;
+				const float specular = std::pow(std::max(reflectedZ, 0.0f), shininess);
+
+				Vec3 target(1.0f, 1.0f, 1.0f);
+				if (textured)
+				{
+					float u = at(triangle.uOverW) * w;
+					float v = at(triangle.vOverW) * w;
+					u = (u - std::floor(u)) * static_cast<float>(textureWidth_) - 0.5f;
+					v = (v - std::floor(v)) * static_cast<float>(textureHeight_) - 0.5f;
+					const float cellX = std::floor(u);
+					const float cellY = std::floor(v);
+					const float fx = u - cellX;
+					const float fy = v - cellY;
+					// Repeat addressing on both neighbours.
+					const auto wrap = [](float cell, uint32_t size)
+					{
+						const int32_t value = static_cast<int32_t>(cell);
+						return static_cast<std::size_t>(value < 0 ? value + static_cast<int32_t>(size) : value % static_cast<int32_t>(size));
+					};
+					const std::size_t left = wrap(cellX, textureWidth_);
+					const std::size_t right = wrap(cellX + 1.0f, textureWidth_);
+					const std::size_t top = wrap(cellY, textureHeight_);
+					const std::size_t bottom = wrap(cellY + 1.0f, textureHeight_);
+					const auto texel = [this](std::size_t column, std::size_t row)
+					{
+						const float *t = texels_.data() + (row * textureWidth_ + column) * 3U;
+						return Vec3(t[0], t[1], t[2]);
+					};
+					const Vec3 upper = texel(left, top) * (1.0f - fx) + texel(right, top) * fx;
+					const Vec3 lower = texel(left, bottom) * (1.0f - fx) + texel(right, bottom) * fx;
+					target = upper * (1.0f - fy) + lower * fy;
+				}
+				else if (uniforms.material)
+				{
+					target = uniforms.kd;
+				}
+
+				const Vec3 base = Vec3(1.0f, 1.0f, 1.0f) * (1.0f - blend) + target * blend;
+				const float shade = 0.55f + 0.45f * diffuse;
+				const Vec3 color = base * shade + uniforms.ks * (specular * 0.18f);
+				out[0] = encodeChannel(color.x, srgbOutput_);
+				out[1] = encodeChannel(color.y, srgbOutput_);
+				out[2] = encodeChannel(color.z, srgbOutput_);
+				out[3] = 255U;
+			}
+		}
+	}
+
+} // namespace scop
@@ -1,5 +1,7 @@
 #include "TextureLoader.hpp"
 
+#include "Profiler.hpp"
+
 #include <cctype>
 #include <fstream>
 #include <stdexcept>
@@ -51,12 +53,17 @@ namespace scop
 
 	TextureImage TextureLoader::loadPPM(const std::string &path)
 	{
+		SCOP_PROFILE_FUNCTION();
 		std::ifstream file(path.c_str(), std::ios::binary);
 		if (!file)
 		{
 			throw std::runtime_error("Failed to open PPM texture: " + path);
 		}
+		return decodePPM(file, path);
+	}
 
+	TextureImage TextureLoader::decodePPM(std::istream &file, const std::string &path)
+	{
 		const std::string magic = readToken(file);
 		if (magic != "P6" && magic != "P3")
 		{
@@ -78,7 +85,7 @@ namespace scop
 
 		if (magic == "P6")
 		{
-			std::vector<unsigned char> rgb(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 3U);
+			TrackedVector<unsigned char, MemoryTag::Texture> rgb(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 3U);
 			file.read(reinterpret_cast<char *>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
 			if (file.gcount() != static_cast<std::streamsize>(rgb.size()))
 			{
@@ -122,4 +129,36 @@ namespace scop
 		return image;
 	}
 
+	TextureImage TextureLoader::resized(const TextureImage &image, uint32_t width, uint32_t height)
+	{
+		if (image.width == width && image.height == height)
+		{
+			return image;
+		}
+		if (image.empty() || width == 0U || height == 0U)
+		{
+			throw std::runtime_error("Cannot resize an empty texture");
+		}
+
+		TextureImage result;
+		result.width = width;
+		result.height = height;
+		result.pixels.resize(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4U);
+		for (uint32_t y = 0U; y < height; ++y)
+		{
+			const std::size_t sourceY = static_cast<std::size_t>(y) * image.height / height;
+			for (uint32_t x = 0U; x < width; ++x)
+			{
+				const std::size_t sourceX = static_cast<std::size_t>(x) * image.width / width;
+				const std::size_t from = (sourceY * image.width + sourceX) * 4U;
+				const std::size_t to = (static_cast<std::size_t>(y) * width + x) * 4U;
+				for (std::size_t channel = 0U; channel < 4U; ++channel)
+				{
+					result.pixels[to + channel] = image.pixels[from + channel];
+				}
+			}
+		}
+		return result;
+	}
+
 } // namespace scop
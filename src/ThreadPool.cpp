@@ -0,0 +1,149 @@
+#include "ThreadPool.hpp"
+
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <string>
+
+namespace scop
+{
+
+	ThreadPool::ThreadPool(std::size_t workerCount)
+		: stopping_(false)
+	{
+		if (workerCount == 0U)
+		{
+			const unsigned int hardware = std::thread::hardware_concurrency();
+			workerCount = (hardware > 1U) ? hardware - 1U : 1U;
+		}
+		workers_.reserve(workerCount);
+		for (std::size_t i = 0; i < workerCount; ++i)
+		{
+			workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+		}
+		wake_.notify_all();
+		for (std::thread &worker : workers_)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::workerLoop(std::size_t index)
+	{
+		if (Profiler::enabled())
+		{
+			Profiler::setThreadName("worker " + std::to_string(index));
+		}
+		for (;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				wake_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+				if (tasks_.empty())
+				{
+					return;
+				}
+				task = std::move(tasks_.front());
+				tasks_.pop_front();
+			}
+			task();
+		}
+	}
+
+	void ThreadPool::parallelFor(std::size_t count, std::size_t grain,
+								 const std::function<void(std::size_t begin, std::size_t end)> &body)
+	{
+		if (count == 0U)
+		{
+			return;
+		}
+		grain = std::max<std::size_t>(grain, 1U);
+		const std::size_t chunks = (count + grain - 1U) / grain;
+		if (chunks == 1U || workers_.empty())
+		{
+			body(0U, count);
+			return;
+		}
+
+		// Chunks are claimed from a shared counter, so the caller and the
+		// workers balance themselves. The state is shared with the queued
+		// tasks because a worker may only pick its task up after every chunk
+		// is done and this call has returned; such a task finds no chunk left
+		// and never touches body.
+		struct State
+		{
+			std::atomic<std::size_t> nextChunk{0U};
+			std::atomic<std::size_t> remaining{0U};
+			std::mutex mutex;
+			std::condition_variable done;
+			std::exception_ptr failure;
+		};
+		const std::shared_ptr<State> state = std::make_shared<State>();
+		state->remaining.store(chunks);
+		const std::function<void(std::size_t, std::size_t)> *bodyPtr = &body;
+
+		const auto drain = [state, bodyPtr, chunks, grain, count]()
+		{
+			for (std::size_t chunk = state->nextChunk.fetch_add(1U); chunk < chunks; chunk = state->nextChunk.fetch_add(1U))
+			{
+				const std::size_t begin = chunk * grain;
+				try
+				{
+					(*bodyPtr)(begin, std::min(begin + grain, count));
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(state->mutex);
+					if (!state->failure)
+					{
+						state->failure = std::current_exception();
+					}
+				}
+				if (state->remaining.fetch_sub(1U) == 1U)
+				{
+					std::lock_guard<std::mutex> lock(state->mutex);
+					state->done.notify_one();
+				}
+			}
+		};
+
+		const std::size_t helpers = std::min(workers_.size(), chunks - 1U);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (std::size_t i = 0; i < helpers; ++i)
+			{
+				tasks_.push_back(drain);
+			}
+		}
+		if (helpers == 1U)
+		{
+			wake_.notify_one();
+		}
+		else
+		{
+			wake_.notify_all();
+		}
+
+		drain();
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->done.wait(lock, [&state]() { return state->remaining.load() == 0U; });
+
+		if (state->failure)
+		{
+			std::rethrow_exception(state->failure);
+		}
+	}
+
+} // namespace scop
@@ -0,0 +1,429 @@
+#include "UploadBatcher.hpp"
+
+#include "Profiler.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace scop
+{
+	namespace
+	{
+
+		VkCommandPool createPool(VkDevice device, uint32_t family)
+		{
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			poolInfo.queueFamilyIndex = family;
+
+			VkCommandPool pool = VK_NULL_HANDLE;
+			if (vkCreateCommandPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create upload command pool");
+			}
+			return pool;
+		}
+
+		VkCommandBuffer allocateCommandBuffer(VkDevice device, VkCommandPool pool)
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = pool;
+			allocInfo.commandBufferCount = 1U;
+
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate upload command buffer");
+			}
+			return commandBuffer;
+		}
+
+		void beginOneTime(VkCommandBuffer commandBuffer)
+		{
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to begin upload command buffer");
+			}
+		}
+
+		VkImageMemoryBarrier colorImageBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
+		{
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = oldLayout;
+			barrier.newLayout = newLayout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.baseMipLevel = 0U;
+			barrier.subresourceRange.levelCount = 1U;
+			barrier.subresourceRange.baseArrayLayer = 0U;
+			barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+			return barrier;
+		}
+
+		VkBufferMemoryBarrier wholeBufferBarrier(VkBuffer buffer)
+		{
+			VkBufferMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.buffer = buffer;
+			barrier.offset = 0U;
+			barrier.size = VK_WHOLE_SIZE;
+			return barrier;
+		}
+
+	} // namespace
+
+	UploadBatcher::UploadBatcher()
+		: device_(VK_NULL_HANDLE),
+		  allocator_(nullptr),
+		  graphicsFamily_(0U),
+		  transferFamily_(0U),
+		  graphicsQueue_(VK_NULL_HANDLE),
+		  transferQueue_(VK_NULL_HANDLE),
+		  transferPool_(VK_NULL_HANDLE),
+		  graphicsPool_(VK_NULL_HANDLE),
+		  transferCommands_(VK_NULL_HANDLE),
+		  acquireCommands_(VK_NULL_HANDLE),
+		  transferDone_(VK_NULL_HANDLE),
+		  fence_(VK_NULL_HANDLE),
+		  recording_(false) {}
+
+	UploadBatcher::~UploadBatcher()
+	{
+		shutdown();
+	}
+
+	void UploadBatcher::init(VkDevice device, GpuAllocator &allocator,
+							 uint32_t graphicsFamily, VkQueue graphicsQueue,
+							 uint32_t transferFamily, VkQueue transferQueue)
+	{
+		device_ = device;
+		allocator_ = &allocator;
+		graphicsFamily_ = graphicsFamily;
+		graphicsQueue_ = graphicsQueue;
+		transferFamily_ = transferFamily;
+		transferQueue_ = transferQueue;
+
+		transferPool_ = createPool(device_, transferFamily_);
+		transferCommands_ = allocateCommandBuffer(device_, transferPool_);
+		if (usesTransferQueue())
+		{
+			graphicsPool_ = createPool(device_, graphicsFamily_);
+			acquireCommands_ = allocateCommandBuffer(device_, graphicsPool_);
+
+			VkSemaphoreCreateInfo semaphoreInfo{};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			if (vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &transferDone_) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create upload semaphore");
+			}
+		}
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		if (vkCreateFence(device_, &fenceInfo, nullptr, &fence_) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create upload fence");
+		}
+	}
+
+	void UploadBatcher::shutdown()
+	{
+		if (device_ == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		if (recording_)
+		{
+			vkEndCommandBuffer(transferCommands_);
+			recording_ = false;
+		}
+		wait();
+		for (Staging &staging : recorded_)
+		{
+			vkDestroyBuffer(device_, staging.buffer, nullptr);
+			allocator_->free(staging.allocation);
+		}
+		recorded_.clear();
+
+		if (fence_ != VK_NULL_HANDLE)
+		{
+			vkDestroyFence(device_, fence_, nullptr);
+			fence_ = VK_NULL_HANDLE;
+		}
+		if (transferDone_ != VK_NULL_HANDLE)
+		{
+			vkDestroySemaphore(device_, transferDone_, nullptr);
+			transferDone_ = VK_NULL_HANDLE;
+		}
+		if (graphicsPool_ != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(device_, graphicsPool_, nullptr);
+			graphicsPool_ = VK_NULL_HANDLE;
+		}
+		if (transferPool_ != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(device_, transferPool_, nullptr);
+			transferPool_ = VK_NULL_HANDLE;
+		}
+		transferCommands_ = VK_NULL_HANDLE;
+		acquireCommands_ = VK_NULL_HANDLE;
+		device_ = VK_NULL_HANDLE;
+	}
+
+	void UploadBatcher::begin()
+	{
+		if (recording_)
+		{
+			return;
+		}
+		wait();
+		beginOneTime(transferCommands_);
+		recording_ = true;
+	}
+
+	UploadBatcher::Staging UploadBatcher::createStaging(const void *data, VkDeviceSize size)
+	{
+		Staging staging{};
+
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (vkCreateBuffer(device_, &bufferInfo, nullptr, &staging.buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create staging buffer");
+		}
+
+		VkMemoryRequirements memRequirements{};
+		vkGetBufferMemoryRequirements(device_, staging.buffer, &memRequirements);
+		staging.allocation = allocator_->allocate(memRequirements,
+												  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+												  GpuMemoryPool::Staging, GpuResourceKind::Linear);
+		if (vkBindBufferMemory(device_, staging.buffer, staging.allocation.memory, staging.allocation.offset) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to bind staging buffer memory");
+		}
+		std::memcpy(staging.allocation.mapped, data, static_cast<std::size_t>(size));
+
+		recorded_.push_back(staging);
+		return staging;
+	}
+
+	void UploadBatcher::uploadBuffer(const void *data, VkDeviceSize size, VkBuffer dst,
+									 VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		begin();
+		const Staging staging = createStaging(data, size);
+
+		VkBufferCopy copyRegion{};
+		copyRegion.size = size;
+		vkCmdCopyBuffer(transferCommands_, staging.buffer, dst, 1U, &copyRegion);
+
+		VkBufferMemoryBarrier barrier = wholeBufferBarrier(dst);
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		if (usesTransferQueue())
+		{
+			barrier.dstAccessMask = 0;
+			barrier.srcQueueFamilyIndex = transferFamily_;
+			barrier.dstQueueFamilyIndex = graphicsFamily_;
+			vkCmdPipelineBarrier(transferCommands_, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+								 0, 0, nullptr, 1U, &barrier, 0, nullptr);
+			bufferAcquires_.push_back({dst, dstStage, dstAccess});
+		}
+		else
+		{
+			barrier.dstAccessMask = dstAccess;
+			vkCmdPipelineBarrier(transferCommands_, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage,
+								 0, 0, nullptr, 1U, &barrier, 0, nullptr);
+		}
+	}
+
+	void UploadBatcher::uploadImage(const void *data, VkDeviceSize size, VkImage dst, uint32_t width, uint32_t height,
+									uint32_t layerCount, VkPipelineStageFlags dstStage)
+	{
+		begin();
+		const Staging staging = createStaging(data, size);
+
+		VkImageMemoryBarrier toTransfer = colorImageBarrier(dst, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		toTransfer.srcAccessMask = 0;
+		toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(transferCommands_, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+							 0, 0, nullptr, 0, nullptr, 1U, &toTransfer);
+
+		VkBufferImageCopy region{};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0U;
+		region.imageSubresource.baseArrayLayer = 0U;
+		region.imageSubresource.layerCount = layerCount;
+		region.imageOffset = {0, 0, 0};
+		region.imageExtent = {width, height, 1U};
+		vkCmdCopyBufferToImage(transferCommands_, staging.buffer, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1U, &region);
+
+		VkImageMemoryBarrier toShader = colorImageBarrier(dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		toShader.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		if (usesTransferQueue())
+		{
+			toShader.dstAccessMask = 0;
+			toShader.srcQueueFamilyIndex = transferFamily_;
+			toShader.dstQueueFamilyIndex = graphicsFamily_;
+			vkCmdPipelineBarrier(transferCommands_, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+								 0, 0, nullptr, 0, nullptr, 1U, &toShader);
+			imageAcquires_.push_back({dst, dstStage});
+		}
+		else
+		{
+			toShader.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(transferCommands_, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage,
+								 0, 0, nullptr, 0, nullptr, 1U, &toShader);
+		}
+	}
+
+	void UploadBatcher::submit()
+	{
+		SCOP_PROFILE_FUNCTION();
+		if (!recording_)
+		{
+			return;
+		}
+		if (vkEndCommandBuffer(transferCommands_) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record upload command buffer");
+		}
+		recording_ = false;
+
+		VkSubmitInfo transferSubmit{};
+		transferSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		transferSubmit.commandBufferCount = 1U;
+		transferSubmit.pCommandBuffers = &transferCommands_;
+
+		if (!usesTransferQueue())
+		{
+			if (vkQueueSubmit(graphicsQueue_, 1U, &transferSubmit, fence_) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to submit upload batch");
+			}
+		}
+		else
+		{
+			// The acquire half of each ownership transfer runs on the graphics
+			// queue, after the transfer queue signals the semaphore. Frames
+			// submitted later on the graphics queue are ordered behind it.
+			VkPipelineStageFlags waitStage = 0;
+			std::vector<VkBufferMemoryBarrier> bufferBarriers;
+			std::vector<VkImageMemoryBarrier> imageBarriers;
+			for (const BufferAcquire &acquire : bufferAcquires_)
+			{
+				VkBufferMemoryBarrier barrier = wholeBufferBarrier(acquire.buffer);
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = acquire.dstAccess;
+				barrier.srcQueueFamilyIndex = transferFamily_;
+				barrier.dstQueueFamilyIndex = graphicsFamily_;
+				bufferBarriers.push_back(barrier);
+				waitStage |= acquire.dstStage;
+			}
+			for (const ImageAcquire &acquire : imageAcquires_)
+			{
+				VkImageMemoryBarrier barrier = colorImageBarrier(acquire.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				barrier.srcQueueFamilyIndex = transferFamily_;
+				barrier.dstQueueFamilyIndex = graphicsFamily_;
+				imageBarriers.push_back(barrier);
+				waitStage |= acquire.dstStage;
+			}
+			bufferAcquires_.clear();
+			imageAcquires_.clear();
+			if (waitStage == 0)
+			{
+				waitStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			}
+
+			beginOneTime(acquireCommands_);
+			vkCmdPipelineBarrier(acquireCommands_, waitStage, waitStage, 0, 0, nullptr,
+								 static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+								 static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+			if (vkEndCommandBuffer(acquireCommands_) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to record upload acquire command buffer");
+			}
+
+			transferSubmit.signalSemaphoreCount = 1U;
+			transferSubmit.pSignalSemaphores = &transferDone_;
+			if (vkQueueSubmit(transferQueue_, 1U, &transferSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to submit upload batch");
+			}
+
+			VkSubmitInfo acquireSubmit{};
+			acquireSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			acquireSubmit.waitSemaphoreCount = 1U;
+			acquireSubmit.pWaitSemaphores = &transferDone_;
+			acquireSubmit.pWaitDstStageMask = &waitStage;
+			acquireSubmit.commandBufferCount = 1U;
+			acquireSubmit.pCommandBuffers = &acquireCommands_;
+			if (vkQueueSubmit(graphicsQueue_, 1U, &acquireSubmit, fence_) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to submit upload acquire");
+			}
+		}
+
+		inFlight_.insert(inFlight_.end(), recorded_.begin(), recorded_.end());
+		recorded_.clear();
+	}
+
+	bool UploadBatcher::collect()
+	{
+		if (inFlight_.empty())
+		{
+			return true;
+		}
+		if (vkGetFenceStatus(device_, fence_) != VK_SUCCESS)
+		{
+			return false;
+		}
+		releaseStaging();
+		return true;
+	}
+
+	void UploadBatcher::wait()
+	{
+		if (inFlight_.empty())
+		{
+			return;
+		}
+		vkWaitForFences(device_, 1U, &fence_, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		releaseStaging();
+	}
+
+	void UploadBatcher::releaseStaging()
+	{
+		for (Staging &staging : inFlight_)
+		{
+			vkDestroyBuffer(device_, staging.buffer, nullptr);
+			allocator_->free(staging.allocation);
+		}
+		inFlight_.clear();
+
+		vkResetFences(device_, 1U, &fence_);
+		vkResetCommandPool(device_, transferPool_, 0);
+		if (graphicsPool_ != VK_NULL_HANDLE)
+		{
+			vkResetCommandPool(device_, graphicsPool_, 0);
+		}
+	}
+
+} // namespace scop
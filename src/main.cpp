@@ -1,4 +1,6 @@
 #include "App.hpp"
+#include "Profiler.hpp"
+#include "SoftwareApp.hpp"
 
 #include <cctype>
 #include <fstream>
@@ -190,12 +192,33 @@ namespace
 
 int main(int argc, char **argv)
 {
+	scop::AppOptions options;
 	try
 	{
-		const std::string modelPath = (argc > 1) ? argv[1] : "assets/demo_cube.obj";
-		const std::string explicitTexturePath = (argc > 2) ? argv[2] : "";
+		options = scop::AppOptions::parse(argc, argv);
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "Error: " << e.what() << '\n';
+		scop::AppOptions::printUsage(argv[0]);
+		return 1;
+	}
+
+	if (!options.tracePath.empty())
+	{
+		scop::Profiler::enable();
+		scop::Profiler::setThreadName("main");
+	}
+
+	try
+	{
+		const std::string explicitTexturePath = options.texturePath;
 
-		std::string texturePath = resolveTexturePath(modelPath, explicitTexturePath);
+		// Scene placements name their own textures, so only an explicit one
+		// is used as the default there.
+		std::string texturePath = options.scenePath.empty()
+									  ? resolveTexturePath(options.modelPaths.front(), explicitTexturePath)
+									  : explicitTexturePath;
 
 		if (!explicitTexturePath.empty())
 		{
@@ -210,8 +233,22 @@ int main(int argc, char **argv)
 			std::cout << "No explicit texture or usable MTL texture found.\n";
 		}
 
-		scop::ScopApp app;
-		app.run(modelPath, texturePath);
+		if (options.backend == scop::RenderBackend::Software)
+		{
+			scop::SoftwareApp app(options);
+			app.run(options.modelPaths, texturePath);
+		}
+		else
+		{
+			scop::ScopApp app(options);
+			app.run(options.modelPaths, texturePath);
+		}
+
+		if (!options.tracePath.empty())
+		{
+			scop::Profiler::writeChromeTrace(options.tracePath);
+			std::cout << "Wrote CPU trace to " << options.tracePath << '\n';
+		}
 		return 0;
 	}
 	catch (const std::exception &e)
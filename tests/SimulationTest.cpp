@@ -0,0 +1,80 @@
+// Checks that Simulation::sample() only reports a settled frame once the
+// frame shows the final state: a texture toggle is run to rest on the
+// simulation thread while frames are sampled at the start of each step
+// (t = 0) and past its end (t = 1).
+
+#include "Simulation.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+
+	using scop::Simulation;
+	using scop::SimulationFrame;
+
+	bool checkFrame(const SimulationFrame &frame, const char *when)
+	{
+		if (frame.settled && frame.state.textureBlend != frame.state.targetTextureBlend)
+		{
+			std::fprintf(stderr, "simulation: settled frame sampled %s shows blend %.4f of %.4f\n", when,
+						 static_cast<double>(frame.state.textureBlend), static_cast<double>(frame.state.targetTextureBlend));
+			return false;
+		}
+		return true;
+	}
+
+	bool toggleSettlesAtFinalBlend()
+	{
+		scop::SimulationState state{};
+		state.rotationPaused = true;
+		scop::SimulationSettings settings{};
+		settings.canBlend = true;
+		settings.hasTexture = true;
+		settings.pauseInstances = true;
+
+		Simulation simulation;
+		simulation.reset(state, settings);
+		const Simulation::Clock::time_point stepStart = Simulation::Clock::now();
+		simulation.start();
+
+		scop::SimulationInput input{};
+		input.togglePresses = 1U;
+		simulation.submitInput(input);
+
+		// The blend takes 0.4 s; give it ten times that before failing.
+		const Simulation::Clock::time_point deadline = stepStart + std::chrono::seconds(4);
+		bool settledEarly = false;
+		bool settledLate = false;
+		while (!(settledEarly && settledLate))
+		{
+			const Simulation::Clock::time_point now = Simulation::Clock::now();
+			if (now > deadline)
+			{
+				std::fprintf(stderr, "simulation: the toggle never settled\n");
+				return false;
+			}
+			const SimulationFrame early = simulation.sample(stepStart);
+			const SimulationFrame late = simulation.sample(now + std::chrono::seconds(1));
+			if (!checkFrame(early, "mid-step") || !checkFrame(late, "after the step"))
+			{
+				return false;
+			}
+			settledEarly = early.settled;
+			settledLate = late.settled;
+		}
+		return true;
+	}
+
+} // namespace
+
+int main()
+{
+	if (!toggleSettlesAtFinalBlend())
+	{
+		return 1;
+	}
+	std::printf("simulation: ok\n");
+	return 0;
+}